@@ -0,0 +1,138 @@
+`timescale 1ns / 1ps
+/*
+----------------------------------------------------------------------------------
+--  Description : AXI-Stream traffic end for the raw DMA bandwidth benchmark
+--	(lab3/srcs/dma/c/dmabench.h), put in place of myip_v1_0 behind an AXI DMA.
+--	Bits [31:30] of the first beat of a packet select what is done with it:
+--	  0 LOOP    the packet, first beat included, is sent back on M_AXIS as it came
+--	  1 SINK    the packet is taken at one beat per cycle and dropped (3 as well)
+--	  2 SOURCE  once the packet is in, packets = [15:0] packets of beats = [29:16]
+--	            beats each are sent on M_AXIS, a running beat count in every
+--	            32 bits of TDATA, TLAST on the last beat of each; S_AXIS_TREADY
+--	            stays low until the last one is out
+--	A two-entry buffer sits between the slave and the master side, so a
+--	packet loops through at one beat per cycle with S_AXIS_TREADY registered.
+----------------------------------------------------------------------------------
+*/
+
+module axis_loopback
+# (
+	parameter width = 32		// TDATA bits, 32, 64 or 128 as the DMA stream width
+)
+(
+	input						ACLK,
+	input						ARESETN,
+	// slave in interface
+	output	wire				S_AXIS_TREADY,
+	input		[width-1 : 0]	S_AXIS_TDATA,
+	input						S_AXIS_TLAST,
+	input						S_AXIS_TVALID,
+	// master out interface
+	output	wire				M_AXIS_TVALID,
+	output	wire [width-1 : 0]	M_AXIS_TDATA,
+	output	wire				M_AXIS_TLAST,
+	input						M_AXIS_TREADY
+);
+
+	localparam LOOP    = 2'd0;
+	localparam SINK    = 2'd1;
+	localparam SOURCE  = 2'd2;
+
+	// State of the packet being taken, or of the packets being sent
+	localparam IDLE        = 3'd0;
+	localparam IN_LOOP     = 3'd1;
+	localparam IN_SINK     = 3'd2;
+	localparam IN_SOURCE   = 3'd3;		// rest of a SOURCE command packet
+	localparam SEND        = 3'd4;
+	reg [2:0] state;
+
+	// Two-entry buffer in front of M_AXIS
+	reg 	[width-1:0]		buffer_data [0:1];
+	reg 					buffer_last [0:1];
+	reg 					write_ptr;
+	reg 					read_ptr;
+	reg 	[1:0]			count;
+
+	reg 	[13:0]			packet_beats;
+	reg 	[15:0]			packets;
+	reg 	[13:0]			beat;
+	reg 	[15:0]			packet;
+	reg 	[31:0]			running_count;
+
+	wire 	[1:0]			command = S_AXIS_TDATA[31:30];
+	wire 					in_fire = S_AXIS_TVALID & S_AXIS_TREADY;
+	wire 					out_fire = M_AXIS_TVALID & M_AXIS_TREADY;
+	wire 					in_loop = (state == IN_LOOP) | ((state == IDLE) & (command == LOOP));
+	wire 					send_fire = (state == SEND) & ((count != 2'd2) | out_fire);
+	wire 					send_last = beat == packet_beats - 1'b1;
+	wire 					push = (in_fire & in_loop) | send_fire;
+
+	assign S_AXIS_TREADY = (state != SEND) & (count != 2'd2);
+	assign M_AXIS_TVALID = count != 2'd0;
+	assign M_AXIS_TDATA  = buffer_data[read_ptr];
+	assign M_AXIS_TLAST  = buffer_last[read_ptr];
+
+	always_ff @(posedge ACLK) begin
+		if (push)
+		begin
+			buffer_data[write_ptr] 	<= send_fire ? {(width / 32){running_count}} : S_AXIS_TDATA;
+			buffer_last[write_ptr] 	<= send_fire ? send_last : S_AXIS_TLAST;
+		end
+	end
+
+	always_ff @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			state 			<= IDLE;
+			write_ptr 		<= 1'b0;
+			read_ptr 		<= 1'b0;
+			count 			<= 2'd0;
+			packet_beats 	<= 14'd0;
+			packets 		<= 16'd0;
+			beat 			<= 14'd0;
+			packet 			<= 16'd0;
+			running_count 	<= 32'd0;
+		end
+		else
+		begin
+			if (push) write_ptr <= ~write_ptr;
+			if (out_fire) read_ptr <= ~read_ptr;
+			count <= count + push - out_fire;
+
+			if (in_fire)
+			begin
+				if (state == IDLE)
+				begin
+					if (command == SOURCE)
+					begin
+						packet_beats 	<= S_AXIS_TDATA[29:16];
+						packets 		<= S_AXIS_TDATA[15:0];
+					end
+					if (~S_AXIS_TLAST)
+						state <= (command == LOOP) ? IN_LOOP : (command == SOURCE) ? IN_SOURCE : IN_SINK;
+					else if (command == SOURCE && S_AXIS_TDATA[29:16] != 0 && S_AXIS_TDATA[15:0] != 0)
+						state <= SEND;
+				end
+				else if (S_AXIS_TLAST)
+					state <= (state == IN_SOURCE && packet_beats != 0 && packets != 0) ? SEND : IDLE;
+			end
+
+			if (send_fire)
+			begin
+				running_count <= running_count + 1'b1;
+				if (send_last)
+				begin
+					beat <= 14'd0;
+					if (packet == packets - 1'b1)
+					begin
+						packet 	<= 16'd0;
+						state 	<= IDLE;
+					end
+					else packet <= packet + 1'b1;
+				end
+				else beat <= beat + 1'b1;
+			end
+		end
+	end
+
+endmodule
@@ -21,7 +21,9 @@ module matrix_multiply
 	parameter width = 8, 			// width is the number of bits per location
 	parameter A_depth_bits = 3, 	// depth is the number of locations (2^number of address bits)
 	parameter B_depth_bits = 2,
-	parameter RES_depth_bits = 1
+	parameter RES_depth_bits = 1,
+	parameter sparse = 0,			// 1: A_RAM holds the packed non-zeros of A, {end of row, column, value}
+	localparam A_width = sparse ? width + B_depth_bits + 1 : width
 )
 (
 	input                           clk,                        // Clock signal
@@ -33,9 +35,9 @@ module matrix_multiply
 	output wire                     B_read_en,                  // matrix_multiply_0 -> B_RAM
 
 	output reg [A_depth_bits-1:0]   A_read_address,             // matrgix_multiply_0 -> A_RAM
-	input      [width-1:0]          A_read_data_out,            // A_RAM -> matrix_multiply_0
+	input      [A_width-1:0]        A_read_data_out,            // A_RAM -> matrix_multiply_0
 
-	output reg [B_depth_bits-1:0]   B_read_address,             // matrix_multiply_0 -> B_RAM
+	output wire [B_depth_bits-1:0]  B_read_address,             // matrix_multiply_0 -> B_RAM
 	input      [width-1:0]          B_read_data_out,            // B_RAM -> matrix_multiply_0
 
 	output reg                      RES_write_en,               // matrix_multiply_0 -> RES_RAM
@@ -58,6 +60,18 @@ module matrix_multiply
 
 	reg 					AB_read_en;
 	reg 					AB_read_en_dly;
+	reg [B_depth_bits-1:0]	B_index;
+
+	// Sparse mode: every A entry carries the B address of its product, so B is read one cycle
+	// after A and the product goes to the MAC one cycle later than in dense mode. The end of a row
+	// is only seen once its last entry has been read, by then the next entry is already being read:
+	// that read is dropped (iter_end) and issued again as the first one of the next row.
+	wire 					A_valid = sparse ? (AB_read_en_dly & ~iter_end) : AB_read_en_dly;
+	wire 					A_eor = A_read_data_out[A_width-1];
+	reg 					A_valid_dly;
+	reg 	[width-1:0]		A_value_dly;
+	wire 					mac_feed = sparse ? A_valid_dly : AB_read_en_dly;
+	wire 	[width-1:0]		mac_feed_a = sparse ? A_value_dly : A_read_data_out[width-1:0];
 
 	// MAC module wires
 	reg mac_en;
@@ -68,7 +82,16 @@ module matrix_multiply
 	wire mac_done;
 
 	assign A_read_en = AB_read_en;
-	assign B_read_en = AB_read_en;
+	assign B_read_en = sparse ? A_valid : AB_read_en;
+
+	generate
+		if (sparse) begin : sparse_b_address
+			assign B_read_address = A_read_data_out[width +: B_depth_bits];
+		end
+		else begin : dense_b_address
+			assign B_read_address = B_index;
+		end
+	endgenerate
 
 	// One-hot encoded states
 	localparam IDLE      = 2'b01;
@@ -83,6 +106,8 @@ module matrix_multiply
 			mac_b 		<= {width{1'b0}};
 
 			AB_read_en_dly <= 1'b0;
+			A_valid_dly 	<= 1'b0;
+			A_value_dly 	<= {width{1'b0}};
 		end
 		else
 		begin
@@ -90,12 +115,14 @@ module matrix_multiply
 			mac_clear 	<= 1'b1;
 
 			AB_read_en_dly <= AB_read_en;
+			A_valid_dly 	<= A_valid;
+			A_value_dly 	<= A_read_data_out[width-1:0];
 
-			if (AB_read_en_dly)
+			if (mac_feed)
 			begin
 				mac_en 		<= 1'b1;
 				mac_clear 	<= 1'b0;
-				mac_a 		<= A_read_data_out;
+				mac_a 		<= mac_feed_a;
 				mac_b 		<= B_read_data_out;
 			end
 		end
@@ -107,7 +134,7 @@ module matrix_multiply
 			Done 				<= 1'b0;
 			AB_read_en 			<= 1'b0;
 			A_read_address 		<= {A_depth_bits{1'b0}};
-			B_read_address 		<= {B_depth_bits{1'b0}};
+			B_index 			<= {B_depth_bits{1'b0}};
 			RES_write_en 		<= 1'b0;
 			RES_write_address 	<= {RES_depth_bits{1'b0}};
 			RES_write_data_in 	<= {width{1'b0}};
@@ -120,7 +147,7 @@ module matrix_multiply
 			Done 				<= 1'b0;
 			AB_read_en 			<= 1'b0;
 			A_read_address 		<= {A_depth_bits{1'b0}};
-			B_read_address 		<= {B_depth_bits{1'b0}};
+			B_index 			<= {B_depth_bits{1'b0}};
 			RES_write_en 		<= 1'b0;
 			RES_write_address 	<= {RES_depth_bits{1'b0}};
 			RES_write_data_in 	<= {width{1'b0}};
@@ -137,7 +164,7 @@ module matrix_multiply
 						AB_read_en 		<= 1'b1;
 
 						A_read_address 	<= {A_depth_bits{1'b0}};
-						B_read_address 	<= {B_depth_bits{1'b0}};
+						B_index 		<= {B_depth_bits{1'b0}};
 					end
 				end
 
@@ -145,7 +172,7 @@ module matrix_multiply
 				begin
 					// Latch current addresses, act as counters
 					A_read_address <= A_read_address;
-					B_read_address <= B_read_address;
+					B_index 		<= B_index;
 
 					if (iter_end & mac_done)
 					begin
@@ -165,19 +192,30 @@ module matrix_multiply
 
 							AB_read_en 		<= 1'b1;
 
-							A_read_address 	<= A_read_address + 1'b1;
-							B_read_address 	<= 1'b0;
+							// sparse: A_read_address already is the first entry of the next row
+							A_read_address 	<= sparse ? A_read_address : A_read_address + 1'b1;
+							B_index 		<= 1'b0;
 						end
 					end
 					else if (~iter_end)
 					begin
-						if (B_read_address == (N_WORDS_B - 1)) iter_end <= 1'b1;
+						if (sparse)
+						begin
+							if (A_valid & A_eor) iter_end <= 1'b1;
+							else
+							begin
+								AB_read_en 		<= 1'b1;
+
+								A_read_address 	<= A_read_address + 1'b1;
+							end
+						end
+						else if (B_index == (N_WORDS_B - 1)) iter_end <= 1'b1;
 						else
 						begin
 							AB_read_en 		<= 1'b1;
 
 							A_read_address 	<= A_read_address + 1'b1;
-							B_read_address 	<= B_read_address + 1'b1;
+							B_index 		<= B_index + 1'b1;
 						end
 					end
 				end
@@ -0,0 +1,209 @@
+`timescale 1ns / 1ps
+/*
+----------------------------------------------------------------------------------
+--  Description : Row-streaming variant of myip_v1_0 for an unbounded number of rows.
+--	B is loaded once and the rows of A then stream through the MAC as they arrive,
+--	one result per row, so no RAM is sized by m. Same ports and result contract,
+--	RES = (sum((A * B) >> 8)) & 0xFF, see lab3/srcs/dma/c/stream.h for the firmware.
+--
+--	Input words:
+--	  TDATA[31] set   first of the n words of a new B, any time between two rows
+--	  TDATA[31] clear the next element of the current row, in column order
+--	The result of a row carries M_AXIS_TLAST when the last element of the row did on
+--	S_AXIS, so every MM2S transfer of whole rows is answered by one S2MM packet.
+----------------------------------------------------------------------------------
+*/
+
+module myip_stream_v1_0
+# (
+	parameter n = 32,
+	parameter width = 8,
+	parameter RES_depth_bits = 4	// results held while M_AXIS is stalled, S_AXIS stops taking rows when full
+)
+(
+	input						ACLK,
+	input						ARESETN,
+	// slave in interface
+	output	wire				S_AXIS_TREADY,
+	input		[31 : 0]		S_AXIS_TDATA,
+	input						S_AXIS_TLAST,
+	input						S_AXIS_TVALID,
+	// master out interface
+	output	wire				M_AXIS_TVALID,
+	output	wire [31 : 0]		M_AXIS_TDATA,
+	output	wire				M_AXIS_TLAST,
+	input						M_AXIS_TREADY
+);
+
+	localparam B_depth_bits 	= $clog2(n);
+	localparam N_WORDS_RES 		= 2**RES_depth_bits;
+	localparam MAC_OUT_WIDTH	= width + B_depth_bits;
+
+	wire 						in_fire 	= S_AXIS_TVALID & S_AXIS_TREADY;
+	wire 						out_fire 	= M_AXIS_TVALID & M_AXIS_TREADY;
+
+	// Position of the next word in B or in the current row
+	reg 	[B_depth_bits-1:0]	index;
+	reg 						loading_b;
+	wire 						b_word 		= S_AXIS_TDATA[31] | loading_b;
+	wire 	[B_depth_bits-1:0]	position 	= S_AXIS_TDATA[31] ? {B_depth_bits{1'b0}} : index;
+	wire 						row_start 	= in_fire & ~b_word & (index == 0);
+	wire 						row_end 	= in_fire & ~b_word & (index == n - 1);
+
+	// The MAC needs one clear cycle between rows: S_AXIS pauses for a cycle after the
+	// last element of a row. Rows are only started while their result has a free slot.
+	reg 						row_gap;
+	reg 	[RES_depth_bits:0]	rows_open;		// rows started and not yet sent
+
+	assign S_AXIS_TREADY = ~row_gap & (index != 0 | loading_b | rows_open != N_WORDS_RES);
+
+	// B_RAM is written and read straight from S_AXIS
+	wire 	[width-1:0]			B_read_data_out;
+
+	memory_RAM
+	#(
+		.width(width),
+		.depth_bits(B_depth_bits)
+	)
+	B_RAM
+	(
+		.clk(ACLK),
+		.write_en(in_fire & b_word),
+		.write_address(position),
+		.write_data_in(S_AXIS_TDATA[width-1:0]),
+		.read_en(in_fire & ~b_word),
+		.read_address(index),
+		.read_data_out(B_read_data_out)
+	);
+
+	always_ff @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			index 		<= {B_depth_bits{1'b0}};
+			loading_b 	<= 1'b0;
+			row_gap 	<= 1'b1;
+		end
+		else
+		begin
+			row_gap 	<= row_end;
+
+			if (in_fire)
+			begin
+				index 		<= (position == n - 1) ? {B_depth_bits{1'b0}} : position + 1'b1;
+				loading_b 	<= b_word & (position != n - 1);
+			end
+		end
+	end
+
+	// Element of A waiting for its B_RAM read, then the MAC
+	reg 					a_valid;
+	reg 	[width-1:0]		a_value;
+	reg 					a_row_end;
+	reg 					a_tlast;
+
+	reg 					mac_en;
+	reg 					mac_clear;
+	reg 					mac_row_end;
+	reg 	[width-1:0]		mac_a;
+	reg 	[width-1:0]		mac_b;
+	reg 					mac_tlast;
+	wire 	[MAC_OUT_WIDTH-1:0]	mac_out;
+	wire 					mac_done;
+
+	// {TLAST, row fed} of the MAC input, delayed to line up with mac_done. The MAC also
+	// pulses done when it leaves reset, only the done of a fed row is a result.
+	reg 	[1:0]			res_d1;
+	reg 	[1:0]			res_d2;
+	wire 					res_valid = mac_done & res_d2[0];
+
+	always_ff @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			a_valid 		<= 1'b0;
+			a_value 		<= {width{1'b0}};
+			a_row_end 		<= 1'b0;
+			a_tlast 		<= 1'b0;
+
+			mac_en 			<= 1'b0;
+			mac_clear 		<= 1'b1;
+			mac_row_end 	<= 1'b0;
+			mac_a 			<= {width{1'b0}};
+			mac_b 			<= {width{1'b0}};
+			mac_tlast 		<= 1'b0;
+			res_d1 			<= 2'b00;
+			res_d2 			<= 2'b00;
+		end
+		else
+		begin
+			a_valid 		<= in_fire & ~b_word;
+			a_value 		<= S_AXIS_TDATA[width-1:0];
+			a_row_end 		<= row_end;
+			a_tlast 		<= S_AXIS_TLAST;
+
+			// A stalled S_AXIS only pauses the MAC, it is cleared once a row has been fed
+			mac_en 			<= a_valid;
+			mac_clear 		<= ~a_valid & (mac_clear | (mac_en & mac_row_end));
+			if (a_valid)
+			begin
+				mac_row_end 	<= a_row_end;
+				mac_a 			<= a_value;
+				mac_b 			<= B_read_data_out;
+				mac_tlast 		<= a_tlast;
+			end
+
+			// mac_done follows the last element of a row by two cycles
+			res_d1 			<= {mac_tlast, mac_en & mac_row_end};
+			res_d2 			<= res_d1;
+		end
+	end
+
+	// Results in row order, {TLAST, RES}
+	reg 	[width:0]			RES_FIFO [0:N_WORDS_RES-1];
+	reg 	[RES_depth_bits-1:0] RES_write_address;
+	reg 	[RES_depth_bits-1:0] RES_read_address;
+	reg 	[RES_depth_bits:0]	RES_count;
+
+	assign M_AXIS_TVALID = RES_count != 0;
+	assign M_AXIS_TDATA  = {{(32 - width){1'b0}}, RES_FIFO[RES_read_address][width-1:0]};
+	assign M_AXIS_TLAST  = M_AXIS_TVALID & RES_FIFO[RES_read_address][width];
+
+	always_ff @(posedge ACLK) begin
+		if (res_valid) RES_FIFO[RES_write_address] <= {res_d2[1], mac_out[width-1:0]};
+	end
+
+	always_ff @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			RES_write_address 	<= {RES_depth_bits{1'b0}};
+			RES_read_address 	<= {RES_depth_bits{1'b0}};
+			RES_count 			<= {(RES_depth_bits + 1){1'b0}};
+			rows_open 			<= {(RES_depth_bits + 1){1'b0}};
+		end
+		else
+		begin
+			if (res_valid) RES_write_address <= RES_write_address + 1'b1;
+			if (out_fire) RES_read_address 	<= RES_read_address + 1'b1;
+			RES_count 	<= RES_count + res_valid - out_fire;
+			rows_open 	<= rows_open + row_start - out_fire;
+		end
+	end
+
+	mac
+	#(
+		.width(width),
+		.n(B_depth_bits),
+		.fixed_point(width)
+	)
+	mac_stream
+	(
+		.clk(ACLK),
+		.aresetn(ARESETN),
+		.en(mac_en),
+		.clear(mac_clear),
+		.a(mac_a),
+		.b(mac_b),
+		.out(mac_out),
+		.done(mac_done)
+	);
+
+endmodule
@@ -0,0 +1,311 @@
+`timescale 1ns / 1ps
+/*
+----------------------------------------------------------------------------------
+--  Description : Matrix-matrix variant of myip_v1_0 on a systolic array. Computes
+--	RES (m x p) = A (m x n) times B (n x p), RES = (sum((A * B) >> 8)) & 0xFF for every
+--	element, on a grid_rows x p output-stationary systolic_array: a tile of grid_rows
+--	rows of A meets all p columns of B in n + grid_rows + p + 1 cycles, where
+--	matrix_multiply takes n + 4 cycles for a single row and column.
+--
+--	Input words, TDATA[width-1:0]: A row-major, then B row-major, m * n + n * p words.
+--	Output words: RES row-major, m * p words, TLAST on the last. With p = 1 this is the
+--	protocol of myip_v1_0, see lab3/srcs/dma/c/lab3_dma.h for the firmware (MATRIX_B_COLS).
+--
+--	The rows of A are dealt to grid_rows A_RAM banks and the columns of B to p B_RAM
+--	banks, so the array gets one element per row and column every cycle. The sums of a
+--	tile are copied to a result register bank, sent from there while the next tile runs.
+--	A of the next job is taken as soon as the last tile is in the result bank.
+----------------------------------------------------------------------------------
+*/
+
+module myip_systolic_v1_0
+# (
+	parameter m = 32,
+	parameter n = 32,
+	parameter p = 4,
+	parameter width = 8,
+	parameter grid_rows = 4		// rows of A per tile, must divide m
+)
+(
+	input						ACLK,
+	input						ARESETN,
+	// slave in interface
+	output	wire				S_AXIS_TREADY,
+	input		[31 : 0]		S_AXIS_TDATA,
+	input						S_AXIS_TLAST,
+	input						S_AXIS_TVALID,
+	// master out interface
+	output	reg					M_AXIS_TVALID,
+	output	reg [31 : 0]		M_AXIS_TDATA,
+	output	reg					M_AXIS_TLAST,
+	input						M_AXIS_TREADY
+);
+
+	localparam TILES 			= m / grid_rows;
+	localparam TILE_RESULTS 	= grid_rows * p;
+	localparam STEPS 			= n + grid_rows + p + 1;		// feed and drain of one tile
+	localparam A_bank_bits 		= (TILES * n > 1) ? $clog2(TILES * n) : 1;
+	localparam B_bank_bits 		= (n > 1) ? $clog2(n) : 1;
+	localparam STEP_BITS 		= $clog2(STEPS + 1);
+	localparam TILE_BITS 		= (TILES > 1) ? $clog2(TILES) : 1;
+	localparam RES_index_bits 	= (TILE_RESULTS > 1) ? $clog2(TILE_RESULTS) : 1;
+	localparam ROW_BITS 		= (grid_rows > 1) ? $clog2(grid_rows) : 1;
+	localparam COL_BITS 		= (p > 1) ? $clog2(p) : 1;
+	localparam K_BITS 			= (n > 1) ? $clog2(n) : 1;
+
+	generate
+		if (m % grid_rows != 0) begin : grid_check
+			$error("grid_rows must divide m");
+		end
+	endgenerate
+
+	// Define the states of state machine (one hot encoding)
+	localparam READ_INPUTS_A = 3'b001;
+	localparam READ_INPUTS_B = 3'b010;
+	localparam COMPUTE       = 3'b100;
+	reg [2:0] state;
+
+	wire in_fire = S_AXIS_TVALID & S_AXIS_TREADY;
+	assign S_AXIS_TREADY = (state == READ_INPUTS_A) | (state == READ_INPUTS_B);
+
+	// Position of the next input word: element in_k of the row of tile in_tile in bank in_bank,
+	// at in_tile_base + in_k, or element (in_k, in_col) of B
+	reg 	[ROW_BITS-1:0]		in_bank;
+	reg 	[A_bank_bits-1:0]	in_tile_base;
+	reg 	[TILE_BITS-1:0]		in_tile;
+	reg 	[K_BITS-1:0]		in_k;
+	reg 	[COL_BITS-1:0]		in_col;
+
+	// Tile being computed and the step of its feed
+	reg 	[TILE_BITS-1:0]		tile;
+	reg 	[A_bank_bits-1:0]	tile_base;
+	reg 	[STEP_BITS-1:0]		step;
+
+	// Result register bank, TILE_RESULTS sums in row-major order
+	reg 	[width-1:0]			tile_res [0:TILE_RESULTS-1];
+	reg 						tile_res_valid;
+	reg 						tile_res_last;		// the last tile of the job
+	reg 	[RES_index_bits-1:0] out_index;
+
+	wire capture = (state == COMPUTE) & (step == STEPS - 1) & ~tile_res_valid;
+
+	always_ff @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			state 			<= READ_INPUTS_A;
+			in_bank 		<= {ROW_BITS{1'b0}};
+			in_tile_base 	<= {A_bank_bits{1'b0}};
+			in_tile 		<= {TILE_BITS{1'b0}};
+			in_k 			<= {K_BITS{1'b0}};
+			in_col 			<= {COL_BITS{1'b0}};
+			tile 			<= {TILE_BITS{1'b0}};
+			tile_base 		<= {A_bank_bits{1'b0}};
+			step 			<= {STEP_BITS{1'b0}};
+		end
+		else
+		begin
+			case (state)
+				READ_INPUTS_A:
+				begin
+					if (in_fire)
+					begin
+						if (in_k == n - 1)
+						begin
+							in_k <= {K_BITS{1'b0}};
+							if (in_bank == grid_rows - 1)
+							begin
+								in_bank 		<= {ROW_BITS{1'b0}};
+								in_tile_base 	<= in_tile_base + n;
+								if (in_tile == TILES - 1)
+								begin
+									in_tile 		<= {TILE_BITS{1'b0}};
+									in_tile_base 	<= {A_bank_bits{1'b0}};
+									state 			<= READ_INPUTS_B;
+								end
+								else in_tile 	<= in_tile + 1'b1;
+							end
+							else in_bank 	<= in_bank + 1'b1;
+						end
+						else in_k 	<= in_k + 1'b1;
+					end
+				end
+
+				READ_INPUTS_B:
+				begin
+					if (in_fire)
+					begin
+						if (in_col == p - 1)
+						begin
+							in_col <= {COL_BITS{1'b0}};
+							if (in_k == n - 1)
+							begin
+								in_k 	<= {K_BITS{1'b0}};
+								state 	<= COMPUTE;
+							end
+							else in_k 	<= in_k + 1'b1;
+						end
+						else in_col 	<= in_col + 1'b1;
+					end
+				end
+
+				COMPUTE:
+				begin
+					// The sums wait in the array until the result bank is free
+					if (step != STEPS - 1) step <= step + 1'b1;
+					else if (capture)
+					begin
+						step <= {STEP_BITS{1'b0}};
+						if (tile == TILES - 1)
+						begin
+							tile 		<= {TILE_BITS{1'b0}};
+							tile_base 	<= {A_bank_bits{1'b0}};
+							state 		<= READ_INPUTS_A;
+						end
+						else
+						begin
+							tile 		<= tile + 1'b1;
+							tile_base 	<= tile_base + n;
+						end
+					end
+				end
+
+				default: state <= READ_INPUTS_A;
+			endcase
+		end
+	end
+
+	// Operands of the array: bank i is read k + i steps into the tile for element k, and
+	// a bank with nothing to read feeds 0 one cycle later, when its RAM output would be due
+	wire 	[grid_rows*width-1:0]	a_in;
+	wire 	[p*width-1:0]			b_in;
+	wire 	[TILE_RESULTS*width-1:0] acc_out;
+
+	genvar i, j;
+	generate
+		for (i = 0; i < grid_rows; i = i + 1) begin : A_bank
+			wire 					read_en = (state == COMPUTE) & (step >= i) & (step < n + i);
+			wire 	[width-1:0]		read_data_out;
+			reg 					read_valid;
+
+			always_ff @(posedge ACLK) begin
+				if (~ARESETN) read_valid <= 1'b0;
+				else read_valid <= read_en;
+			end
+
+			assign a_in[i*width +: width] = read_valid ? read_data_out : {width{1'b0}};
+
+			memory_RAM
+			#(
+				.width(width),
+				.depth_bits(A_bank_bits)
+			) A_RAM
+			(
+				.clk(ACLK),
+				.write_en(in_fire & (state == READ_INPUTS_A) & (in_bank == i)),
+				.write_address(in_tile_base + in_k),
+				.write_data_in(S_AXIS_TDATA[width-1:0]),
+				.read_en(read_en),
+				.read_address(tile_base + (step - i)),
+				.read_data_out(read_data_out)
+			);
+		end
+
+		for (j = 0; j < p; j = j + 1) begin : B_bank
+			wire 					read_en = (state == COMPUTE) & (step >= j) & (step < n + j);
+			wire 	[width-1:0]		read_data_out;
+			reg 					read_valid;
+
+			always_ff @(posedge ACLK) begin
+				if (~ARESETN) read_valid <= 1'b0;
+				else read_valid <= read_en;
+			end
+
+			assign b_in[j*width +: width] = read_valid ? read_data_out : {width{1'b0}};
+
+			memory_RAM
+			#(
+				.width(width),
+				.depth_bits(B_bank_bits)
+			) B_RAM
+			(
+				.clk(ACLK),
+				.write_en(in_fire & (state == READ_INPUTS_B) & (in_col == j)),
+				.write_address(in_k),
+				.write_data_in(S_AXIS_TDATA[width-1:0]),
+				.read_en(read_en),
+				.read_address(step - j),
+				.read_data_out(read_data_out)
+			);
+		end
+	endgenerate
+
+	systolic_array
+	#(
+		.rows(grid_rows),
+		.cols(p),
+		.width(width),
+		.fixed_point(width)
+	) systolic_array_0
+	(
+		.clk(ACLK),
+		.aresetn(ARESETN),
+		.clear(capture),
+		.a_in(a_in),
+		.b_in(b_in),
+		.acc_out(acc_out)
+	);
+
+	// Output streaming from the result bank, one sum per beat in row-major order
+	integer r;
+
+	always_ff @(posedge ACLK) begin
+		if (capture)
+		begin
+			for (r = 0; r < TILE_RESULTS; r = r + 1) tile_res[r] <= acc_out[r*width +: width];
+		end
+	end
+
+	always_ff @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			M_AXIS_TVALID 	<= 1'b0;
+			M_AXIS_TDATA 	<= 32'b0;
+			M_AXIS_TLAST 	<= 1'b0;
+			tile_res_valid 	<= 1'b0;
+			tile_res_last 	<= 1'b0;
+			out_index 		<= {RES_index_bits{1'b0}};
+		end
+		else
+		begin
+			if (capture)
+			begin
+				tile_res_valid 	<= 1'b1;
+				tile_res_last 	<= tile == TILES - 1;
+			end
+
+			if (~M_AXIS_TVALID | M_AXIS_TREADY)
+			begin
+				if (tile_res_valid)
+				begin
+					M_AXIS_TVALID 	<= 1'b1;
+					M_AXIS_TDATA 	<= {{(32 - width){1'b0}}, tile_res[out_index]};
+					M_AXIS_TLAST 	<= tile_res_last & (out_index == TILE_RESULTS - 1);
+
+					if (out_index == TILE_RESULTS - 1)
+					begin
+						out_index 		<= {RES_index_bits{1'b0}};
+						tile_res_valid 	<= 1'b0;
+					end
+					else out_index <= out_index + 1'b1;
+				end
+				else
+				begin
+					M_AXIS_TVALID 	<= 1'b0;
+					M_AXIS_TDATA 	<= 32'b0;
+					M_AXIS_TLAST 	<= 1'b0;
+				end
+			end
+		end
+	end
+
+endmodule
@@ -28,6 +28,7 @@
 -- M_AXIS_TDATA   : Data Out
 -- M_AXIS_TLAST   : Optional data out qualifier
 -- M_AXIS_TREADY  : Connected slave device is ready to accept data out
+-- S_AXI_*        : AXI4-Lite slave of the performance counters, see perf_counters.sv
 --
 -------------------------------------------------------------------------------
 */
@@ -36,7 +37,10 @@ module myip_v1_0
 # (
 	parameter m = 32,
 	parameter n = 32,
-	parameter width = 8
+	parameter width = 8,
+	parameter sparse = 0,	// 1: B first, then only the non-zeros of A, one word each (lab3/srcs/dma/c/sparse.h)
+	parameter lanes = 1,	// elements per beat: 1 in TDATA[width-1:0] of 32 bits, or 8 / 16 packed into 64 / 128 bits
+	localparam AXIS_WIDTH = (lanes == 1) ? 32 : lanes * width
 )
 (
 	// DO NOT EDIT BELOW THIS LINE ////////////////////
@@ -49,22 +53,57 @@ module myip_v1_0
 	M_AXIS_TVALID,
 	M_AXIS_TDATA,
 	M_AXIS_TLAST,
-	M_AXIS_TREADY
+	M_AXIS_TREADY,
 	// DO NOT EDIT ABOVE THIS LINE ////////////////////
+	S_AXI_AWADDR,
+	S_AXI_AWVALID,
+	S_AXI_AWREADY,
+	S_AXI_WDATA,
+	S_AXI_WSTRB,
+	S_AXI_WVALID,
+	S_AXI_WREADY,
+	S_AXI_BRESP,
+	S_AXI_BVALID,
+	S_AXI_BREADY,
+	S_AXI_ARADDR,
+	S_AXI_ARVALID,
+	S_AXI_ARREADY,
+	S_AXI_RDATA,
+	S_AXI_RRESP,
+	S_AXI_RVALID,
+	S_AXI_RREADY
 );
 
 	input					ACLK;    // Synchronous clock
 	input					ARESETN; // System reset, active low
 	// slave in interface
 	output	reg				S_AXIS_TREADY;  // Ready to accept data in
-	input	[31 : 0]		S_AXIS_TDATA;   // Data in
+	input	[AXIS_WIDTH-1 : 0]	S_AXIS_TDATA;   // Data in
 	input					S_AXIS_TLAST;   // Optional data in qualifier
 	input					S_AXIS_TVALID;  // Data in is valid
 	// master out interface
 	output	reg				M_AXIS_TVALID;  // Data out is valid
-	output	reg [31 : 0]	M_AXIS_TDATA;   // Data Out
+	output	reg [AXIS_WIDTH-1 : 0]	M_AXIS_TDATA;   // Data Out
 	output	reg				M_AXIS_TLAST;   // Optional data out qualifier
 	input					M_AXIS_TREADY;  // Connected slave device is ready to accept data out
+	// performance counters (AXI4-Lite), on ACLK / ARESETN
+	input	[5 : 0]			S_AXI_AWADDR;
+	input					S_AXI_AWVALID;
+	output	wire			S_AXI_AWREADY;
+	input	[31 : 0]		S_AXI_WDATA;
+	input	[3 : 0]			S_AXI_WSTRB;
+	input					S_AXI_WVALID;
+	output	wire			S_AXI_WREADY;
+	output	wire [1 : 0]	S_AXI_BRESP;
+	output	wire			S_AXI_BVALID;
+	input					S_AXI_BREADY;
+	input	[5 : 0]			S_AXI_ARADDR;
+	input					S_AXI_ARVALID;
+	output	wire			S_AXI_ARREADY;
+	output	wire [31 : 0]	S_AXI_RDATA;
+	output	wire [1 : 0]	S_AXI_RRESP;
+	output	wire			S_AXI_RVALID;
+	input					S_AXI_RREADY;
 
 	//----------------------------------------
 	// Implementation Section
@@ -80,48 +119,113 @@ module myip_v1_0
 	localparam B_depth_bits   = $clog2(INPUT_WORDS_B); 	// 32 elements (B is a 32x1 matrix)
 	localparam RES_depth_bits = $clog2(NUMBER_OF_OUTPUT_WORDS);	// 32 elements (RES is a 2x1 matrix)
 
+	// Sparse mode: an A word is {S_AXIS_TDATA[31] end of row, S_AXIS_TDATA[23:8] column, S_AXIS_TDATA[7:0] value},
+	// A_RAM keeps the end of row bit and the column bits B_RAM needs. A row has 1 to n words,
+	// so m*n locations are still enough.
+	localparam A_width        = sparse ? width + B_depth_bits + 1 : width;
+
+	// Wide stream: every beat is written to A_RAM / B_RAM as one location of lanes elements, B padded
+	// to whole beats, and matrix_multiply reads single elements through a lane select. RES_RAM is one
+	// RAM per lane, written an element at a time and read a beat at a time. With lanes = 1 a beat is
+	// an element and the RAMs are as before.
+	localparam LANE_BITS      = $clog2(lanes);
+	localparam LANE_SEL_BITS  = (LANE_BITS > 0) ? LANE_BITS : 1;
+	localparam BEAT_WIDTH     = lanes * A_width;			// bits of an A_RAM location
+	localparam A_BEATS        = INPUT_WORDS_A / lanes;
+	localparam B_BEATS        = (INPUT_WORDS_B + lanes - 1) / lanes;
+	localparam RES_BEATS      = (NUMBER_OF_OUTPUT_WORDS + lanes - 1) / lanes;
+	localparam A_beat_bits    = A_depth_bits - LANE_BITS;
+	localparam B_beat_bits    = (B_depth_bits > LANE_BITS) ? B_depth_bits - LANE_BITS : 1;
+	localparam RES_beat_bits  = (RES_depth_bits > LANE_BITS) ? RES_depth_bits - LANE_BITS : 1;
+
+	generate
+		if (lanes != 1 && (sparse || (lanes != 8 && lanes != 16) || INPUT_WORDS_A % lanes != 0 || A_BEATS < 2)) begin : lanes_check
+			$error("lanes must be 1, 8 or 16, divide m*n at least twice and cannot be combined with sparse");
+		end
+	endgenerate
+
 	// wires (or regs) to connect to RAMs and matrix_multiply_0 for assignment 1
 	// those which are assigned in an always block of myip_v1_0 shoud be changes to reg.
 	reg								A_write_en;				// myip_v1_0 -> A_RAM. To be assigned within myip_v1_0. Possibly reg.
-	reg		[A_depth_bits-1:0] 		A_write_address;		// myip_v1_0 -> A_RAM. To be assigned within myip_v1_0. Possibly reg.
-	reg		[width-1:0]				A_write_data_in;		// myip_v1_0 -> A_RAM. To be assigned within myip_v1_0. Possibly reg.
+	reg		[A_beat_bits-1:0] 		A_write_address;		// myip_v1_0 -> A_RAM. To be assigned within myip_v1_0. Possibly reg.
+	reg		[BEAT_WIDTH-1:0]		A_write_data_in;		// myip_v1_0 -> A_RAM. To be assigned within myip_v1_0. Possibly reg.
 	wire							A_read_en;				// matrix_multiply_0 -> A_RAM.
-	wire	[A_depth_bits-1:0] 		A_read_address;			// matrix_multiply_0 -> A_RAM.
-	wire	[width-1:0]	 			A_read_data_out;		// A_RAM -> matrix_multiply_0.
+	wire	[A_depth_bits-1:0] 		A_read_address;			// matrix_multiply_0 -> A_RAM, element address
+	wire	[A_width-1:0]	 		A_read_data_out;		// A_RAM -> matrix_multiply_0, selected lane
 	reg								B_write_en;				// myip_v1_0 -> B_RAM. To be assigned within myip_v1_0. Possibly reg.
-	reg		[B_depth_bits-1:0] 		B_write_address;		// myip_v1_0 -> B_RAM. To be assigned within myip_v1_0. Possibly reg.
-	reg		[width-1:0] 			B_write_data_in;		// myip_v1_0 -> B_RAM. To be assigned within myip_v1_0. Possibly reg.
+	reg		[B_beat_bits-1:0] 		B_write_address;		// myip_v1_0 -> B_RAM. To be assigned within myip_v1_0. Possibly reg.
+	reg		[lanes*width-1:0] 		B_write_data_in;		// myip_v1_0 -> B_RAM. To be assigned within myip_v1_0. Possibly reg.
 	wire							B_read_en;				// matrix_multiply_0 -> B_RAM.
-	wire	[B_depth_bits-1:0] 		B_read_address;			// matrix_multiply_0 -> B_RAM.
-	wire	[width-1:0] 			B_read_data_out;		// B_RAM -> matrix_multiply_0.
+	wire	[B_depth_bits-1:0] 		B_read_address;			// matrix_multiply_0 -> B_RAM, element address
+	wire	[width-1:0] 			B_read_data_out;		// B_RAM -> matrix_multiply_0, selected lane
 	wire							RES_write_en;			// matrix_multiply_0 -> RES_RAM.
-	wire	[RES_depth_bits-1:0]	RES_write_address;		// matrix_multiply_0 -> RES_RAM.
+	wire	[RES_depth_bits-1:0]	RES_write_address;		// matrix_multiply_0 -> RES_RAM, element address
 	wire	[width-1:0] 			RES_write_data_in;		// matrix_multiply_0 -> RES_RAM.
 	wire							RES_read_en;  			// myip_v1_0 -> RES_RAM. To be assigned within myip_v1_0. Possibly reg.
-	reg		[RES_depth_bits-1:0] 	RES_read_address;		// myip_v1_0 -> RES_RAM. To be assigned within myip_v1_0. Possibly reg.
-	wire	[width-1:0] 			RES_read_data_out;		// RES_RAM -> myip_v1_0
+	reg		[RES_beat_bits-1:0] 	RES_read_address;		// myip_v1_0 -> RES_RAM, beat address
+	wire	[lanes*width-1:0] 		RES_read_data_out;		// RES_RAM -> myip_v1_0, a beat of results
 
 	// wires (or regs) to connect to matrix_multiply for assignment 1
 	reg		Start; 								// myip_v1_0 -> matrix_multiply_0. To be assigned within myip_v1_0. Possibly reg.
 	wire	Done;								// matrix_multiply_0 -> myip_v1_0.
 
-	// Define the states of state machine (one hot encoding)
-	localparam IDLE          = 7'b0000001;
-	localparam FIRST         = 7'b0000010;
-	localparam READ_INPUTS_A = 7'b0000100;
-	localparam READ_INPUTS_B = 7'b0001000;
-	localparam COMPUTE       = 7'b0010000;
-	localparam WRITE_OUTPUTS = 7'b0100000;
-	localparam LAST          = 7'b1000000;
-	reg [6:0] state;
-
-	wire M_AXIS_WE = (M_AXIS_TREADY | ~M_AXIS_TVALID);
-	assign RES_read_en = M_AXIS_WE & (state == WRITE_OUTPUTS);
+	// A word as stored in A_RAM, and the rows of A received so far in sparse mode
+	wire	[BEAT_WIDTH-1:0]		S_AXIS_A_WORD;
+	reg		[RES_depth_bits:0]		A_rows_written;
 
-	reg 	[RES_depth_bits-1:0] 	RES_read_address_dly;
+	generate
+		if (sparse) begin : sparse_a_word
+			assign S_AXIS_A_WORD = {S_AXIS_TDATA[31], S_AXIS_TDATA[width +: B_depth_bits], S_AXIS_TDATA[width-1:0]};
+		end
+		else begin : dense_a_word
+			assign S_AXIS_A_WORD = S_AXIS_TDATA[BEAT_WIDTH-1:0];
+		end
+	endgenerate
 
+	// Define the states of state machine (one hot encoding)
+	localparam IDLE          = 6'b000001;
+	localparam FIRST         = 6'b000010;
+	localparam READ_INPUTS_A = 6'b000100;
+	localparam READ_INPUTS_B = 6'b001000;
+	localparam COMPUTE       = 6'b010000;	// matrix_multiply running, finished RES entries are already streamed out
+	localparam WRITE_OUTPUTS = 6'b100000;	// matrix_multiply done, draining the remaining RES entries
+	reg [5:0] state;
+
+	// Output streaming. A RES entry is read out as soon as matrix_multiply has written it, so
+	// WRITE_OUTPUTS overlaps COMPUTE instead of waiting for Done.
+	// RES_RAM has a one cycle read latency, so a read is only issued when there is room for its data
+	// in M_AXIS_TDATA or the skid register, even if M_AXIS_TREADY drops in the meantime.
+	reg 	[RES_depth_bits:0] 		RES_written_count;		// RES entries written by matrix_multiply in this job
+	reg 							RES_read_done;			// all RES entries of this job have been read
+	reg 							RES_read_pending;		// RES_read_data_out is valid in this cycle
+	reg 							RES_read_last_pending;	// ... and it is the last word of the job
+	reg 	[lanes*width-1:0] 		skid_data;
+	reg 							skid_last;
+	reg 							skid_valid;
+
+	wire M_AXIS_POP = M_AXIS_TVALID & M_AXIS_TREADY;
+	wire [1:0] OUT_OCCUPANCY = M_AXIS_TVALID + skid_valid + RES_read_pending;
+	// a beat can be read once its last lane is written
+	wire [RES_depth_bits+1:0] RES_BEAT_END = (RES_read_address + 1'b1) * lanes;
+	wire RES_AVAILABLE = (RES_BEAT_END <= RES_written_count) | (RES_written_count == NUMBER_OF_OUTPUT_WORDS);
+
+	// Beats of results as they go out on M_AXIS_TDATA, the unused upper bits of a 32-bit beat are 0
+	wire [AXIS_WIDTH-1:0] skid_beat;
+	wire [AXIS_WIDTH-1:0] RES_read_beat;
+
+	generate
+		if (AXIS_WIDTH > lanes*width) begin : padded_beat
+			assign skid_beat 	 = {{(AXIS_WIDTH-lanes*width){1'b0}}, skid_data};
+			assign RES_read_beat = {{(AXIS_WIDTH-lanes*width){1'b0}}, RES_read_data_out};
+		end
+		else begin : packed_beat
+			assign skid_beat 	 = skid_data;
+			assign RES_read_beat = RES_read_data_out;
+		end
+	endgenerate
 
-	reg RABAK_REG;
+	// RES_RAM is single ported, matrix_multiply writes take priority
+	assign RES_read_en = ~RES_read_done & RES_AVAILABLE & ~RES_write_en & ((OUT_OCCUPANCY - M_AXIS_POP) <= 1);
 
 	always_ff @(posedge ACLK)
 	begin
@@ -135,45 +239,34 @@ module myip_v1_0
 			S_AXIS_TREADY 		 <= 1'b0;
 
 			A_write_en 			 <= 1'b0;
-			A_write_address 	 <= {A_depth_bits{1'b0}};
-			A_write_data_in 	 <= {width{1'b0}};
+			A_write_address 	 <= {A_beat_bits{1'b0}};
+			A_write_data_in 	 <= {BEAT_WIDTH{1'b0}};
 			B_write_en 			 <= 1'b0;
-			B_write_address 	 <= {B_depth_bits{1'b0}};
-			B_write_data_in 	 <= {width{1'b0}};
-			RES_read_address 	 <= {RES_depth_bits{1'b0}};
+			B_write_address 	 <= {B_beat_bits{1'b0}};
+			B_write_data_in 	 <= {(lanes*width){1'b0}};
 			Start				 <= 1'b0;
+			A_rows_written 		 <= {(RES_depth_bits+1){1'b0}};
 
 			state       		 <= IDLE;
-
-			RES_read_address_dly <= {RES_depth_bits{1'b0}};
-
-			RABAK_REG <= 1'b0;
         end
 		else
 		begin
 			// NOTE explicit latch prevention
 			S_AXIS_TREADY 		 	<= 1'b0;
-			M_AXIS_TDATA 			<= 32'b0;
-			M_AXIS_TLAST 			<= 1'b0;
-			M_AXIS_TVALID 			<= 1'b0;
 
 			A_write_en 			 <= 1'b0;
-			A_write_address 	 <= {A_depth_bits{1'b0}};
-			A_write_data_in 	 <= {width{1'b0}};
+			A_write_address 	 <= {A_beat_bits{1'b0}};
+			A_write_data_in 	 <= {BEAT_WIDTH{1'b0}};
 			B_write_en 			 <= 1'b0;
-			B_write_address 	 <= {B_depth_bits{1'b0}};
-			B_write_data_in 	 <= {width{1'b0}};
-			RES_read_address 	 <= {RES_depth_bits{1'b0}};
+			B_write_address 	 <= {B_beat_bits{1'b0}};
+			B_write_data_in 	 <= {(lanes*width){1'b0}};
 			Start				 <= 1'b0;
 
-			RES_read_address_dly 	<= RES_read_address;
-
-			RABAK_REG <= 1'b0;
-
 			case (state)
 
 				IDLE:
 				begin
+					A_rows_written <= {(RES_depth_bits+1){1'b0}};
 					if (S_AXIS_TVALID)
 					begin
 						S_AXIS_TREADY 	 <= 1'b1;
@@ -186,11 +279,22 @@ module myip_v1_0
 					S_AXIS_TREADY 	 <= 1'b1;
 					if (S_AXIS_TVALID)
 					begin
-						state       	 <= READ_INPUTS_A;
+						if (sparse)
+						begin
+							state       	 <= READ_INPUTS_B;
 
-						A_write_en 		 <= 1'b1;
-						A_write_address  <= {A_depth_bits{1'b0}};
-						A_write_data_in  <= S_AXIS_TDATA[width-1:0];
+							B_write_en 		 <= 1'b1;
+							B_write_address  <= {B_beat_bits{1'b0}};
+							B_write_data_in  <= S_AXIS_TDATA[lanes*width-1:0];
+						end
+						else
+						begin
+							state       	 <= READ_INPUTS_A;
+
+							A_write_en 		 <= 1'b1;
+							A_write_address  <= {A_beat_bits{1'b0}};
+							A_write_data_in  <= S_AXIS_A_WORD;
+						end
 					end
 				end
 
@@ -199,23 +303,48 @@ module myip_v1_0
 					S_AXIS_TREADY 	<= 1'b1;
 					A_write_address <= A_write_address;
 
-					if (S_AXIS_TVALID)
+					if (sparse)
 					begin
-						if (A_write_address == (INPUT_WORDS_A - 1))
+						if (S_AXIS_TVALID)
+						begin
+							A_write_en 		<= 1'b1;
+							A_write_address <= A_write_address + 1'b1;
+							A_write_data_in <= S_AXIS_A_WORD;
+
+							if (S_AXIS_TDATA[31])
+							begin
+								A_rows_written <= A_rows_written + 1'b1;
+
+								// the last row has ended, take no beat of the next job
+								if (A_rows_written == (m - 1))
+								begin
+									S_AXIS_TREADY 	<= 1'b0;
+									state 			<= COMPUTE;
+									Start 			<= 1'b1;
+								end
+							end
+						end
+					end
+					else if (S_AXIS_TVALID)
+					begin
+						if (A_write_address == (A_BEATS - 1))
 						begin
 							state <= READ_INPUTS_B;
 
-							A_write_address <= {A_depth_bits{1'b0}};
+							A_write_address <= {A_beat_bits{1'b0}};
 
 							B_write_en 		<= 1'b1;
-							B_write_address <= {B_depth_bits{1'b0}};
-							B_write_data_in <= S_AXIS_TDATA[width-1:0];
+							B_write_address <= {B_beat_bits{1'b0}};
+							B_write_data_in <= S_AXIS_TDATA[lanes*width-1:0];
+
+							// B fits in one beat, take no beat of the next job
+							if (B_BEATS == 1) S_AXIS_TREADY <= 1'b0;
 						end
 						else
 						begin
 							A_write_en 		<= 1'b1;
 							A_write_address <= A_write_address + 1'b1;
-							A_write_data_in <= S_AXIS_TDATA[width-1:0];
+							A_write_data_in <= S_AXIS_A_WORD;
 						end
 					end
 				end
@@ -225,9 +354,34 @@ module myip_v1_0
 					S_AXIS_TREADY 	<= 1'b1;
 					B_write_address <= B_write_address;
 
-					if (B_write_address == (INPUT_WORDS_B - 1))
+					if (sparse)
+					begin
+						if (S_AXIS_TVALID)
+						begin
+							if (B_write_address == (B_BEATS - 1))
+							begin
+								state <= READ_INPUTS_A;
+
+								B_write_address <= {B_beat_bits{1'b0}};
+
+								A_write_en 		<= 1'b1;
+								A_write_address <= {A_beat_bits{1'b0}};
+								A_write_data_in <= S_AXIS_A_WORD;
+								A_rows_written 	<= {{RES_depth_bits{1'b0}}, S_AXIS_TDATA[31]};
+							end
+							else
+							begin
+								B_write_en 		<= 1'b1;
+								B_write_address <= B_write_address + 1'b1;
+								B_write_data_in <= S_AXIS_TDATA[lanes*width-1:0];
+							end
+						end
+					end
+					else if (B_write_address == (B_BEATS - 1))
 					begin
-						B_write_address <= {B_depth_bits{1'b0}};
+						// the last beat of B was taken at the edge before
+						S_AXIS_TREADY 	<= 1'b0;
+						B_write_address <= {B_beat_bits{1'b0}};
 
 						state <= COMPUTE;
 						Start <= 1'b1;
@@ -236,83 +390,132 @@ module myip_v1_0
 					begin
 						B_write_en 		<= 1'b1;
 						B_write_address <= B_write_address + 1'b1;
-						B_write_data_in <= S_AXIS_TDATA[width-1:0];
+						B_write_data_in <= S_AXIS_TDATA[lanes*width-1:0];
+
+						// the last beat of B, take no beat of the next job
+						if (B_write_address == (B_BEATS - 2)) S_AXIS_TREADY <= 1'b0;
 					end
 				end
 
 				COMPUTE:
 				begin
-					if (Done)
-					begin
-					state				<= WRITE_OUTPUTS;
-
-					RES_read_address	<= {RES_depth_bits{1'b0}};
-					RABAK_REG				<= 1'b0;
-					end
+					if (Done) state <= WRITE_OUTPUTS;
 				end
 
 				WRITE_OUTPUTS:
 				begin
-					M_AXIS_TDATA 	<= M_AXIS_TDATA;
-					M_AXIS_TLAST 	<= M_AXIS_TLAST;
-					M_AXIS_TVALID 	<= M_AXIS_TVALID;
-
-					RES_read_address	<= RES_read_address;
+					if (M_AXIS_POP & M_AXIS_TLAST) state <= IDLE;
+				end
 
-					RABAK_REG <= RABAK_REG;  // One cycle delay
+				default: state <= IDLE;
 
-					if (M_AXIS_WE)
-					begin
-						// WARNING DOES NOT WORK FOR BACKPRESSURE CASES
-						if (RES_read_address == (NUMBER_OF_OUTPUT_WORDS - 1))
-						begin
-							RES_read_address	<= {RES_depth_bits{1'b0}};
-						end
-						else RES_read_address 	<= RES_read_address + 1;
+			endcase
+		end
+	end
 
-						if (RABAK_REG)  //  RABAK FIX
-						begin
-							M_AXIS_TDATA 	<= {24'b0, RES_read_data_out};
-							M_AXIS_TVALID 	<= 1'b1;
-						end
-						else RABAK_REG <= 1'b1;
+	always_ff @(posedge ACLK)
+	begin
+		if (~ARESETN)
+		begin
+			M_AXIS_TVALID 			<= 1'b0;
+			M_AXIS_TDATA 			<= {AXIS_WIDTH{1'b0}};
+			M_AXIS_TLAST 			<= 1'b0;
 
-						if (RES_read_address_dly == (NUMBER_OF_OUTPUT_WORDS - 1))
-						begin
-							M_AXIS_TLAST 	<= 1'b1;
+			RES_read_address 		<= {RES_beat_bits{1'b0}};
+			RES_written_count 		<= {(RES_depth_bits+1){1'b0}};
+			RES_read_done 			<= 1'b1;
+			RES_read_pending 		<= 1'b0;
+			RES_read_last_pending 	<= 1'b0;
 
-							state 			<= LAST;
-						end
+			skid_data 				<= {(lanes*width){1'b0}};
+			skid_last 				<= 1'b0;
+			skid_valid 				<= 1'b0;
+		end
+		else
+		begin
+			RES_read_pending 		<= RES_read_en;
+			RES_read_last_pending 	<= RES_read_en & (RES_read_address == (RES_BEATS - 1));
+
+			if (Start)
+			begin
+				RES_read_address 	<= {RES_beat_bits{1'b0}};
+				RES_written_count 	<= {(RES_depth_bits+1){1'b0}};
+				RES_read_done 		<= 1'b0;
+			end
+			else
+			begin
+				if (RES_write_en) RES_written_count <= RES_written_count + 1'b1;
+
+				if (RES_read_en)
+				begin
+					if (RES_read_address == (RES_BEATS - 1))
+					begin
+						RES_read_address 	<= {RES_beat_bits{1'b0}};
+						RES_read_done 		<= 1'b1;
 					end
+					else RES_read_address 	<= RES_read_address + 1'b1;
 				end
+			end
 
-				LAST:
+			// M_AXIS_TDATA is loaded from the skid register first to keep the words in order
+			if (~M_AXIS_TVALID | M_AXIS_TREADY)
+			begin
+				if (skid_valid)
 				begin
-					M_AXIS_TDATA 	<= M_AXIS_TDATA;
-					M_AXIS_TLAST 	<= M_AXIS_TLAST;
-					M_AXIS_TVALID 	<= M_AXIS_TVALID;
-
-					if (M_AXIS_WE) begin
-						M_AXIS_TDATA 	<= 32'b0;
-						M_AXIS_TLAST 	<= 1'b0;
-						M_AXIS_TVALID 	<= 1'b0;
+					M_AXIS_TVALID 	<= 1'b1;
+					M_AXIS_TDATA 	<= skid_beat;
+					M_AXIS_TLAST 	<= skid_last;
 
-						state <= IDLE;
-					end
+					skid_valid 		<= RES_read_pending;
+					skid_data 		<= RES_read_data_out;
+					skid_last 		<= RES_read_last_pending;
 				end
-
-				default: state <= IDLE;
-
-			endcase
+				else if (RES_read_pending)
+				begin
+					M_AXIS_TVALID 	<= 1'b1;
+					M_AXIS_TDATA 	<= RES_read_beat;
+					M_AXIS_TLAST 	<= RES_read_last_pending;
+				end
+				else
+				begin
+					M_AXIS_TVALID 	<= 1'b0;
+					M_AXIS_TDATA 	<= {AXIS_WIDTH{1'b0}};
+					M_AXIS_TLAST 	<= 1'b0;
+				end
+			end
+			else if (RES_read_pending)
+			begin
+				skid_valid 	<= 1'b1;
+				skid_data 	<= RES_read_data_out;
+				skid_last 	<= RES_read_last_pending;
+			end
 		end
 	end
 
 	// Connection to sub-modules / components for assignment 1
 
+	// matrix_multiply addresses single elements: the beat is read from the RAM and the lane, kept
+	// with the read like the RAM output, picks the element out of it
+	wire	[A_beat_bits-1:0]		A_read_beat_address = A_read_address / lanes;
+	wire	[B_beat_bits-1:0]		B_read_beat_address = B_read_address / lanes;
+	wire	[BEAT_WIDTH-1:0]		A_read_beat;
+	wire	[lanes*width-1:0]		B_read_beat;
+	reg		[LANE_SEL_BITS-1:0]		A_read_lane;
+	reg		[LANE_SEL_BITS-1:0]		B_read_lane;
+
+	always_ff @(posedge ACLK)
+	begin
+		if (A_read_en) A_read_lane <= A_read_address % lanes;
+		if (B_read_en) B_read_lane <= B_read_address % lanes;
+	end
+
+	assign A_read_data_out = A_read_beat[A_read_lane*A_width +: A_width];
+	assign B_read_data_out = B_read_beat[B_read_lane*width +: width];
+
 	memory_RAM
 	#(
-		.width(width),
-		.depth_bits(A_depth_bits)
+		.width(BEAT_WIDTH),
+		.depth_bits(A_beat_bits)
 	) A_RAM
 	(
 		.clk(ACLK),
@@ -320,15 +523,15 @@ module myip_v1_0
 		.write_address(A_write_address),
 		.write_data_in(A_write_data_in),
 		.read_en(A_read_en),
-		.read_address(A_read_address),
-		.read_data_out(A_read_data_out)  // Output
+		.read_address(A_read_beat_address),
+		.read_data_out(A_read_beat)  // Output
 	);
 
 
 	memory_RAM
 	#(
-		.width(width),
-		.depth_bits(B_depth_bits)
+		.width(lanes*width),
+		.depth_bits(B_beat_bits)
 	) B_RAM
 	(
 		.clk(ACLK),
@@ -336,24 +539,75 @@ module myip_v1_0
 		.write_address(B_write_address),
 		.write_data_in(B_write_data_in),
 		.read_en(B_read_en),
-		.read_address(B_read_address),
-		.read_data_out(B_read_data_out)  // Output
+		.read_address(B_read_beat_address),
+		.read_data_out(B_read_beat)  // Output
 	);
 
 
-	memory_RAM
+	// One RES_RAM per lane, each result only goes to the RAM of its lane
+	wire	[RES_beat_bits-1:0]		RES_write_beat_address = RES_write_address / lanes;
+
+	genvar lane;
+	generate
+		for (lane = 0; lane < lanes; lane = lane + 1) begin : RES_lane
+			memory_RAM
+			#(
+				.width(width),
+				.depth_bits(RES_beat_bits)
+			) RES_RAM
+			(
+				.clk(ACLK),
+				.write_en(RES_write_en & ((RES_write_address % lanes) == lane)),
+				.write_address(RES_write_beat_address),
+				.write_data_in(RES_write_data_in),
+				.read_en(RES_read_en),
+				.read_address(RES_read_address),
+				.read_data_out(RES_read_data_out[lane*width +: width])  // Output
+			);
+		end
+	endgenerate
+
+	// Input layout for the firmware (lab3/srcs/dma/c/layout.h): lanes, A row-major in one bank, B first when sparse
+	localparam [31:0] LAYOUT_CAPS = 32'h4D00_0100 | (sparse ? 32'h0001_0000 : 32'h0) | lanes;
+
+	// FIRST waits for the first word of A, or of B in sparse mode
+	wire reading_a = (state == READ_INPUTS_A) | ((state == FIRST) & ~sparse);
+	wire reading_b = (state == READ_INPUTS_B) | ((state == FIRST) & sparse);
+
+	perf_counters
 	#(
-		.width(width),
-		.depth_bits(RES_depth_bits)
-	) RES_RAM
+		.ADDR_WIDTH(6)
+	) perf_counters_0
 	(
-		.clk(ACLK),
-		.write_en(RES_write_en),
-		.write_address(RES_write_address),
-		.write_data_in(RES_write_data_in),
-		.read_en(RES_read_en),
-		.read_address(RES_read_address),
-		.read_data_out(RES_read_data_out)  // Output
+		.ACLK(ACLK),
+		.ARESETN(ARESETN),
+
+		.read_a(reading_a),
+		.read_b(reading_b),
+		.compute(state == COMPUTE),
+		.write_outputs(state == WRITE_OUTPUTS),
+		.in_stall((reading_a | reading_b) & ~S_AXIS_TVALID),
+		.out_stall(M_AXIS_TVALID & ~M_AXIS_TREADY),
+		.job_done(M_AXIS_POP & M_AXIS_TLAST),
+		.caps(LAYOUT_CAPS),
+
+		.S_AXI_AWADDR(S_AXI_AWADDR),
+		.S_AXI_AWVALID(S_AXI_AWVALID),
+		.S_AXI_AWREADY(S_AXI_AWREADY),
+		.S_AXI_WDATA(S_AXI_WDATA),
+		.S_AXI_WSTRB(S_AXI_WSTRB),
+		.S_AXI_WVALID(S_AXI_WVALID),
+		.S_AXI_WREADY(S_AXI_WREADY),
+		.S_AXI_BRESP(S_AXI_BRESP),
+		.S_AXI_BVALID(S_AXI_BVALID),
+		.S_AXI_BREADY(S_AXI_BREADY),
+		.S_AXI_ARADDR(S_AXI_ARADDR),
+		.S_AXI_ARVALID(S_AXI_ARVALID),
+		.S_AXI_ARREADY(S_AXI_ARREADY),
+		.S_AXI_RDATA(S_AXI_RDATA),
+		.S_AXI_RRESP(S_AXI_RRESP),
+		.S_AXI_RREADY(S_AXI_RREADY),
+		.S_AXI_RVALID(S_AXI_RVALID)
 	);
 
 	matrix_multiply
@@ -361,7 +615,8 @@ module myip_v1_0
 		.width(width),
 		.A_depth_bits(A_depth_bits),
 		.B_depth_bits(B_depth_bits),
-		.RES_depth_bits(RES_depth_bits)
+		.RES_depth_bits(RES_depth_bits),
+		.sparse(sparse)
 	) matrix_multiply_0
 	(
 		.clk(ACLK),
@@ -0,0 +1,124 @@
+`timescale 1ns / 1ps
+/*
+----------------------------------------------------------------------------------
+--  Description : Performance counter bank of myip_v1_0 on an AXI4-Lite slave.
+--	32-bit counters of ACLK cycles, all wrapping, read at these byte offsets:
+--	  0x00 CTRL           write 1 to bit 0 to clear every counter, reads 0
+--	  0x04 JOBS           jobs completed, the last result taken on M_AXIS
+--	  0x08 READ_A         cycles receiving A (and waiting for its first word)
+--	  0x0C READ_B         cycles receiving B
+--	  0x10 COMPUTE        cycles matrix_multiply runs, results already go out meanwhile
+--	  0x14 WRITE_OUTPUTS  cycles sending the results left after matrix_multiply is done
+--	  0x18 IN_STALLS      cycles of READ_A / READ_B with S_AXIS_TVALID low
+--	  0x1C OUT_STALLS     cycles with M_AXIS_TVALID high and M_AXIS_TREADY low
+--	and a constant the IP advertises its input layout with:
+--	  0x20 CAPS           [31:24] 0x4D, [16] B before A, [15:8] A banks, [7:0] lanes
+--	The firmware reads them in lab3/srcs/dma/c/ipcounters.c and layout.c.
+----------------------------------------------------------------------------------
+*/
+
+module perf_counters
+#(
+	parameter ADDR_WIDTH = 6
+)
+(
+	input							ACLK,
+	input							ARESETN,
+
+	// Events, sampled every cycle
+	input							read_a,
+	input							read_b,
+	input							compute,
+	input							write_outputs,
+	input							in_stall,
+	input							out_stall,
+	input							job_done,
+	input		[31 : 0]			caps,
+
+	// AXI4-Lite slave
+	input		[ADDR_WIDTH-1 : 0]	S_AXI_AWADDR,
+	input							S_AXI_AWVALID,
+	output	reg						S_AXI_AWREADY,
+	input		[31 : 0]			S_AXI_WDATA,
+	input		[3 : 0]				S_AXI_WSTRB,
+	input							S_AXI_WVALID,
+	output	reg						S_AXI_WREADY,
+	output	wire [1 : 0]			S_AXI_BRESP,
+	output	reg						S_AXI_BVALID,
+	input							S_AXI_BREADY,
+	input		[ADDR_WIDTH-1 : 0]	S_AXI_ARADDR,
+	input							S_AXI_ARVALID,
+	output	reg						S_AXI_ARREADY,
+	output	reg [31 : 0]			S_AXI_RDATA,
+	output	wire [1 : 0]			S_AXI_RRESP,
+	input							S_AXI_RREADY,
+	output	reg						S_AXI_RVALID
+);
+
+	localparam COUNTERS = 8;	// register 0 is CTRL
+	localparam CAPS     = 8;	// register after the counters
+
+	reg 	[31:0]		counter [1:COUNTERS-1];
+	wire 	[COUNTERS-1:1] events = {out_stall, in_stall, write_outputs, compute, read_b, read_a, job_done};
+
+	assign S_AXI_BRESP = 2'b00;		// OKAY
+	assign S_AXI_RRESP = 2'b00;
+
+	// As the Vivado AXI4-Lite slave template: AWREADY and WREADY go up together once both the
+	// address and the data are valid, the register is written on that handshake and BVALID
+	// follows it a cycle later. One write at a time, the next waits for BREADY.
+	wire write_accept = S_AXI_AWVALID & S_AXI_WVALID & ~S_AXI_AWREADY & ~S_AXI_BVALID;
+	wire write_fire   = S_AXI_AWREADY & S_AXI_AWVALID & S_AXI_WREADY & S_AXI_WVALID;
+	wire clear = write_fire & (S_AXI_AWADDR[ADDR_WIDTH-1:2] == 0) & S_AXI_WSTRB[0] & S_AXI_WDATA[0];
+
+	always_ff @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			S_AXI_AWREADY 	<= 1'b0;
+			S_AXI_WREADY 	<= 1'b0;
+			S_AXI_BVALID 	<= 1'b0;
+		end
+		else
+		begin
+			S_AXI_AWREADY 	<= write_accept;
+			S_AXI_WREADY 	<= write_accept;
+			if (write_fire) S_AXI_BVALID <= 1'b1;
+			else if (S_AXI_BREADY) S_AXI_BVALID <= 1'b0;
+		end
+	end
+
+	// Reads the same way: ARREADY once ARVALID is seen, RDATA and RVALID a cycle after the handshake
+	wire read_fire = S_AXI_ARREADY & S_AXI_ARVALID;
+
+	always_ff @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			S_AXI_ARREADY 	<= 1'b0;
+			S_AXI_RVALID 	<= 1'b0;
+			S_AXI_RDATA 	<= 32'b0;
+		end
+		else
+		begin
+			S_AXI_ARREADY 	<= S_AXI_ARVALID & ~S_AXI_ARREADY & ~S_AXI_RVALID;
+			if (read_fire)
+			begin
+				S_AXI_RVALID 	<= 1'b1;
+				S_AXI_RDATA 	<= (S_AXI_ARADDR[ADDR_WIDTH-1:2] == CAPS) ? caps
+					: (S_AXI_ARADDR[ADDR_WIDTH-1:2] == 0 || S_AXI_ARADDR[ADDR_WIDTH-1:2] >= COUNTERS) ? 32'b0
+					: counter[S_AXI_ARADDR[ADDR_WIDTH-1:2]];
+			end
+			else if (S_AXI_RREADY) S_AXI_RVALID <= 1'b0;
+		end
+	end
+
+	genvar c;
+	generate
+		for (c = 1; c < COUNTERS; c = c + 1) begin : count
+			always_ff @(posedge ACLK) begin
+				if (~ARESETN | clear) counter[c] <= 32'b0;
+				else if (events[c]) counter[c] <= counter[c] + 1'b1;
+			end
+		end
+	endgenerate
+
+endmodule
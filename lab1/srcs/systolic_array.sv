@@ -0,0 +1,76 @@
+`timescale 1ns / 1ps
+/*
+----------------------------------------------------------------------------------
+--  Description : Output-stationary systolic array of rows x cols processing elements
+--	for myip_systolic_v1_0. Row i of A enters on the left of grid row i and moves one
+--	PE to the right per cycle, column j of B enters on top of grid column j and moves
+--	one PE down per cycle, and PE (i, j) accumulates (a * b) >> fixed_point of every
+--	pair passing through it. Each element of A is used by cols PEs and each element
+--	of B by rows PEs.
+--
+--	The caller skews the inputs: element k of row i on a_in k + i cycles after the
+--	first one, element k of column j on b_in k + j cycles after it, and 0 when there
+--	is nothing to feed (a 0 adds nothing). The accumulator of PE (i, j) holds its sum
+--	n + 1 + i + j cycles after the first input, behind the input and accumulator registers.
+--	clear zeroes all accumulators on the next edge, acc_out still shows them until then.
+----------------------------------------------------------------------------------
+*/
+
+module systolic_array
+#(
+	parameter rows = 4,
+	parameter cols = 4,
+	parameter width = 8,
+	parameter fixed_point = 8
+)
+(
+	input									clk,
+	input									aresetn,
+	input									clear,
+	input		[rows*width-1:0]			a_in,		// row i in [i*width +: width]
+	input		[cols*width-1:0]			b_in,		// column j in [j*width +: width]
+	output wire	[rows*cols*width-1:0]		acc_out		// PE (i, j) in [(i*cols + j)*width +: width]
+);
+
+	localparam axb_width = 2*width;
+
+	// Operands as they leave every PE, to the right and downwards
+	wire	[width-1:0]		a_right [0:rows-1][0:cols-1];
+	wire	[width-1:0]		b_down 	[0:rows-1][0:cols-1];
+
+	genvar i, j;
+	generate
+		for (i = 0; i < rows; i = i + 1) begin : grid_row
+			for (j = 0; j < cols; j = j + 1) begin : grid_col
+				wire 	[width-1:0]		a_left 	= (j == 0) ? a_in[i*width +: width] : a_right[i][(j == 0) ? 0 : j - 1];
+				wire 	[width-1:0]		b_up 	= (i == 0) ? b_in[j*width +: width] : b_down[(i == 0) ? 0 : i - 1][j];
+
+				reg 	[width-1:0]		a_reg;
+				reg 	[width-1:0]		b_reg;
+				reg 	[width-1:0]		acc;	// RES keeps the low width bits of the sum only
+				wire 	[axb_width-1:0]	axb = a_reg * b_reg;
+
+				always_ff @(posedge clk) begin
+					if (~aresetn)
+					begin
+						a_reg 	<= {width{1'b0}};
+						b_reg 	<= {width{1'b0}};
+						acc 	<= {width{1'b0}};
+					end
+					else
+					begin
+						a_reg 	<= a_left;
+						b_reg 	<= b_up;
+						if (clear) acc <= {width{1'b0}};
+						else acc 	<= acc + axb[fixed_point +: width];
+					end
+				end
+
+				assign a_right[i][j] 	= a_reg;
+				assign b_down[i][j] 	= b_reg;
+				assign acc_out[(i*cols + j)*width +: width] = acc;
+			end
+		end
+	endgenerate
+
+endmodule
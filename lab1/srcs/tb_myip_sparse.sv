@@ -0,0 +1,311 @@
+`timescale 1ns / 1ps
+/*
+----------------------------------------------------------------------------------
+--  Description : Testbench for myip_v1_0 with sparse = 1, A sent in compressed sparse
+--	row form behind B (lab3/srcs/dma/c/sparse.h): one word per non-zero,
+--	  [7:0] value  [23:8] column  [31] end of row (EOR) on the last word of the row
+--	and an empty row sent as a single zero word with EOR set. The jobs are made
+--	here, with their expected results RES[i] = sum((A[i][k] * B[k]) >> 8) & 0xFF,
+--	and sent back to back, the B of a job right after the last EOR of the one
+--	before, so the IP has to stop at that EOR. The first jobs are fixed cases:
+--	  0  empty rows: the first row, runs of two and three, and the last row
+--	  1  every row full, the last row ending on column n-1
+--	  2  every row empty, all results 0
+--	  3  one non-zero per row, on the diagonal, the last one on column n-1
+--	the rest are random, each with its own density and some empty rows.
+--	Inserts random gaps between S_AXIS beats and drops M_AXIS_TREADY at random,
+--	checks every result and TLAST, and reports one line of JSON:
+--	  SUMMARY {"tb":"tb_myip_sparse","m":16,"n":16,"jobs":40,...,"status":"PASS"}
+--	A run fails on a wrong result or TLAST, and on a deadlock: no beat moving on
+--	either stream for +timeout cycles while jobs are outstanding.
+--
+--	Run time options (plusargs):
+--	  +jobs=N        jobs to run, 4 to MAX_JOBS (default 40)
+--	  +valid_gap=P   percent chance of an idle cycle before each S_AXIS beat (0)
+--	  +ready_gap=P   percent chance of M_AXIS_TREADY low in a cycle (0)
+--	  +seed=S        seed of the jobs and of both random streams (1)
+--	  +timeout=C     cycles without a beat taken as a deadlock (10000)
+--	e.g. from lab1/srcs
+--	  iverilog -g2012 -o tb_sp tb_myip_sparse.sv myip_v1_0.sv matrix_multiply.sv mac.sv memory_RAM.sv perf_counters.sv
+--	  vvp tb_sp +valid_gap=20 +ready_gap=30 +seed=7
+--	or verilator --binary --timing --top-module tb_myip_sparse -Wno-fatal with the same sources.
+----------------------------------------------------------------------------------
+*/
+
+module tb_myip_sparse;
+
+	parameter 	m = 16;
+	parameter 	n = 16;
+	localparam 	width                   = 8;
+	localparam 	MAX_JOBS                = 64;
+	localparam 	MAX_JOB_WORDS           = n + m*n;
+	localparam 	EOR                     = 32'h80000000;
+
+	reg                          ACLK = 0;    // Synchronous clock
+	reg                          ARESETN;     // System reset, active low
+	// slave in interface
+	wire                         S_AXIS_TREADY;
+	reg      [31 : 0]            S_AXIS_TDATA;
+	reg                          S_AXIS_TLAST;
+	reg                          S_AXIS_TVALID;
+	// master out interface
+	wire                         M_AXIS_TVALID;
+	wire     [31 : 0]            M_AXIS_TDATA;
+	wire                         M_AXIS_TLAST;
+	reg                          M_AXIS_TREADY;
+
+	myip_v1_0 #(
+		.m(m),
+		.n(n),
+		.sparse(1)
+	) U1 (
+		.ACLK(ACLK),
+		.ARESETN(ARESETN),
+		.S_AXIS_TREADY(S_AXIS_TREADY),
+		.S_AXIS_TDATA(S_AXIS_TDATA),
+		.S_AXIS_TLAST(S_AXIS_TLAST),
+		.S_AXIS_TVALID(S_AXIS_TVALID),
+		.M_AXIS_TVALID(M_AXIS_TVALID),
+		.M_AXIS_TDATA(M_AXIS_TDATA),
+		.M_AXIS_TLAST(M_AXIS_TLAST),
+		.M_AXIS_TREADY(M_AXIS_TREADY),
+		// performance counters are not read here
+		.S_AXI_AWADDR(6'b0),
+		.S_AXI_AWVALID(1'b0),
+		.S_AXI_WDATA(32'b0),
+		.S_AXI_WSTRB(4'b0),
+		.S_AXI_WVALID(1'b0),
+		.S_AXI_BREADY(1'b1),
+		.S_AXI_ARADDR(6'b0),
+		.S_AXI_ARVALID(1'b0),
+		.S_AXI_RREADY(1'b1)
+	);
+
+	// every job's words one after the other, and the expected results
+	reg [31:0]      stream_memory [0:MAX_JOBS*MAX_JOB_WORDS-1];
+	reg             stream_last_memory [0:MAX_JOBS*MAX_JOB_WORDS-1];	// the last EOR of a job, sent with TLAST
+	reg [width-1:0] expected_memory [0:MAX_JOBS*m-1];
+	integer stream_words;
+
+	// Run time options
+	integer jobs;
+	integer valid_gap;
+	integer ready_gap;
+	integer seed;
+	integer timeout;
+
+	integer job_seed;
+	integer in_seed;
+	integer out_seed;
+
+	wire in_fire  = S_AXIS_TVALID & S_AXIS_TREADY;
+	wire out_fire = M_AXIS_TVALID & M_AXIS_TREADY;
+
+	always #50 ACLK = ~ACLK;
+
+	//// Jobs
+	reg [width-1:0] B [0:n-1];
+	reg [width-1:0] A_row [0:n-1];
+	integer empty_rows;
+	integer nonzeros;
+
+	// the percent chance of a non-zero in row i of job j, 0 for an empty row
+	function integer row_density(input integer j, input integer i, input integer job_density);
+		case (j)
+			0: row_density = (i == 0 || i == 2 || i == 3 || (i >= 5 && i <= 7) || i == m-1) ? 0 : 50;
+			1: row_density = 100;
+			2: row_density = 0;
+			default: row_density = ({$random(job_seed)} % 8 == 0) ? 0 : job_density;
+		endcase
+	endfunction
+
+	task make_job(input integer j);
+		integer i, k, density, job_density, last_col;
+		reg [31:0] sum;
+		begin
+			for (k = 0; k < n; k = k + 1)
+			begin
+				B[k] = {$random(job_seed)} % 256;
+				stream_memory[stream_words] = B[k];
+				stream_last_memory[stream_words] = 1'b0;
+				stream_words = stream_words + 1;
+			end
+			job_density = 5 + {$random(job_seed)} % 96;
+			for (i = 0; i < m; i = i + 1)
+			begin
+				density = row_density(j, i, job_density);
+				last_col = -1;
+				sum = 0;
+				for (k = 0; k < n; k = k + 1)
+				begin
+					A_row[k] = 0;
+					if (j == 3 ? (k == i || (i == m-1 && k == n-1)) : ({$random(job_seed)} % 100 < density))
+						A_row[k] = 1 + {$random(job_seed)} % 255;
+					if (A_row[k] != 0) last_col = k;
+				end
+				for (k = 0; k < n; k = k + 1)
+				begin
+					if (A_row[k] != 0)
+					begin
+						stream_memory[stream_words] = (k == last_col ? EOR : 0) | (k << 8) | A_row[k];
+						stream_last_memory[stream_words] = (k == last_col && i == m-1);
+						stream_words = stream_words + 1;
+						nonzeros = nonzeros + 1;
+						sum = sum + ((A_row[k] * B[k]) >> 8);
+					end
+				end
+				if (last_col < 0)
+				begin
+					stream_memory[stream_words] = EOR;
+					stream_last_memory[stream_words] = (i == m-1);
+					stream_words = stream_words + 1;
+					empty_rows = empty_rows + 1;
+				end
+				expected_memory[j*m + i] = sum[width-1:0];
+			end
+		end
+	endtask
+
+	//// Input: every job right after the one before, a random gap before a beat
+	// TVALID only drops after a handshake, AXI-Stream does not allow taking a beat back
+	integer in_word;
+
+	always @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			S_AXIS_TVALID 	<= 1'b0;
+			S_AXIS_TLAST 	<= 1'b0;
+			S_AXIS_TDATA 	<= 32'b0;
+			in_word 		= 0;
+		end
+		else
+		begin
+			if (in_fire) in_word = in_word + 1;
+			if (~S_AXIS_TVALID | in_fire)
+			begin
+				if (in_word < stream_words && !(valid_gap > 0 && {$random(in_seed)} % 100 < valid_gap))
+				begin
+					S_AXIS_TVALID 	<= 1'b1;
+					S_AXIS_TDATA 	<= stream_memory[in_word];
+					S_AXIS_TLAST 	<= stream_last_memory[in_word];
+				end
+				else
+				begin
+					S_AXIS_TVALID 	<= 1'b0;
+					S_AXIS_TLAST 	<= 1'b0;
+				end
+			end
+		end
+	end
+
+	//// Output: TREADY low at random, independent of TVALID
+	always @(posedge ACLK) begin
+		if (~ARESETN) M_AXIS_TREADY <= 1'b0;
+		else M_AXIS_TREADY <= !(ready_gap > 0 && {$random(out_seed)} % 100 < ready_gap);
+	end
+
+	//// Checking, on the values of the handshake at the clock edge
+	integer cycle;
+	integer in_count;				// words accepted by the IP
+	integer out_count;				// words taken from the IP
+	integer start_cycle;			// first input word
+	integer end_cycle;				// last output word
+	integer data_errors;
+	integer tlast_errors;
+	integer quiet;					// cycles since a beat last moved
+	reg 	deadlock;
+	reg 	done;
+
+	always @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			cycle 			= 0;
+			in_count 		= 0;
+			out_count 		= 0;
+			start_cycle 	= 0;
+			end_cycle 		= 0;
+			data_errors 	= 0;
+			tlast_errors 	= 0;
+			quiet 			= 0;
+			deadlock 		= 1'b0;
+			done 			= 1'b0;
+		end
+		else if (!done)
+		begin
+			if (in_fire)
+			begin
+				if (in_count == 0) start_cycle = cycle;
+				in_count = in_count + 1;
+			end
+
+			if (out_fire)
+			begin
+				if (M_AXIS_TDATA[width-1:0] !== expected_memory[out_count])
+				begin
+					if (data_errors < 10)
+						$display("Job %0d RES[%0d] = %0d, expected %0d", out_count / m, out_count % m,
+							M_AXIS_TDATA[width-1:0], expected_memory[out_count]);
+					data_errors = data_errors + 1;
+				end
+				if (M_AXIS_TLAST !== (out_count % m == m - 1))
+					tlast_errors = tlast_errors + 1;
+				end_cycle = cycle;
+				out_count = out_count + 1;
+			end
+
+			quiet = (in_fire | out_fire) ? 0 : quiet + 1;
+			if (quiet >= timeout) deadlock = 1'b1;
+			if (deadlock || out_count == jobs * m) done = 1'b1;
+			cycle = cycle + 1;
+		end
+	end
+
+	//// Summary
+	integer total_cycles;
+	integer j;
+	reg 	pass;
+
+	initial
+	begin
+		if (!$value$plusargs("jobs=%d", jobs)) jobs = 40;
+		if (!$value$plusargs("valid_gap=%d", valid_gap)) valid_gap = 0;
+		if (!$value$plusargs("ready_gap=%d", ready_gap)) ready_gap = 0;
+		if (!$value$plusargs("seed=%d", seed)) seed = 1;
+		if (!$value$plusargs("timeout=%d", timeout)) timeout = 10000;
+		if (jobs < 4) jobs = 4;
+		if (jobs > MAX_JOBS) jobs = MAX_JOBS;
+		job_seed = seed;
+		in_seed = seed ^ 32'h3c3c3c3c;
+		out_seed = seed ^ 32'h5a5a5a5a;
+
+		stream_words = 0;
+		empty_rows = 0;
+		nonzeros = 0;
+		for (j = 0; j < jobs; j = j + 1) make_job(j);
+
+		#25
+		ARESETN = 1'b0;
+		#200
+		ARESETN = 1'b1;
+
+		wait (done);
+
+		total_cycles = end_cycle - start_cycle + 1;
+		pass = !deadlock && data_errors == 0 && tlast_errors == 0 && in_count == stream_words;
+
+		if (deadlock)
+			$display("Deadlock: no beat for %0d cycles, %0d of %0d input and %0d of %0d output words moved",
+				timeout, in_count, stream_words, out_count, jobs * m);
+		$display("SUMMARY {\"tb\":\"tb_myip_sparse\",\"m\":%0d,\"n\":%0d,\"jobs\":%0d,\"jobs_done\":%0d,\"valid_gap\":%0d,\"ready_gap\":%0d,\"seed\":%0d,\"in_words\":%0d,\"nonzeros\":%0d,\"empty_rows\":%0d,\"cycles\":%0d,\"cycles_per_job\":%0.2f,\"data_errors\":%0d,\"tlast_errors\":%0d,\"deadlock\":%0d,\"status\":\"%0s\"}",
+			m, n, jobs, out_count / m, valid_gap, ready_gap, seed, in_count, nonzeros, empty_rows,
+			total_cycles, 1.0 * total_cycles / jobs, data_errors, tlast_errors, deadlock, pass ? "PASS" : "FAIL");
+
+		if (pass)
+			$display("Test Passed.");
+		else
+			$display("Test Failed.");
+
+		$finish;
+	end
+
+endmodule
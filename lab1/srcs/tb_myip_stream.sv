@@ -0,0 +1,336 @@
+`timescale 1ns / 1ps
+/*
+----------------------------------------------------------------------------------
+--  Description : Testbench for myip_stream_v1_0. Sends B with TDATA[31] (LOAD_B) on
+--	its first word, then rows of A in chunks of +chunk rows, TLAST on the last word
+--	of every chunk as the MM2S transfers of lab3/srcs/dma/c/stream.c end, and checks
+--	every result, RES = sum((A * B) >> 8) & 0xFF with the B loaded last, and that
+--	only the result of the last row of a chunk carries TLAST. B is loaded again
+--	before every 4th chunk, as the firmware does after a reset, and between two
+--	rows inside every 5th chunk, which the IP allows as well.
+--	M_AXIS_TREADY is held low for +hold cycles out of every +period, and dropped
+--	at random in between, so the 2**RES_depth_bits result slots fill up and S_AXIS
+--	has to stop taking rows. Rows started and not yet answered are counted from the
+--	handshakes: the run fails if they ever exceed the slots, or if the slots never
+--	filled with S_AXIS waiting while +hold is given. Random gaps between S_AXIS beats.
+--	Reports one line of JSON:
+--	  SUMMARY {"tb":"tb_myip_stream","n":8,"res_slots":4,"rows":200,...,"status":"PASS"}
+--	A run fails on a wrong result or TLAST, and on a deadlock: no beat moving on
+--	either stream for +timeout cycles while rows are outstanding.
+--
+--	Run time options (plusargs):
+--	  +rows=N        rows of A (default 200)
+--	  +chunk=C       rows per chunk (default 7)
+--	  +valid_gap=P   percent chance of an idle cycle before each S_AXIS beat (0)
+--	  +ready_gap=P   percent chance of M_AXIS_TREADY low in a cycle (0)
+--	  +hold=H        cycles of M_AXIS_TREADY low in every period, 0 for none (60)
+--	  +period=T      of the holds, in cycles (400)
+--	  +seed=S        seed of the data and of both random streams (1)
+--	  +timeout=C     cycles without a beat taken as a deadlock (10000)
+--	e.g. from lab1/srcs
+--	  iverilog -g2012 -o tb_st tb_myip_stream.sv myip_stream_v1_0.sv mac.sv memory_RAM.sv
+--	  vvp tb_st +chunk=5 +valid_gap=20 +ready_gap=30
+--	or verilator --binary --timing --top-module tb_myip_stream -Wno-fatal with the same sources.
+----------------------------------------------------------------------------------
+*/
+
+module tb_myip_stream;
+
+	parameter 	n = 8;
+	parameter 	RES_depth_bits = 2;
+	localparam 	width                   = 8;
+	localparam 	RES_SLOTS               = 2**RES_depth_bits;
+	localparam 	MAX_ROWS                = 1024;
+	localparam 	MAX_WORDS               = MAX_ROWS * n + (MAX_ROWS / 4 + 1) * n;
+	localparam 	LOAD_B                  = 32'h80000000;
+
+	reg                          ACLK = 0;    // Synchronous clock
+	reg                          ARESETN;     // System reset, active low
+	// slave in interface
+	wire                         S_AXIS_TREADY;
+	reg      [31 : 0]            S_AXIS_TDATA;
+	reg                          S_AXIS_TLAST;
+	reg                          S_AXIS_TVALID;
+	// master out interface
+	wire                         M_AXIS_TVALID;
+	wire     [31 : 0]            M_AXIS_TDATA;
+	wire                         M_AXIS_TLAST;
+	reg                          M_AXIS_TREADY;
+
+	myip_stream_v1_0 #(
+		.n(n),
+		.RES_depth_bits(RES_depth_bits)
+	) U1 (
+		.ACLK(ACLK),
+		.ARESETN(ARESETN),
+		.S_AXIS_TREADY(S_AXIS_TREADY),
+		.S_AXIS_TDATA(S_AXIS_TDATA),
+		.S_AXIS_TLAST(S_AXIS_TLAST),
+		.S_AXIS_TVALID(S_AXIS_TVALID),
+		.M_AXIS_TVALID(M_AXIS_TVALID),
+		.M_AXIS_TDATA(M_AXIS_TDATA),
+		.M_AXIS_TLAST(M_AXIS_TLAST),
+		.M_AXIS_TREADY(M_AXIS_TREADY)
+	);
+
+	// every word in order with its TLAST and whether it starts a row, and the expected results
+	reg [31:0]      stream_memory [0:MAX_WORDS-1];
+	reg             stream_last_memory [0:MAX_WORDS-1];
+	reg             stream_row_start_memory [0:MAX_WORDS-1];
+	reg [width-1:0] expected_memory [0:MAX_ROWS-1];
+	reg             expected_last_memory [0:MAX_ROWS-1];
+	integer stream_words;
+	integer b_loads;
+
+	// Run time options
+	integer rows;
+	integer chunk;
+	integer valid_gap;
+	integer ready_gap;
+	integer hold;
+	integer period;
+	integer seed;
+	integer timeout;
+
+	integer data_seed;
+	integer in_seed;
+	integer out_seed;
+
+	wire in_fire  = S_AXIS_TVALID & S_AXIS_TREADY;
+	wire out_fire = M_AXIS_TVALID & M_AXIS_TREADY;
+
+	always #50 ACLK = ~ACLK;
+
+	//// Stream
+	reg [width-1:0] B [0:n-1];
+
+	task put_word(input [31:0] word, input last, input row_start);
+		begin
+			stream_memory[stream_words] = word;
+			stream_last_memory[stream_words] = last;
+			stream_row_start_memory[stream_words] = row_start;
+			stream_words = stream_words + 1;
+		end
+	endtask
+
+	// a new B, LOAD_B on its first word, TLAST on its last when sent on its own
+	task load_b(input last);
+		integer k;
+		begin
+			for (k = 0; k < n; k = k + 1)
+			begin
+				B[k] = {$random(data_seed)} % 256;
+				put_word((k == 0 ? LOAD_B : 0) | B[k], last && k == n-1, 1'b0);
+			end
+			b_loads = b_loads + 1;
+		end
+	endtask
+
+	task make_stream;
+		integer row, k, chunk_row, chunk_index;
+		reg [width-1:0] a;
+		reg [31:0] sum;
+		begin
+			stream_words = 0;
+			b_loads = 0;
+			load_b(1'b1);
+			chunk_index = 0;
+			chunk_row = 0;
+			for (row = 0; row < rows; row = row + 1)
+			begin
+				if (chunk_row == 0 && chunk_index % 4 == 3) load_b(1'b1);
+				if (chunk_row == 2 && chunk_index % 5 == 4) load_b(1'b0);
+				sum = 0;
+				for (k = 0; k < n; k = k + 1)
+				begin
+					a = {$random(data_seed)} % 256;
+					sum = sum + ((a * B[k]) >> 8);
+					put_word(a, k == n-1 && (chunk_row == chunk-1 || row == rows-1), k == 0);
+				end
+				expected_memory[row] = sum[width-1:0];
+				expected_last_memory[row] = chunk_row == chunk-1 || row == rows-1;
+				chunk_row = chunk_row + 1;
+				if (chunk_row == chunk)
+				begin
+					chunk_row = 0;
+					chunk_index = chunk_index + 1;
+				end
+			end
+		end
+	endtask
+
+	//// Input: one word after the other, a random gap before a beat
+	// TVALID only drops after a handshake, AXI-Stream does not allow taking a beat back
+	integer in_word;
+
+	always @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			S_AXIS_TVALID 	<= 1'b0;
+			S_AXIS_TLAST 	<= 1'b0;
+			S_AXIS_TDATA 	<= 32'b0;
+			in_word 		= 0;
+		end
+		else
+		begin
+			if (in_fire) in_word = in_word + 1;
+			if (~S_AXIS_TVALID | in_fire)
+			begin
+				if (in_word < stream_words && !(valid_gap > 0 && {$random(in_seed)} % 100 < valid_gap))
+				begin
+					S_AXIS_TVALID 	<= 1'b1;
+					S_AXIS_TDATA 	<= stream_memory[in_word];
+					S_AXIS_TLAST 	<= stream_last_memory[in_word];
+				end
+				else
+				begin
+					S_AXIS_TVALID 	<= 1'b0;
+					S_AXIS_TLAST 	<= 1'b0;
+				end
+			end
+		end
+	end
+
+	//// Output: TREADY held low at the start of every period, and at random
+	integer ready_cycle;
+
+	always @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			M_AXIS_TREADY 	<= 1'b0;
+			ready_cycle 	= 0;
+		end
+		else
+		begin
+			M_AXIS_TREADY 	<= !((hold > 0 && ready_cycle % period < hold) || (ready_gap > 0 && {$random(out_seed)} % 100 < ready_gap));
+			ready_cycle 	= ready_cycle + 1;
+		end
+	end
+
+	//// Checking, on the values of the handshake at the clock edge
+	integer cycle;
+	integer in_count;				// words accepted by the IP
+	integer out_count;				// results taken from the IP
+	integer start_cycle;			// first input word
+	integer end_cycle;				// last result
+	integer open_rows;				// rows started and not yet answered
+	integer open_rows_max;
+	integer slots_full_cycles;		// S_AXIS_TVALID high and held off with every slot taken
+	integer data_errors;
+	integer tlast_errors;
+	integer quiet;					// cycles since a beat last moved
+	reg 	deadlock;
+	reg 	done;
+
+	always @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			cycle 				= 0;
+			in_count 			= 0;
+			out_count 			= 0;
+			start_cycle 		= 0;
+			end_cycle 			= 0;
+			open_rows 			= 0;
+			open_rows_max 		= 0;
+			slots_full_cycles 	= 0;
+			data_errors 		= 0;
+			tlast_errors 		= 0;
+			quiet 				= 0;
+			deadlock 			= 1'b0;
+			done 				= 1'b0;
+		end
+		else if (!done)
+		begin
+			if (S_AXIS_TVALID & ~S_AXIS_TREADY & open_rows == RES_SLOTS) slots_full_cycles = slots_full_cycles + 1;
+
+			if (in_fire)
+			begin
+				if (in_count == 0) start_cycle = cycle;
+				if (stream_row_start_memory[in_count]) open_rows = open_rows + 1;
+				in_count = in_count + 1;
+			end
+
+			if (out_fire)
+			begin
+				if (M_AXIS_TDATA[width-1:0] !== expected_memory[out_count])
+				begin
+					if (data_errors < 10)
+						$display("Row %0d RES = %0d, expected %0d", out_count, M_AXIS_TDATA[width-1:0], expected_memory[out_count]);
+					data_errors = data_errors + 1;
+				end
+				if (M_AXIS_TLAST !== expected_last_memory[out_count])
+				begin
+					if (tlast_errors < 10)
+						$display("Row %0d TLAST = %0d, expected %0d", out_count, M_AXIS_TLAST, expected_last_memory[out_count]);
+					tlast_errors = tlast_errors + 1;
+				end
+				open_rows = open_rows - 1;
+				end_cycle = cycle;
+				out_count = out_count + 1;
+			end
+
+			if (open_rows > open_rows_max) open_rows_max = open_rows;
+
+			quiet = (in_fire | out_fire) ? 0 : quiet + 1;
+			if (quiet >= timeout) deadlock = 1'b1;
+			if (deadlock || out_count == rows) done = 1'b1;
+			cycle = cycle + 1;
+		end
+	end
+
+	//// Summary
+	integer total_cycles;
+	reg 	pass;
+
+	initial
+	begin
+		if (!$value$plusargs("rows=%d", rows)) rows = 200;
+		if (!$value$plusargs("chunk=%d", chunk)) chunk = 7;
+		if (!$value$plusargs("valid_gap=%d", valid_gap)) valid_gap = 0;
+		if (!$value$plusargs("ready_gap=%d", ready_gap)) ready_gap = 0;
+		if (!$value$plusargs("hold=%d", hold)) hold = 60;
+		if (!$value$plusargs("period=%d", period)) period = 400;
+		if (!$value$plusargs("seed=%d", seed)) seed = 1;
+		if (!$value$plusargs("timeout=%d", timeout)) timeout = 10000;
+		if (rows < 1) rows = 1;
+		if (rows > MAX_ROWS) rows = MAX_ROWS;
+		if (chunk < 1) chunk = 1;
+		if (period < 1) period = 1;
+		data_seed = seed;
+		in_seed = seed ^ 32'h3c3c3c3c;
+		out_seed = seed ^ 32'h5a5a5a5a;
+
+		make_stream;
+
+		#25
+		ARESETN = 1'b0;
+		#200
+		ARESETN = 1'b1;
+
+		wait (done);
+
+		total_cycles = end_cycle - start_cycle + 1;
+		pass = !deadlock && data_errors == 0 && tlast_errors == 0 && in_count == stream_words
+			&& open_rows_max <= RES_SLOTS && (hold == 0 || slots_full_cycles > 0);
+
+		if (deadlock)
+			$display("Deadlock: no beat for %0d cycles, %0d of %0d input words and %0d of %0d results moved",
+				timeout, in_count, stream_words, out_count, rows);
+		if (open_rows_max > RES_SLOTS)
+			$display("%0d rows open at once, the IP has %0d result slots", open_rows_max, RES_SLOTS);
+		if (hold > 0 && slots_full_cycles == 0)
+			$display("The result slots never filled with S_AXIS waiting, raise +hold");
+		$display("SUMMARY {\"tb\":\"tb_myip_stream\",\"n\":%0d,\"res_slots\":%0d,\"rows\":%0d,\"rows_done\":%0d,\"chunk\":%0d,\"b_loads\":%0d,\"valid_gap\":%0d,\"ready_gap\":%0d,\"hold\":%0d,\"period\":%0d,\"seed\":%0d,\"cycles\":%0d,\"cycles_per_row\":%0.2f,\"open_rows_max\":%0d,\"slots_full_cycles\":%0d,\"data_errors\":%0d,\"tlast_errors\":%0d,\"deadlock\":%0d,\"status\":\"%0s\"}",
+			n, RES_SLOTS, rows, out_count, chunk, b_loads, valid_gap, ready_gap, hold, period, seed,
+			total_cycles, 1.0 * total_cycles / rows, open_rows_max, slots_full_cycles,
+			data_errors, tlast_errors, deadlock, pass ? "PASS" : "FAIL");
+
+		if (pass)
+			$display("Test Passed.");
+		else
+			$display("Test Failed.");
+
+		$finish;
+	end
+
+endmodule
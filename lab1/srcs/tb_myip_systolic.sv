@@ -0,0 +1,247 @@
+`timescale 1ns / 1ps
+/*
+----------------------------------------------------------------------------------
+--  Description : Testbench for myip_systolic_v1_0. Replays the vectors of
+--	test_systolic_input.mem, A row-major then B row-major (n rows of p), against
+--	the golden results of test_systolic_result_expected.mem, RES row-major (m rows
+--	of p), TLAST on the last. Both were written by tools/gen_vectors, whose results
+--	come from MatBinGolden (tools/matbin.h):
+--	  g++ -O3 -std=c++17 -o gen_vectors tools/gen_vectors.cpp
+--	  gen_vectors --m 16 --n 8 --p 4 --count 10 --format mem --out DIR
+--	and renamed from test_input.mem / test_result_expected.mem. m, n and p must be
+--	those of the files, grid_rows any divisor of m. Jobs run back to back, the A of
+--	a job following the last B word of the one before, with random gaps between
+--	S_AXIS beats and M_AXIS_TREADY drops, and one line of JSON is reported:
+--	  SUMMARY {"tb":"tb_myip_systolic","m":16,"n":8,"p":4,"grid_rows":4,...,"status":"PASS"}
+--	A run fails on a wrong result or TLAST, and on a deadlock: no beat moving on
+--	either stream for +timeout cycles while jobs are outstanding.
+--
+--	Run time options (plusargs):
+--	  +jobs=N        jobs to run (default 20)
+--	  +valid_gap=P   percent chance of an idle cycle before each S_AXIS beat (0)
+--	  +ready_gap=P   percent chance of M_AXIS_TREADY low in a cycle (0)
+--	  +seed=S        seed of both random streams (1)
+--	  +timeout=C     cycles without a beat taken as a deadlock (10000)
+--	  +input=FILE    vectors (test_systolic_input.mem)
+--	  +expected=FILE golden results (test_systolic_result_expected.mem)
+--	e.g. from lab1/srcs
+--	  iverilog -g2012 -o tb_sys tb_myip_systolic.sv myip_systolic_v1_0.sv systolic_array.sv mac.sv memory_RAM.sv
+--	  vvp tb_sys +valid_gap=20 +ready_gap=30
+--	or, p = 1 on the vectors of tb_myip_v1_0:
+--	  iverilog -g2012 -Ptb_myip_systolic.m=32 -Ptb_myip_systolic.n=32 -Ptb_myip_systolic.p=1 ...
+--	  vvp tb_sys +input=test_input.mem +expected=test_result_expected.mem
+--	or verilator --binary --timing --top-module tb_myip_systolic -Wno-fatal with the same sources.
+----------------------------------------------------------------------------------
+*/
+
+module tb_myip_systolic;
+
+	parameter 	m = 16;
+	parameter 	n = 8;
+	parameter 	p = 4;
+	parameter 	grid_rows = 4;
+	localparam 	NUMBER_OF_TEST_VECTORS  = 10;
+	localparam 	NUMBER_OF_INPUT_WORDS   = m*n + n*p;
+	localparam 	NUMBER_OF_OUTPUT_WORDS  = m*p;
+	localparam 	width                   = 8;
+
+	reg                          ACLK = 0;    // Synchronous clock
+	reg                          ARESETN;     // System reset, active low
+	// slave in interface
+	wire                         S_AXIS_TREADY;
+	reg      [31 : 0]            S_AXIS_TDATA;
+	reg                          S_AXIS_TLAST;
+	reg                          S_AXIS_TVALID;
+	// master out interface
+	wire                         M_AXIS_TVALID;
+	wire     [31 : 0]            M_AXIS_TDATA;
+	wire                         M_AXIS_TLAST;
+	reg                          M_AXIS_TREADY;
+
+	myip_systolic_v1_0 #(
+		.m(m),
+		.n(n),
+		.p(p),
+		.grid_rows(grid_rows)
+	) U1 (
+		.ACLK(ACLK),
+		.ARESETN(ARESETN),
+		.S_AXIS_TREADY(S_AXIS_TREADY),
+		.S_AXIS_TDATA(S_AXIS_TDATA),
+		.S_AXIS_TLAST(S_AXIS_TLAST),
+		.S_AXIS_TVALID(S_AXIS_TVALID),
+		.M_AXIS_TVALID(M_AXIS_TVALID),
+		.M_AXIS_TDATA(M_AXIS_TDATA),
+		.M_AXIS_TLAST(M_AXIS_TLAST),
+		.M_AXIS_TREADY(M_AXIS_TREADY)
+	);
+
+	reg [width-1:0] test_input_memory [0:NUMBER_OF_TEST_VECTORS*NUMBER_OF_INPUT_WORDS-1];
+	reg [width-1:0] test_result_expected_memory [0:NUMBER_OF_TEST_VECTORS*NUMBER_OF_OUTPUT_WORDS-1];
+
+	// Run time options
+	integer jobs;
+	integer valid_gap;
+	integer ready_gap;
+	integer seed;
+	integer timeout;
+	reg [8*256-1:0] input_path;
+	reg [8*256-1:0] expected_path;
+
+	integer in_seed;
+	integer out_seed;
+
+	wire in_fire  = S_AXIS_TVALID & S_AXIS_TREADY;
+	wire out_fire = M_AXIS_TVALID & M_AXIS_TREADY;
+
+	always #50 ACLK = ~ACLK;
+
+	function [31:0] input_word(input integer word);
+		input_word = {{(32-width){1'b0}}, test_input_memory[((word / NUMBER_OF_INPUT_WORDS) % NUMBER_OF_TEST_VECTORS) * NUMBER_OF_INPUT_WORDS + word % NUMBER_OF_INPUT_WORDS]};
+	endfunction
+
+	function [width-1:0] expected_word(input integer word);
+		expected_word = test_result_expected_memory[((word / NUMBER_OF_OUTPUT_WORDS) % NUMBER_OF_TEST_VECTORS) * NUMBER_OF_OUTPUT_WORDS + word % NUMBER_OF_OUTPUT_WORDS];
+	endfunction
+
+	//// Input: every job right after the one before, a random gap before a beat
+	// TVALID only drops after a handshake, AXI-Stream does not allow taking a beat back
+	integer in_word;
+
+	always @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			S_AXIS_TVALID 	<= 1'b0;
+			S_AXIS_TLAST 	<= 1'b0;
+			S_AXIS_TDATA 	<= 32'b0;
+			in_word 		= 0;
+		end
+		else
+		begin
+			if (in_fire) in_word = in_word + 1;
+			if (~S_AXIS_TVALID | in_fire)
+			begin
+				if (in_word < jobs * NUMBER_OF_INPUT_WORDS && !(valid_gap > 0 && {$random(in_seed)} % 100 < valid_gap))
+				begin
+					S_AXIS_TVALID 	<= 1'b1;
+					S_AXIS_TDATA 	<= input_word(in_word);
+					S_AXIS_TLAST 	<= (in_word % NUMBER_OF_INPUT_WORDS) == NUMBER_OF_INPUT_WORDS - 1;
+				end
+				else
+				begin
+					S_AXIS_TVALID 	<= 1'b0;
+					S_AXIS_TLAST 	<= 1'b0;
+				end
+			end
+		end
+	end
+
+	//// Output: TREADY low at random, independent of TVALID
+	always @(posedge ACLK) begin
+		if (~ARESETN) M_AXIS_TREADY <= 1'b0;
+		else M_AXIS_TREADY <= !(ready_gap > 0 && {$random(out_seed)} % 100 < ready_gap);
+	end
+
+	//// Checking, on the values of the handshake at the clock edge
+	integer cycle;
+	integer in_count;				// words accepted by the IP
+	integer out_count;				// words taken from the IP
+	integer start_cycle;			// first input word
+	integer end_cycle;				// last output word
+	integer data_errors;
+	integer tlast_errors;
+	integer quiet;					// cycles since a beat last moved
+	reg 	deadlock;
+	reg 	done;
+
+	always @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			cycle 			= 0;
+			in_count 		= 0;
+			out_count 		= 0;
+			start_cycle 	= 0;
+			end_cycle 		= 0;
+			data_errors 	= 0;
+			tlast_errors 	= 0;
+			quiet 			= 0;
+			deadlock 		= 1'b0;
+			done 			= 1'b0;
+		end
+		else if (!done)
+		begin
+			if (in_fire)
+			begin
+				if (in_count == 0) start_cycle = cycle;
+				in_count = in_count + 1;
+			end
+
+			if (out_fire)
+			begin
+				if (M_AXIS_TDATA[width-1:0] !== expected_word(out_count))
+				begin
+					if (data_errors < 10)
+						$display("Job %0d RES[%0d][%0d] = %0d, expected %0d", out_count / NUMBER_OF_OUTPUT_WORDS,
+							(out_count % NUMBER_OF_OUTPUT_WORDS) / p, out_count % p, M_AXIS_TDATA[width-1:0],
+							expected_word(out_count));
+					data_errors = data_errors + 1;
+				end
+				if (M_AXIS_TLAST !== (out_count % NUMBER_OF_OUTPUT_WORDS == NUMBER_OF_OUTPUT_WORDS - 1))
+					tlast_errors = tlast_errors + 1;
+				end_cycle = cycle;
+				out_count = out_count + 1;
+			end
+
+			quiet = (in_fire | out_fire) ? 0 : quiet + 1;
+			if (quiet >= timeout) deadlock = 1'b1;
+			if (deadlock || out_count == jobs * NUMBER_OF_OUTPUT_WORDS) done = 1'b1;
+			cycle = cycle + 1;
+		end
+	end
+
+	//// Summary
+	integer total_cycles;
+	reg 	pass;
+
+	initial
+	begin
+		if (!$value$plusargs("jobs=%d", jobs)) jobs = 20;
+		if (!$value$plusargs("valid_gap=%d", valid_gap)) valid_gap = 0;
+		if (!$value$plusargs("ready_gap=%d", ready_gap)) ready_gap = 0;
+		if (!$value$plusargs("seed=%d", seed)) seed = 1;
+		if (!$value$plusargs("timeout=%d", timeout)) timeout = 10000;
+		if (!$value$plusargs("input=%s", input_path)) input_path = "test_systolic_input.mem";
+		if (!$value$plusargs("expected=%s", expected_path)) expected_path = "test_systolic_result_expected.mem";
+		in_seed = seed;
+		out_seed = seed ^ 32'h5a5a5a5a;
+
+		$display("Loading Memory.");
+		$readmemh(input_path, test_input_memory);
+		$readmemh(expected_path, test_result_expected_memory);
+		#25
+		ARESETN = 1'b0;
+		#200
+		ARESETN = 1'b1;
+
+		wait (done);
+
+		total_cycles = end_cycle - start_cycle + 1;
+		pass = !deadlock && data_errors == 0 && tlast_errors == 0;
+
+		if (deadlock)
+			$display("Deadlock: no beat for %0d cycles, %0d of %0d input and %0d of %0d output words moved",
+				timeout, in_count, jobs * NUMBER_OF_INPUT_WORDS, out_count, jobs * NUMBER_OF_OUTPUT_WORDS);
+		$display("SUMMARY {\"tb\":\"tb_myip_systolic\",\"m\":%0d,\"n\":%0d,\"p\":%0d,\"grid_rows\":%0d,\"jobs\":%0d,\"jobs_done\":%0d,\"valid_gap\":%0d,\"ready_gap\":%0d,\"seed\":%0d,\"cycles\":%0d,\"cycles_per_job\":%0.2f,\"data_errors\":%0d,\"tlast_errors\":%0d,\"deadlock\":%0d,\"status\":\"%0s\"}",
+			m, n, p, grid_rows, jobs, out_count / NUMBER_OF_OUTPUT_WORDS, valid_gap, ready_gap, seed,
+			total_cycles, (out_count >= NUMBER_OF_OUTPUT_WORDS) ? 1.0 * total_cycles / (out_count / NUMBER_OF_OUTPUT_WORDS) : 0.0,
+			data_errors, tlast_errors, deadlock, pass ? "PASS" : "FAIL");
+
+		if (pass)
+			$display("Test Passed.");
+		else
+			$display("Test Failed.");
+
+		$finish;
+	end
+
+endmodule
@@ -0,0 +1,298 @@
+`timescale 1ns / 1ps
+/*
+----------------------------------------------------------------------------------
+--  Description : Throughput testbench for myip_v1_0. Runs jobs back to back, the
+--	input of a job following the last input word of the one before with no idle
+--	cycles, while the results of earlier jobs are still being taken. Inserts random
+--	gaps between S_AXIS beats (TVALID low) and drops M_AXIS_TREADY at random, checks
+--	every result and TLAST against test_result_expected.mem, and reports cycles per
+--	job, words per cycle and latency as one line of JSON:
+--	  SUMMARY {"tb":"tb_myip_throughput","m":32,"n":32,"jobs":100,...,"status":"PASS"}
+--	A run fails on a wrong result or TLAST, and on a deadlock: no beat moving on
+--	either stream for +timeout cycles while jobs are outstanding.
+--
+--	Jobs replay the vectors of test_input.mem in turn, so m and n must be those of
+--	the .mem files (32 x 32). Run time options (plusargs):
+--	  +jobs=N        jobs to run (default 100)
+--	  +valid_gap=P   percent chance of an idle cycle before each S_AXIS beat (0)
+--	  +ready_gap=P   percent chance of M_AXIS_TREADY low in a cycle (0)
+--	  +seed=S        seed of both random streams (1)
+--	  +timeout=C     cycles without a beat taken as a deadlock (10000)
+--	  +summary=FILE  also write the SUMMARY JSON to FILE
+--	e.g. from lab1/srcs
+--	  iverilog -g2012 -o tb_tp tb_myip_throughput.sv myip_v1_0.sv matrix_multiply.sv mac.sv memory_RAM.sv perf_counters.sv
+--	  vvp tb_tp +jobs=200 +valid_gap=20 +ready_gap=30 +seed=7
+--	or verilator --binary --timing --top-module tb_myip_throughput -Wno-fatal with the same sources.
+----------------------------------------------------------------------------------
+*/
+
+module tb_myip_throughput;
+
+	parameter 	m = 32;
+	parameter 	n = 32;
+	localparam 	NUMBER_OF_TEST_VECTORS  = 10;
+	localparam 	NUMBER_OF_INPUT_WORDS   = m*n + n;
+	localparam 	NUMBER_OF_OUTPUT_WORDS  = m;
+	localparam 	width                   = 8;
+	localparam 	IN_FLIGHT               = 16;	// jobs between their first input and last output word, at most
+
+	reg                          ACLK = 0;    // Synchronous clock
+	reg                          ARESETN;     // System reset, active low
+	// slave in interface
+	wire                         S_AXIS_TREADY;
+	reg      [31 : 0]            S_AXIS_TDATA;
+	reg                          S_AXIS_TLAST;
+	reg                          S_AXIS_TVALID;
+	// master out interface
+	wire                         M_AXIS_TVALID;
+	wire     [31 : 0]            M_AXIS_TDATA;
+	wire                         M_AXIS_TLAST;
+	reg                          M_AXIS_TREADY;
+
+	myip_v1_0 #(
+		.m(m),
+		.n(n)
+	) U1 (
+		.ACLK(ACLK),
+		.ARESETN(ARESETN),
+		.S_AXIS_TREADY(S_AXIS_TREADY),
+		.S_AXIS_TDATA(S_AXIS_TDATA),
+		.S_AXIS_TLAST(S_AXIS_TLAST),
+		.S_AXIS_TVALID(S_AXIS_TVALID),
+		.M_AXIS_TVALID(M_AXIS_TVALID),
+		.M_AXIS_TDATA(M_AXIS_TDATA),
+		.M_AXIS_TLAST(M_AXIS_TLAST),
+		.M_AXIS_TREADY(M_AXIS_TREADY),
+		// performance counters are not read here
+		.S_AXI_AWADDR(6'b0),
+		.S_AXI_AWVALID(1'b0),
+		.S_AXI_WDATA(32'b0),
+		.S_AXI_WSTRB(4'b0),
+		.S_AXI_WVALID(1'b0),
+		.S_AXI_BREADY(1'b1),
+		.S_AXI_ARADDR(6'b0),
+		.S_AXI_ARVALID(1'b0),
+		.S_AXI_RREADY(1'b1)
+	);
+
+	reg [width-1:0] test_input_memory [0:NUMBER_OF_TEST_VECTORS*NUMBER_OF_INPUT_WORDS-1];
+	reg [width-1:0] test_result_expected_memory [0:NUMBER_OF_TEST_VECTORS*NUMBER_OF_OUTPUT_WORDS-1];
+
+	// Run time options
+	integer jobs;
+	integer valid_gap;
+	integer ready_gap;
+	integer seed;
+	integer timeout;
+	reg [8*256-1:0] summary_path;
+	reg has_summary_path;
+
+	integer in_seed;
+	integer out_seed;
+
+	wire in_fire  = S_AXIS_TVALID & S_AXIS_TREADY;
+	wire out_fire = M_AXIS_TVALID & M_AXIS_TREADY;
+
+	always #50 ACLK = ~ACLK;
+
+	function [31:0] input_word(input integer word);
+		input_word = {{(32-width){1'b0}}, test_input_memory[((word / NUMBER_OF_INPUT_WORDS) % NUMBER_OF_TEST_VECTORS) * NUMBER_OF_INPUT_WORDS + word % NUMBER_OF_INPUT_WORDS]};
+	endfunction
+
+	function [width-1:0] expected_word(input integer word);
+		expected_word = test_result_expected_memory[((word / NUMBER_OF_OUTPUT_WORDS) % NUMBER_OF_TEST_VECTORS) * NUMBER_OF_OUTPUT_WORDS + word % NUMBER_OF_OUTPUT_WORDS];
+	endfunction
+
+	//// Input: every job right after the one before, a random gap before a beat
+	// TVALID only drops after a handshake, AXI-Stream does not allow taking a beat back
+	integer in_word;
+
+	always @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			S_AXIS_TVALID 	<= 1'b0;
+			S_AXIS_TLAST 	<= 1'b0;
+			S_AXIS_TDATA 	<= 32'b0;
+			in_word 		= 0;
+		end
+		else
+		begin
+			if (in_fire) in_word = in_word + 1;
+			if (~S_AXIS_TVALID | in_fire)
+			begin
+				if (in_word < jobs * NUMBER_OF_INPUT_WORDS && !(valid_gap > 0 && {$random(in_seed)} % 100 < valid_gap))
+				begin
+					S_AXIS_TVALID 	<= 1'b1;
+					S_AXIS_TDATA 	<= input_word(in_word);
+					S_AXIS_TLAST 	<= (in_word % NUMBER_OF_INPUT_WORDS) == NUMBER_OF_INPUT_WORDS - 1;
+				end
+				else
+				begin
+					S_AXIS_TVALID 	<= 1'b0;
+					S_AXIS_TLAST 	<= 1'b0;
+				end
+			end
+		end
+	end
+
+	//// Output: TREADY low at random, independent of TVALID
+	always @(posedge ACLK) begin
+		if (~ARESETN) M_AXIS_TREADY <= 1'b0;
+		else M_AXIS_TREADY <= !(ready_gap > 0 && {$random(out_seed)} % 100 < ready_gap);
+	end
+
+	//// Checking and cycle accounting, on the values of the handshake at the clock edge
+	integer cycle;
+	integer in_count;				// words accepted by the IP
+	integer out_count;				// words taken from the IP
+	integer first_in_cycle [0:IN_FLIGHT-1];
+	integer start_cycle;			// first input word of the first job
+	integer first_done_cycle;		// last output word of the first job
+	integer end_cycle;				// last output word of the last job
+	integer latency;
+	integer latency_min;
+	integer latency_max;
+	real 	latency_sum;
+	integer data_errors;
+	integer tlast_errors;
+	integer in_backpressure;		// S_AXIS_TVALID high, S_AXIS_TREADY low
+	integer out_backpressure;		// M_AXIS_TVALID high, M_AXIS_TREADY low
+	integer quiet;					// cycles since a beat last moved
+	reg 	deadlock;
+	reg 	done;
+
+	always @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			cycle 				= 0;
+			in_count 			= 0;
+			out_count 			= 0;
+			start_cycle 		= 0;
+			first_done_cycle 	= 0;
+			end_cycle 			= 0;
+			latency_min 		= 0;
+			latency_max 		= 0;
+			latency_sum 		= 0.0;
+			data_errors 		= 0;
+			tlast_errors 		= 0;
+			in_backpressure 	= 0;
+			out_backpressure 	= 0;
+			quiet 				= 0;
+			deadlock 			= 1'b0;
+			done 				= 1'b0;
+		end
+		else if (!done)
+		begin
+			if (in_fire)
+			begin
+				if (in_count % NUMBER_OF_INPUT_WORDS == 0)
+				begin
+					first_in_cycle[(in_count / NUMBER_OF_INPUT_WORDS) % IN_FLIGHT] = cycle;
+					if (in_count == 0) start_cycle = cycle;
+				end
+				in_count = in_count + 1;
+			end
+
+			if (out_fire)
+			begin
+				if (M_AXIS_TDATA[width-1:0] !== expected_word(out_count))
+				begin
+					if (data_errors < 10)
+						$display("Job %0d RES[%0d] = %0d, expected %0d", out_count / NUMBER_OF_OUTPUT_WORDS,
+							out_count % NUMBER_OF_OUTPUT_WORDS, M_AXIS_TDATA[width-1:0], expected_word(out_count));
+					data_errors = data_errors + 1;
+				end
+				if (M_AXIS_TLAST !== (out_count % NUMBER_OF_OUTPUT_WORDS == NUMBER_OF_OUTPUT_WORDS - 1))
+					tlast_errors = tlast_errors + 1;
+
+				if (out_count % NUMBER_OF_OUTPUT_WORDS == NUMBER_OF_OUTPUT_WORDS - 1)
+				begin
+					latency = cycle - first_in_cycle[(out_count / NUMBER_OF_OUTPUT_WORDS) % IN_FLIGHT] + 1;
+					if (out_count < NUMBER_OF_OUTPUT_WORDS)
+					begin
+						first_done_cycle 	= cycle;
+						latency_min 		= latency;
+						latency_max 		= latency;
+					end
+					if (latency < latency_min) latency_min = latency;
+					if (latency > latency_max) latency_max = latency;
+					latency_sum = latency_sum + latency;
+					end_cycle = cycle;
+				end
+				out_count = out_count + 1;
+			end
+
+			if (S_AXIS_TVALID & ~S_AXIS_TREADY) in_backpressure = in_backpressure + 1;
+			if (M_AXIS_TVALID & ~M_AXIS_TREADY) out_backpressure = out_backpressure + 1;
+
+			quiet = (in_fire | out_fire) ? 0 : quiet + 1;
+			if (quiet >= timeout) deadlock = 1'b1;
+			if (deadlock || out_count == jobs * NUMBER_OF_OUTPUT_WORDS) done = 1'b1;
+			cycle = cycle + 1;
+		end
+	end
+
+	//// Summary
+	integer summary_file;
+	integer total_cycles;
+	real 	cycles_per_job;
+	real 	steady_cycles_per_job;
+	reg 	pass;
+
+	task write_summary(input integer fd);
+		$fdisplay(fd, "SUMMARY {\"tb\":\"tb_myip_throughput\",\"m\":%0d,\"n\":%0d,\"jobs\":%0d,\"jobs_done\":%0d,\"valid_gap\":%0d,\"ready_gap\":%0d,\"seed\":%0d,\"cycles\":%0d,\"cycles_per_job\":%0.2f,\"steady_cycles_per_job\":%0.2f,\"in_words_per_cycle\":%0.4f,\"out_words_per_cycle\":%0.4f,\"latency_min\":%0d,\"latency_avg\":%0.2f,\"latency_max\":%0d,\"in_backpressure\":%0d,\"out_backpressure\":%0d,\"data_errors\":%0d,\"tlast_errors\":%0d,\"deadlock\":%0d,\"status\":\"%0s\"}",
+			m, n, jobs, out_count / NUMBER_OF_OUTPUT_WORDS, valid_gap, ready_gap, seed, total_cycles,
+			cycles_per_job, steady_cycles_per_job,
+			total_cycles ? 1.0 * in_count / total_cycles : 0.0, total_cycles ? 1.0 * out_count / total_cycles : 0.0,
+			latency_min, out_count >= NUMBER_OF_OUTPUT_WORDS ? latency_sum / (out_count / NUMBER_OF_OUTPUT_WORDS) : 0.0, latency_max,
+			in_backpressure, out_backpressure, data_errors, tlast_errors, deadlock, pass ? "PASS" : "FAIL");
+	endtask
+
+	initial
+	begin
+		if (!$value$plusargs("jobs=%d", jobs)) jobs = 100;
+		if (!$value$plusargs("valid_gap=%d", valid_gap)) valid_gap = 0;
+		if (!$value$plusargs("ready_gap=%d", ready_gap)) ready_gap = 0;
+		if (!$value$plusargs("seed=%d", seed)) seed = 1;
+		if (!$value$plusargs("timeout=%d", timeout)) timeout = 10000;
+		has_summary_path = $value$plusargs("summary=%s", summary_path);
+		in_seed = seed;
+		out_seed = seed ^ 32'h5a5a5a5a;
+
+		$display("Loading Memory.");
+		$readmemh("test_input.mem", test_input_memory);
+		$readmemh("test_result_expected.mem", test_result_expected_memory);
+		#25
+		ARESETN = 1'b0;
+		#200
+		ARESETN = 1'b1;
+
+		wait (done);
+
+		total_cycles 			= end_cycle - start_cycle + 1;
+		cycles_per_job 			= (out_count >= NUMBER_OF_OUTPUT_WORDS) ? 1.0 * total_cycles / (out_count / NUMBER_OF_OUTPUT_WORDS) : 0.0;
+		// without the fill of the pipeline: the distance between the ends of the first and the last job
+		steady_cycles_per_job 	= (out_count >= 2 * NUMBER_OF_OUTPUT_WORDS)
+			? 1.0 * (end_cycle - first_done_cycle) / (out_count / NUMBER_OF_OUTPUT_WORDS - 1) : cycles_per_job;
+		pass = !deadlock && data_errors == 0 && tlast_errors == 0;
+
+		if (deadlock)
+			$display("Deadlock: no beat for %0d cycles, %0d of %0d input and %0d of %0d output words moved",
+				timeout, in_count, jobs * NUMBER_OF_INPUT_WORDS, out_count, jobs * NUMBER_OF_OUTPUT_WORDS);
+		write_summary(1);	// STDOUT (multichannel descriptor 1)
+		if (has_summary_path)
+		begin
+			summary_file = $fopen(summary_path, "w");
+			write_summary(summary_file);
+			$fclose(summary_file);
+		end
+
+		if (pass)
+			$display("Test Passed.");
+		else
+			$display("Test Failed.");
+
+		$finish;
+	end
+
+endmodule
@@ -0,0 +1,293 @@
+`timescale 1ns / 1ps
+/*
+----------------------------------------------------------------------------------
+--  Description : Testbench for myip_v1_0 with a wide stream, lanes = 8 or 16 elements
+--	of width bits per beat, element k of a beat in TDATA[k*width +: width]. A job is
+--	A row-major then B, packed into beats with no gap between the two, B padded
+--	with zeros to a whole beat, the results come back packed the same way, the
+--	last beat padded and carrying TLAST. The jobs are made here, with their
+--	expected results RES[i] = sum((A[i][k] * B[k]) >> 8) & 0xFF, and sent back to
+--	back. m and n are powers of two as matrix_multiply needs, and m*n at least two
+--	beats. The default m = 16, n = 8 sends B in a single beat, padded with lanes = 16;
+--	m = 8, n = 16 with lanes = 16 pads the result beat. The parameters are set with
+--	  -Ptb_myip_wide.lanes=16 (iverilog) or -Glanes=16 (verilator)
+--	Random gaps between S_AXIS beats and M_AXIS_TREADY drops, every valid lane of
+--	every result beat and TLAST checked, one line of JSON:
+--	  SUMMARY {"tb":"tb_myip_wide","m":16,"n":8,"lanes":8,"jobs":40,...,"status":"PASS"}
+--	A run fails on a wrong result or TLAST, and on a deadlock: no beat moving on
+--	either stream for +timeout cycles while jobs are outstanding.
+--
+--	Run time options (plusargs):
+--	  +jobs=N        jobs to run, 1 to MAX_JOBS (default 40)
+--	  +valid_gap=P   percent chance of an idle cycle before each S_AXIS beat (0)
+--	  +ready_gap=P   percent chance of M_AXIS_TREADY low in a cycle (0)
+--	  +seed=S        seed of the jobs and of both random streams (1)
+--	  +timeout=C     cycles without a beat taken as a deadlock (10000)
+--	e.g. from lab1/srcs
+--	  iverilog -g2012 -Ptb_myip_wide.lanes=16 -o tb_wide tb_myip_wide.sv myip_v1_0.sv matrix_multiply.sv mac.sv memory_RAM.sv perf_counters.sv
+--	  vvp tb_wide +valid_gap=20 +ready_gap=30
+--	or verilator --binary --timing --top-module tb_myip_wide -Glanes=16 -Wno-fatal with the same sources.
+----------------------------------------------------------------------------------
+*/
+
+module tb_myip_wide;
+
+	parameter 	m = 16;
+	parameter 	n = 8;
+	parameter 	lanes = 8;
+	localparam 	width                   = 8;
+	localparam 	AXIS_WIDTH              = lanes * width;
+	localparam 	A_BEATS                 = m*n / lanes;
+	localparam 	B_BEATS                 = (n + lanes - 1) / lanes;
+	localparam 	RES_BEATS               = (m + lanes - 1) / lanes;
+	localparam 	JOB_BEATS               = A_BEATS + B_BEATS;
+	localparam 	MAX_JOBS                = 64;
+
+	reg                          ACLK = 0;    // Synchronous clock
+	reg                          ARESETN;     // System reset, active low
+	// slave in interface
+	wire                         S_AXIS_TREADY;
+	reg      [AXIS_WIDTH-1 : 0]  S_AXIS_TDATA;
+	reg                          S_AXIS_TLAST;
+	reg                          S_AXIS_TVALID;
+	// master out interface
+	wire                         M_AXIS_TVALID;
+	wire     [AXIS_WIDTH-1 : 0]  M_AXIS_TDATA;
+	wire                         M_AXIS_TLAST;
+	reg                          M_AXIS_TREADY;
+
+	myip_v1_0 #(
+		.m(m),
+		.n(n),
+		.lanes(lanes)
+	) U1 (
+		.ACLK(ACLK),
+		.ARESETN(ARESETN),
+		.S_AXIS_TREADY(S_AXIS_TREADY),
+		.S_AXIS_TDATA(S_AXIS_TDATA),
+		.S_AXIS_TLAST(S_AXIS_TLAST),
+		.S_AXIS_TVALID(S_AXIS_TVALID),
+		.M_AXIS_TVALID(M_AXIS_TVALID),
+		.M_AXIS_TDATA(M_AXIS_TDATA),
+		.M_AXIS_TLAST(M_AXIS_TLAST),
+		.M_AXIS_TREADY(M_AXIS_TREADY),
+		// performance counters are not read here
+		.S_AXI_AWADDR(6'b0),
+		.S_AXI_AWVALID(1'b0),
+		.S_AXI_WDATA(32'b0),
+		.S_AXI_WSTRB(4'b0),
+		.S_AXI_WVALID(1'b0),
+		.S_AXI_BREADY(1'b1),
+		.S_AXI_ARADDR(6'b0),
+		.S_AXI_ARVALID(1'b0),
+		.S_AXI_RREADY(1'b1)
+	);
+
+	// the beats of every job one after the other, and the expected result beats
+	reg [AXIS_WIDTH-1:0] stream_memory [0:MAX_JOBS*JOB_BEATS-1];
+	reg [AXIS_WIDTH-1:0] expected_memory [0:MAX_JOBS*RES_BEATS-1];
+
+	// Run time options
+	integer jobs;
+	integer valid_gap;
+	integer ready_gap;
+	integer seed;
+	integer timeout;
+
+	integer job_seed;
+	integer in_seed;
+	integer out_seed;
+
+	wire in_fire  = S_AXIS_TVALID & S_AXIS_TREADY;
+	wire out_fire = M_AXIS_TVALID & M_AXIS_TREADY;
+
+	always #50 ACLK = ~ACLK;
+
+	//// Jobs
+	reg [width-1:0] A [0:m*n-1];
+	reg [width-1:0] B [0:n-1];
+
+	task make_job(input integer j);
+		integer i, k, e;
+		reg [31:0] sum;
+		reg [AXIS_WIDTH-1:0] beat;
+		begin
+			for (e = 0; e < m*n; e = e + 1) A[e] = {$random(job_seed)} % 256;
+			for (k = 0; k < n; k = k + 1) B[k] = {$random(job_seed)} % 256;
+
+			for (e = 0; e < A_BEATS; e = e + 1)
+			begin
+				for (k = 0; k < lanes; k = k + 1) beat[k*width +: width] = A[e*lanes + k];
+				stream_memory[j*JOB_BEATS + e] = beat;
+			end
+			for (e = 0; e < B_BEATS; e = e + 1)
+			begin
+				for (k = 0; k < lanes; k = k + 1) beat[k*width +: width] = (e*lanes + k < n) ? B[e*lanes + k] : {width{1'b0}};
+				stream_memory[j*JOB_BEATS + A_BEATS + e] = beat;
+			end
+
+			beat = {AXIS_WIDTH{1'b0}};
+			for (i = 0; i < m; i = i + 1)
+			begin
+				sum = 0;
+				for (k = 0; k < n; k = k + 1) sum = sum + ((A[i*n + k] * B[k]) >> 8);
+				beat[(i % lanes)*width +: width] = sum[width-1:0];
+				if (i % lanes == lanes - 1 || i == m - 1)
+				begin
+					expected_memory[j*RES_BEATS + i / lanes] = beat;
+					beat = {AXIS_WIDTH{1'b0}};
+				end
+			end
+		end
+	endtask
+
+	// the lanes of result beat b of a job that hold a result, the rest is padding
+	function integer valid_lanes(input integer b);
+		valid_lanes = (b == RES_BEATS - 1) ? m - b*lanes : lanes;
+	endfunction
+
+	//// Input: every job right after the one before, a random gap before a beat
+	// TVALID only drops after a handshake, AXI-Stream does not allow taking a beat back
+	integer in_beat;
+
+	always @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			S_AXIS_TVALID 	<= 1'b0;
+			S_AXIS_TLAST 	<= 1'b0;
+			S_AXIS_TDATA 	<= {AXIS_WIDTH{1'b0}};
+			in_beat 		= 0;
+		end
+		else
+		begin
+			if (in_fire) in_beat = in_beat + 1;
+			if (~S_AXIS_TVALID | in_fire)
+			begin
+				if (in_beat < jobs * JOB_BEATS && !(valid_gap > 0 && {$random(in_seed)} % 100 < valid_gap))
+				begin
+					S_AXIS_TVALID 	<= 1'b1;
+					S_AXIS_TDATA 	<= stream_memory[in_beat];
+					S_AXIS_TLAST 	<= (in_beat % JOB_BEATS) == JOB_BEATS - 1;
+				end
+				else
+				begin
+					S_AXIS_TVALID 	<= 1'b0;
+					S_AXIS_TLAST 	<= 1'b0;
+				end
+			end
+		end
+	end
+
+	//// Output: TREADY low at random, independent of TVALID
+	always @(posedge ACLK) begin
+		if (~ARESETN) M_AXIS_TREADY <= 1'b0;
+		else M_AXIS_TREADY <= !(ready_gap > 0 && {$random(out_seed)} % 100 < ready_gap);
+	end
+
+	//// Checking, on the values of the handshake at the clock edge
+	integer cycle;
+	integer in_count;				// beats accepted by the IP
+	integer out_count;				// beats taken from the IP
+	integer start_cycle;			// first input beat
+	integer end_cycle;				// last output beat
+	integer data_errors;
+	integer tlast_errors;
+	integer quiet;					// cycles since a beat last moved
+	integer lane;
+	reg 	deadlock;
+	reg 	done;
+
+	always @(posedge ACLK) begin
+		if (~ARESETN)
+		begin
+			cycle 			= 0;
+			in_count 		= 0;
+			out_count 		= 0;
+			start_cycle 	= 0;
+			end_cycle 		= 0;
+			data_errors 	= 0;
+			tlast_errors 	= 0;
+			quiet 			= 0;
+			deadlock 		= 1'b0;
+			done 			= 1'b0;
+		end
+		else if (!done)
+		begin
+			if (in_fire)
+			begin
+				if (in_count == 0) start_cycle = cycle;
+				in_count = in_count + 1;
+			end
+
+			if (out_fire)
+			begin
+				for (lane = 0; lane < valid_lanes(out_count % RES_BEATS); lane = lane + 1)
+				begin
+					if (M_AXIS_TDATA[lane*width +: width] !== expected_memory[out_count][lane*width +: width])
+					begin
+						if (data_errors < 10)
+							$display("Job %0d RES[%0d] = %0d, expected %0d", out_count / RES_BEATS,
+								(out_count % RES_BEATS) * lanes + lane, M_AXIS_TDATA[lane*width +: width],
+								expected_memory[out_count][lane*width +: width]);
+						data_errors = data_errors + 1;
+					end
+				end
+				if (M_AXIS_TLAST !== (out_count % RES_BEATS == RES_BEATS - 1))
+					tlast_errors = tlast_errors + 1;
+				end_cycle = cycle;
+				out_count = out_count + 1;
+			end
+
+			quiet = (in_fire | out_fire) ? 0 : quiet + 1;
+			if (quiet >= timeout) deadlock = 1'b1;
+			if (deadlock || out_count == jobs * RES_BEATS) done = 1'b1;
+			cycle = cycle + 1;
+		end
+	end
+
+	//// Summary
+	integer total_cycles;
+	integer j;
+	reg 	pass;
+
+	initial
+	begin
+		if (!$value$plusargs("jobs=%d", jobs)) jobs = 40;
+		if (!$value$plusargs("valid_gap=%d", valid_gap)) valid_gap = 0;
+		if (!$value$plusargs("ready_gap=%d", ready_gap)) ready_gap = 0;
+		if (!$value$plusargs("seed=%d", seed)) seed = 1;
+		if (!$value$plusargs("timeout=%d", timeout)) timeout = 10000;
+		if (jobs < 1) jobs = 1;
+		if (jobs > MAX_JOBS) jobs = MAX_JOBS;
+		job_seed = seed;
+		in_seed = seed ^ 32'h3c3c3c3c;
+		out_seed = seed ^ 32'h5a5a5a5a;
+
+		for (j = 0; j < jobs; j = j + 1) make_job(j);
+
+		#25
+		ARESETN = 1'b0;
+		#200
+		ARESETN = 1'b1;
+
+		wait (done);
+
+		total_cycles = end_cycle - start_cycle + 1;
+		pass = !deadlock && data_errors == 0 && tlast_errors == 0 && in_count == jobs * JOB_BEATS;
+
+		if (deadlock)
+			$display("Deadlock: no beat for %0d cycles, %0d of %0d input and %0d of %0d output beats moved",
+				timeout, in_count, jobs * JOB_BEATS, out_count, jobs * RES_BEATS);
+		$display("SUMMARY {\"tb\":\"tb_myip_wide\",\"m\":%0d,\"n\":%0d,\"lanes\":%0d,\"jobs\":%0d,\"jobs_done\":%0d,\"valid_gap\":%0d,\"ready_gap\":%0d,\"seed\":%0d,\"in_beats\":%0d,\"out_beats\":%0d,\"cycles\":%0d,\"cycles_per_job\":%0.2f,\"data_errors\":%0d,\"tlast_errors\":%0d,\"deadlock\":%0d,\"status\":\"%0s\"}",
+			m, n, lanes, jobs, out_count / RES_BEATS, valid_gap, ready_gap, seed, in_count, out_count,
+			total_cycles, 1.0 * total_cycles / jobs, data_errors, tlast_errors, deadlock, pass ? "PASS" : "FAIL");
+
+		if (pass)
+			$display("Test Passed.");
+		else
+			$display("Test Failed.");
+
+		$finish;
+	end
+
+endmodule
@@ -4,7 +4,7 @@ import os
 
 def main():
     if len(sys.argv) != 3:
-        print("Usage: python gen_matrices.py m n")
+        print("Usage: python gen_matrices.py m n  (pip install -r requirements.txt for numpy)")
         return
 
     m: int = int(sys.argv[1])
@@ -19,14 +19,27 @@ char TERMINATE_TOKEN[] = "TERMINATE";
 int main()
 {
 	int Status = XST_SUCCESS;
-	Stats stats = {0, 0, 0};
+	Stats stats = {0};
+	XTime Start, End;
+
+#ifdef XPAR_UARTNS550_0_BASEADDR
+
+	Uart550_Setup();
+
+#endif
+
+	// One bring-up for the whole session, timed to show what each job saves
+	XTime_GetTime(&Start);
+	Status = InitSession(&FifoInstance, &TmrCtrInstance, TIMER_COUNTER_0);
+	XTime_GetTime(&End);
+	if (Status != XST_SUCCESS) {
+		xil_printf("FIFO or Timer Initialization Failed\r\n");
+		return XST_FAILURE;
+	}
+	stats.InitElapsed = TICKS_TO_TIMER_CYCLES(End - Start);
 
 	while (true) {
-		#ifndef SDT
-		Status = RunMatrixAssignment(&FifoInstance, FIFO_DEV_ID, &TmrCtrInstance, TMRCTR_DEVICE_ID, TIMER_COUNTER_0, &stats);
-		#else
-		Status = RunMatrixAssignment(&FifoInstance, XPAR_XLLFIFO_0_BASEADDR, &TmrCtrInstance, XTMRCTR_BASEADDRESS, TIMER_COUNTER_0, &stats);
-		#endif
+		Status = RunMatrixAssignment(&FifoInstance, &TmrCtrInstance, TIMER_COUNTER_0, &stats);
 		if (Status != XST_SUCCESS) {
 			xil_printf("Failed to execute\r\n");
 			xil_printf("--- Exiting main() ---\r\n");
@@ -37,77 +50,17 @@ int main()
 	return Status;
 }
 
-#ifndef SDT
-int RunMatrixAssignment(
-	XLlFifo *FifoInstancePtr, u16 FifoDeviceId, XTmrCtr *TmrCtrInstancePtr, u16 TmrCtrDeviceId, u8 TmrCtrNumber, Stats *stats
-)
-#else
-int RunMatrixAssignment(
-	XLlFifo *FifoInstancePtr, UINTPTR FifoBaseAddress, XTmrCtr *TmrCtrInstancePtr, UINTPTR TmrCtrBaseAddress, u8 TmrCtrNumber, Stats *stats
-)
-#endif
+int RunMatrixAssignment(XLlFifo *FifoInstancePtr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
 {
-	XLlFifo_Config *FifoConfig;
+	const MatMulKernelEntry *Kernel;
 	int Status;
-	Status = XST_SUCCESS;
 
-#ifdef XPAR_UARTNS550_0_BASEADDR
-
-	Uart550_Setup();
-
-#endif
-
-// Initialize Fifo
-#ifndef SDT
-	FifoConfig = XLlFfio_LookupConfig(FifoDeviceId);
-#else
-	FifoConfig = XLlFfio_LookupConfig(FifoBaseAddress);
-#endif
-	if (!FifoConfig) {
-#ifndef SDT
-		xil_printf("No config found for %d\r\n", FifoDeviceId);
-#endif
-		return XST_FAILURE;
-	}
-
-	Status = XLlFifo_CfgInitialize(FifoInstancePtr, FifoConfig, FifoConfig->BaseAddress);
+	Status = ResetSession(FifoInstancePtr, TmrCtrInstancePtr, TmrCtrNumber, stats);
 	if (Status != XST_SUCCESS) {
-		xil_printf("Initialization failed\r\n");
-		return Status;
-	}
-
-	Status = XLlFifo_Status(FifoInstancePtr);
-	XLlFifo_IntClear(FifoInstancePtr, 0xffffffff);
-	Status = XLlFifo_Status(FifoInstancePtr);
-	if(Status != 0x0) {
-		xil_printf("\n ERROR : Reset value of ISR0 : 0x%x\t"
-		    "Expected : 0x0\r\n",
-			    XLlFifo_Status(FifoInstancePtr));
+		xil_printf("FIFO or Timer bring-up failed\r\n");
 		return XST_FAILURE;
 	}
 
-	// Initialize Timer
-#ifndef SDT
-	Status = XTmrCtr_Initialize(TmrCtrInstancePtr, TmrCtrDeviceId);
-#else
-	Status = XTmrCtr_Initialize(TmrCtrInstancePtr, TmrCtrBaseAddress);
-#endif
-	if (Status != XST_SUCCESS) {
-		return XST_FAILURE;
-	}
-	/*
-	 * Perform a self-test to ensure that the hardware was built
-	 * correctly, use the 1st timer in the device (0)
-	 */
-	Status = XTmrCtr_SelfTest(TmrCtrInstancePtr, TmrCtrNumber);
-	if (Status != XST_SUCCESS) {
-		return XST_FAILURE;
-	}
-
-	// Default timer settings (count up, no auto reload, interrupt disabled)
-	XTmrCtr_SetOptions(TmrCtrInstancePtr, TmrCtrNumber, 0);
-	XTmrCtr_SetResetValue(TmrCtrInstancePtr, TmrCtrNumber, 0);
-
 	xil_printf("Ready! Please use RealTerm -> 'Send File' to send A.csv\r\n");
     Status = ReceiveCSVData(MatrixA, MatrixA_Size, stats);
     if (Status != XST_SUCCESS) {
@@ -138,7 +91,16 @@ int RunMatrixAssignment(
 		xil_printf("Receiving data failed");
 		return XST_FAILURE;
 	}
-	Status = performMatrixMultiplication(DestinationBuffer, MATRIX_A_ROWS, MATRIX_A_COLS, MATRIX_B_COLS, TmrCtrInstancePtr, TmrCtrNumber, stats);
+
+	// Pick the kernel for this job's number format once, outside the timed region
+	Kernel = LookupMatMulKernel(MATMUL_ELEMENT_BITS, MATMUL_FRACTION_BITS, MATMUL_ACCUMULATOR_BITS, MATMUL_SATURATE);
+	if (Kernel == NULL) {
+		xil_printf("No kernel for U%d Q%d ACC%d %s\r\n", MATMUL_ELEMENT_BITS, MATMUL_FRACTION_BITS,
+			MATMUL_ACCUMULATOR_BITS, MATMUL_SATURATE ? "SAT" : "WRAP");
+		return XST_FAILURE;
+	}
+
+	Status = performMatrixMultiplication(DestinationBuffer, Kernel, TmrCtrInstancePtr, TmrCtrNumber, stats);
 
 	if (Status != XST_SUCCESS) {
 		xil_printf("Matrix multiplication failed\r\n");
@@ -281,46 +243,41 @@ void MergeArrays(u32 *dest, u32 *A, int sizeA, u32 *B, int sizeB)
 }
 
 
-int performMatrixMultiplication(u32 *data, int A_rows, int A_cols, int B_cols, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
+int performMatrixMultiplication(u32 *data, const MatMulKernelEntry *Kernel, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
 {
 	u32 *A = data;
-	u32 *B = data + (A_rows * A_cols);
-	u32 RES[A_rows * B_cols];
+	u32 *B = data + MatrixA_Size;
+	u32 RES[MATRIX_A_ROWS * MATRIX_B_COLS];
 
-	for (int i = 0; i < A_rows * B_cols; i++) {
-		RES[i] = 0;
-	}
+	xil_printf("Using kernel %s\r\n", Kernel->Name);
 
 	XTmrCtr_Reset(TmrCtrInstancePtr, TmrCtrNumber);
 	XTmrCtr_Start(TmrCtrInstancePtr, TmrCtrNumber);
 
-	for (int i = 0; i < A_rows; i++) {
-		for (int j = 0; j < B_cols; j++) {
-			for (int k = 0; k < A_cols; k++) {
-				RES[i * B_cols + j] += (A[i * A_cols + k] * B[k * B_cols + j]) >> 8;
-			}
-		}
-	}
+	Kernel->Kernel(A, B, RES);
 
 	u32 MatMulElapsed = XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
 	XTmrCtr_Stop(TmrCtrInstancePtr, TmrCtrNumber);
 	stats->MatMulElapsed = MatMulElapsed;
 	xil_printf("MatMul elapsed: %u cycles\r\n", MatMulElapsed);
 
-	for (int i = 0; i < A_rows * B_cols; i++) {
-		DestinationBuffer[i] = RES[i] & 0xFF;
+	for (int i = 0; i < MATRIX_A_ROWS * MATRIX_B_COLS; i++) {
+		DestinationBuffer[i] = RES[i];
 	}
 
 	return XST_SUCCESS;
 }
 
 
+/* REINITS is only appended once a health check failed */
 void SendStats(Stats *stats)
 {
 	char buf[12];
-	const char *labels[] = {"STATS:TX=", ",RX=", ",MATMUL="};
-	u32 values[] = {stats->TxElapsed, stats->RxElapsed, stats->MatMulElapsed};
-	for (int l = 0; l < 3; l++) {
+	const char *labels[] = {"STATS:TX=", ",RX=", ",MATMUL=", ",INIT=", ",RESET=", ",REINITS="};
+	u32 values[] = {stats->TxElapsed, stats->RxElapsed, stats->MatMulElapsed,
+		stats->InitElapsed, stats->ResetElapsed, stats->Reinits};
+	int Fields = stats->Reinits ? 6 : 5;
+	for (int l = 0; l < Fields; l++) {
 		for (const char *p = labels[l]; *p != '\0'; p++)
 			XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
 		sprintf(buf, "%u", (unsigned int)values[l]);
@@ -349,3 +306,133 @@ void SendCSVResults(u32 *data, int rows, int cols)
 		XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, '\n');
 	}
 }
+
+
+/* The FIFO and the timer, from their configs, as every job used to */
+int InitSession(XLlFifo *FifoInstancePtr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber)
+{
+	int Status;
+
+#ifndef SDT
+	Status = InitFifo(FifoInstancePtr, FIFO_DEV_ID);
+#else
+	Status = InitFifo(FifoInstancePtr, XPAR_XLLFIFO_0_BASEADDR);
+#endif
+	if (Status != XST_SUCCESS) {
+		return Status;
+	}
+
+#ifndef SDT
+	return InitTmrCtr(TmrCtrInstancePtr, TMRCTR_DEVICE_ID, TmrCtrNumber);
+#else
+	return InitTmrCtr(TmrCtrInstancePtr, XTMRCTR_BASEADDRESS, TmrCtrNumber);
+#endif
+}
+
+
+/*
+ * Before each job: the FIFO must have no error pending and no word left over
+ * from the last job, and must read idle once its interrupts are cleared. The
+ * timer, stopped by every phase, must read its reset value after a reset. That is a few
+ * register accesses, against the driver lookups and the timer self-test of
+ * InitSession. Any failed check runs InitSession again and counts it in
+ * Reinits.
+ */
+int ResetSession(XLlFifo *FifoInstancePtr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
+{
+	int Status = XST_SUCCESS;
+	XTime Start, End;
+	bool Healthy;
+
+	XTime_GetTime(&Start);
+	Healthy = (XLlFifo_Status(FifoInstancePtr) & XLLF_INT_ERROR_MASK) == 0
+		&& XLlFifo_iRxOccupancy(FifoInstancePtr) == 0;
+	XLlFifo_IntClear(FifoInstancePtr, XLLF_INT_ALL_MASK);
+	Healthy = Healthy && XLlFifo_Status(FifoInstancePtr) == 0;
+
+	XTmrCtr_Reset(TmrCtrInstancePtr, TmrCtrNumber);
+	Healthy = Healthy && XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber) == 0;
+
+	if (!Healthy) {
+		xil_printf("FIFO or Timer not idle after the last job, bringing them up again\r\n");
+		stats->Reinits++;
+		Status = InitSession(FifoInstancePtr, TmrCtrInstancePtr, TmrCtrNumber);
+	}
+	XTime_GetTime(&End);
+	stats->ResetElapsed = TICKS_TO_TIMER_CYCLES(End - Start);
+
+	return Status;
+}
+
+
+#ifndef SDT
+int InitFifo(XLlFifo *FifoInstancePtr, u16 FifoDeviceId)
+#else
+int InitFifo(XLlFifo *FifoInstancePtr, UINTPTR FifoBaseAddress)
+#endif
+{
+	XLlFifo_Config *FifoConfig;
+	int Status;
+
+#ifndef SDT
+	FifoConfig = XLlFfio_LookupConfig(FifoDeviceId);
+#else
+	FifoConfig = XLlFfio_LookupConfig(FifoBaseAddress);
+#endif
+	if (!FifoConfig) {
+#ifndef SDT
+		xil_printf("No config found for %d\r\n", FifoDeviceId);
+#endif
+		return XST_FAILURE;
+	}
+
+	Status = XLlFifo_CfgInitialize(FifoInstancePtr, FifoConfig, FifoConfig->BaseAddress);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Initialization failed\r\n");
+		return Status;
+	}
+
+	XLlFifo_IntClear(FifoInstancePtr, 0xffffffff);
+	Status = XLlFifo_Status(FifoInstancePtr);
+	if(Status != 0x0) {
+		xil_printf("\n ERROR : Reset value of ISR0 : 0x%x\t"
+		    "Expected : 0x0\r\n",
+			    XLlFifo_Status(FifoInstancePtr));
+		return XST_FAILURE;
+	}
+
+	return XST_SUCCESS;
+}
+
+
+#ifndef SDT
+int InitTmrCtr(XTmrCtr *TmrCtrInstancePtr, u16 TmrCtrDeviceId, u8 TmrCtrNumber)
+#else
+int InitTmrCtr(XTmrCtr *TmrCtrInstancePtr, UINTPTR TmrCtrBaseAddress, u8 TmrCtrNumber)
+#endif
+{
+	int Status;
+
+#ifndef SDT
+	Status = XTmrCtr_Initialize(TmrCtrInstancePtr, TmrCtrDeviceId);
+#else
+	Status = XTmrCtr_Initialize(TmrCtrInstancePtr, TmrCtrBaseAddress);
+#endif
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	/*
+	 * Perform a self-test to ensure that the hardware was built
+	 * correctly, use the 1st timer in the device (0)
+	 */
+	Status = XTmrCtr_SelfTest(TmrCtrInstancePtr, TmrCtrNumber);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	// Default timer settings (count up, no auto reload, interrupt disabled)
+	XTmrCtr_SetOptions(TmrCtrInstancePtr, TmrCtrNumber, 0);
+	XTmrCtr_SetResetValue(TmrCtrInstancePtr, TmrCtrNumber, 0);
+
+	return XST_SUCCESS;
+}
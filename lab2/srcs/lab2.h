@@ -18,6 +18,8 @@
 #include "xuartps.h"
 #include "stdio.h"
 #include "stdbool.h"
+#include "xtime_l.h"
+#include "matmul_kernels.h"
 
 #ifdef XPAR_UARTNS550_0_BASEADDR
 #include "xuartns550_l.h"
@@ -42,12 +44,34 @@
 #define TIMER_COUNTER_0     0
 #define WORD_SIZE           4
 
-/* ----- Matrix dimensions ----- */
+/* XTime ticks to cycles of the AXI timer, the unit of Stats */
+#define TICKS_TO_TIMER_CYCLES(Ticks) \
+	((u32)((Ticks) * (XPAR_TMRCTR_0_CLOCK_FREQ_HZ / 1000U) / (COUNTS_PER_SECOND / 1000U)))
+
+/* ----- Matrix dimensions (must match m and n of the IP, overridable with -D) ----- */
+#ifndef MATRIX_A_ROWS
 #define MATRIX_A_ROWS 64
+#endif
+#ifndef MATRIX_A_COLS
 #define MATRIX_A_COLS 8
-#define MATRIX_B_ROWS 8
+#endif
+#define MATRIX_B_ROWS MATRIX_A_COLS
 #define MATRIX_B_COLS 1
 
+/* ----- Fixed-point format of the software kernel (see matmul_kernels.h, overridable with -D) ----- */
+#ifndef MATMUL_ELEMENT_BITS
+#define MATMUL_ELEMENT_BITS 8
+#endif
+#ifndef MATMUL_FRACTION_BITS
+#define MATMUL_FRACTION_BITS 8
+#endif
+#ifndef MATMUL_ACCUMULATOR_BITS
+#define MATMUL_ACCUMULATOR_BITS 32
+#endif
+#ifndef MATMUL_SATURATE
+#define MATMUL_SATURATE false
+#endif
+
 #define TOTAL_ELEMENTS  ((MATRIX_A_ROWS * MATRIX_A_COLS) + (MATRIX_B_ROWS * MATRIX_B_COLS))
 #define MatrixA_Size    (MATRIX_A_COLS * MATRIX_A_ROWS)
 #define MatrixB_Size    (MATRIX_B_COLS * MATRIX_B_ROWS)
@@ -57,22 +81,27 @@ typedef struct {
     u32 TxElapsed;
     u32 RxElapsed;
     u32 MatMulElapsed;
+    // Session, the FIFO and the timer are brought up once at boot (InitSession)
+    u32 InitElapsed;    // the bring-up, self-test included, what every job paid before
+    u32 ResetElapsed;   // the reset and health check of the last job (ResetSession)
+    u32 Reinits;        // failed health checks, each followed by a full bring-up
 } Stats;
 
 /* ----- Function declarations ----- */
 #ifndef SDT
-int RunMatrixAssignment(
-    XLlFifo *FifoInstancePtr, u16 FifoDeviceId,
-    XTmrCtr *TmrCtrInstancePtr, u16 TmrCtrDeviceId,
-    u8 TmrCtrNumber, Stats *stats
-);
+int InitFifo(XLlFifo *FifoInstancePtr, u16 FifoDeviceId);
+int InitTmrCtr(XTmrCtr *TmrCtrInstancePtr, u16 TmrCtrDeviceId, u8 TmrCtrNumber);
 #else
+int InitFifo(XLlFifo *FifoInstancePtr, UINTPTR FifoBaseAddress);
+int InitTmrCtr(XTmrCtr *TmrCtrInstancePtr, UINTPTR TmrCtrBaseAddress, u8 TmrCtrNumber);
+#endif
+int InitSession(XLlFifo *FifoInstancePtr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber);
+int ResetSession(XLlFifo *FifoInstancePtr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats);
+
 int RunMatrixAssignment(
-    XLlFifo *FifoInstancePtr, UINTPTR FifoBaseAddress,
-    XTmrCtr *TmrCtrInstancePtr, UINTPTR TmrCtrBaseAddress,
+    XLlFifo *FifoInstancePtr, XTmrCtr *TmrCtrInstancePtr,
     u8 TmrCtrNumber, Stats *stats
 );
-#endif
 
 int TxSend(XLlFifo *FifoInstancePtr, u32 *SourceAddr, int Words,
            XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats);
@@ -86,7 +115,7 @@ void SendStats(Stats *stats);
 
 void MergeArrays(u32 *dest, u32 *A, int sizeA, u32 *B, int sizeB);
 
-int performMatrixMultiplication(u32 *data, int A_rows, int A_cols, int B_cols,
+int performMatrixMultiplication(u32 *data, const MatMulKernelEntry *Kernel,
                                 XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber,
                                 Stats *stats);
 
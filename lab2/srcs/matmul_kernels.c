@@ -0,0 +1,48 @@
+/******************************************************************************
+* Fixed-point matrix multiplication kernels, see matmul_kernels.h.
+******************************************************************************/
+
+#include "lab2.h"
+#include "matmul_kernels.h"
+
+/* The rows of every kernel, then the whole matrix */
+#define DEFINE_MATMUL_KERNEL(Name, ElementBits, FractionBits, AccumulatorBits, Saturate, SumType)      \
+DEFINE_MATMUL_ROW(Name##_Row, ElementBits, FractionBits, AccumulatorBits, Saturate, SumType,            \
+	MATRIX_A_COLS, MATRIX_B_COLS)                                                                      \
+static void Name(const u32 *A, const u32 *B, u32 *RES)                                                 \
+{                                                                                                      \
+	for (int i = 0; i < MATRIX_A_ROWS; i++) {                                                          \
+		Name##_Row(A + i * MATRIX_A_COLS, B, RES + i * MATRIX_B_COLS);                                 \
+	}                                                                                                  \
+}
+
+DEFINE_MATMUL_KERNEL(MatMul_U8_Q8_Acc32_Wrap,   8,  8, 32, 0, u32)
+DEFINE_MATMUL_KERNEL(MatMul_U8_Q8_Acc32_Sat,    8,  8, 32, 1, u32)
+DEFINE_MATMUL_KERNEL(MatMul_U8_Q4_Acc32_Sat,    8,  4, 32, 1, u32)
+DEFINE_MATMUL_KERNEL(MatMul_U16_Q8_Acc32_Wrap, 16,  8, 32, 0, u32)
+DEFINE_MATMUL_KERNEL(MatMul_U16_Q8_Acc32_Sat,  16,  8, 32, 1, u64)
+DEFINE_MATMUL_KERNEL(MatMul_U16_Q16_Acc32_Sat, 16, 16, 32, 1, u64)
+
+const MatMulKernelEntry MatMulKernels[] = {
+	{  8,  8, 32, false, "U8_Q8_ACC32_WRAP",  MatMul_U8_Q8_Acc32_Wrap  },
+	{  8,  8, 32, true,  "U8_Q8_ACC32_SAT",   MatMul_U8_Q8_Acc32_Sat   },
+	{  8,  4, 32, true,  "U8_Q4_ACC32_SAT",   MatMul_U8_Q4_Acc32_Sat   },
+	{ 16,  8, 32, false, "U16_Q8_ACC32_WRAP", MatMul_U16_Q8_Acc32_Wrap },
+	{ 16,  8, 32, true,  "U16_Q8_ACC32_SAT",  MatMul_U16_Q8_Acc32_Sat  },
+	{ 16, 16, 32, true,  "U16_Q16_ACC32_SAT", MatMul_U16_Q16_Acc32_Sat },
+};
+
+const int MatMulKernelCount = sizeof(MatMulKernels) / sizeof(MatMulKernels[0]);
+
+
+const MatMulKernelEntry *LookupMatMulKernel(u8 ElementBits, u8 FractionBits, u8 AccumulatorBits, bool Saturate)
+{
+	for (int i = 0; i < MatMulKernelCount; i++) {
+		const MatMulKernelEntry *Entry = &MatMulKernels[i];
+		if (Entry->ElementBits == ElementBits && Entry->FractionBits == FractionBits
+				&& Entry->AccumulatorBits == AccumulatorBits && Entry->Saturate == Saturate) {
+			return Entry;
+		}
+	}
+	return NULL;
+}
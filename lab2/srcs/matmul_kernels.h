@@ -0,0 +1,76 @@
+/******************************************************************************
+* Fixed-point matrix multiplication kernels of the software (lab2) path.
+*
+* Each kernel is specialised at compile time on the number format:
+*   ElementBits      width of the A, B and RES elements (inputs are masked)
+*   FractionBits     fractional bits dropped from every product, as mac.sv
+*   AccumulatorBits  width of the running sum, at least ElementBits
+*   Saturate         clamp the result instead of wrapping it
+* and on the matrix shape (MATRIX_A_ROWS, MATRIX_A_COLS, MATRIX_B_COLS), so
+* the dot product is fully unrolled and carries no format branches. The
+* myip contract, RES = (sum((A * B) >> 8)) & 0xFF, is U8_Q8_ACC32_WRAP.
+*
+* The row of a kernel is DEFINE_MATMUL_ROW, shaped by its own Cols and BCols,
+* so firmware with other matrix dimensions (the CPU rows of the lab3 hybrid
+* build, lab3/srcs/dma/c/hybrid.c) instantiates the same arithmetic.
+******************************************************************************/
+
+#ifndef MATMUL_KERNELS_H
+#define MATMUL_KERNELS_H
+
+#include "xil_types.h"
+#include "stdbool.h"
+
+#define MATMUL_MASK(Bits)   ((u32)((1ULL << (Bits)) - 1))
+
+/*
+ * The result is narrowed to ElementBits, so an accumulator of at least that
+ * width cannot show in RES: A and B are non-negative, so a running sum
+ * clamped at AccumulatorBits still clamps to the same RES, and wrapping at
+ * AccumulatorBits keeps the low ElementBits. The kernels therefore clamp or
+ * mask once after the sum, and AccumulatorBits only names the format; the
+ * saturating ones need a SumType that holds Cols full products. The
+ * Saturate check is on a constant and folds away.
+ */
+#define DEFINE_MATMUL_ROW(Name, ElementBits, FractionBits, AccumulatorBits, Saturate, SumType, Cols, BCols) \
+typedef char Name##_AccumulatorFits[(AccumulatorBits) >= (ElementBits) ? 1 : -1];                        \
+static inline void Name(const u32 *A, const u32 *B, u32 *RES)                                              \
+{                                                                                                          \
+	for (int j = 0; j < (BCols); j++) {                                                                    \
+		SumType Acc = 0;                                                                                   \
+		_Pragma("GCC unroll 64")                                                                           \
+		for (int k = 0; k < (Cols); k++) {                                                                 \
+			Acc += ((SumType)(A[k] & MATMUL_MASK(ElementBits))                                             \
+				* (B[k * (BCols) + j] & MATMUL_MASK(ElementBits))) >> (FractionBits);                      \
+		}                                                                                                  \
+		if (Saturate) {                                                                                    \
+			if (Acc > MATMUL_MASK(ElementBits)) Acc = MATMUL_MASK(ElementBits);                            \
+		}                                                                                                  \
+		else {                                                                                             \
+			Acc &= MATMUL_MASK(ElementBits);                                                               \
+		}                                                                                                  \
+		RES[j] = (u32)Acc;                                                                                 \
+	}                                                                                                      \
+}
+
+/* The myip contract on one row of A */
+#define DEFINE_MATMUL_ROW_U8_Q8_ACC32_WRAP(Name, Cols, BCols) \
+	DEFINE_MATMUL_ROW(Name, 8, 8, 32, 0, u32, Cols, BCols)
+
+typedef void (*MatMulKernel)(const u32 *A, const u32 *B, u32 *RES);
+
+typedef struct {
+	u8 ElementBits;
+	u8 FractionBits;
+	u8 AccumulatorBits;
+	bool Saturate;
+	const char *Name;
+	MatMulKernel Kernel;
+} MatMulKernelEntry;
+
+extern const MatMulKernelEntry MatMulKernels[];
+extern const int MatMulKernelCount;
+
+const MatMulKernelEntry *LookupMatMulKernel(u8 ElementBits, u8 FractionBits, u8 AccumulatorBits, bool Saturate);
+
+#endif /* MATMUL_KERNELS_H */
@@ -0,0 +1,378 @@
+"""
+Size-sweep benchmark of the matrix-vector backends with regression gates.
+
+Every (backend, m x n shape, batch size) point builds the firmware for that
+shape against the co-simulation shim in lab3/srcs/sim, replays a generated
+batch over the simulated UART and records the firmware Stats and the per-job
+latency seen on the AXI-Stream pins.
+
+  cpu   lab2.c, FIFO loopback + performMatrixMultiplication (host CPU time)
+  fifo  lab3_fifo.c with myip_v1_0
+  dma   lab3_dma.c with myip_v1_0
+  async   lab3_dma.c -DASYNC_QUEUE_DEPTH=2, next job queued while one runs
+  hybrid  lab3_dma.c -DHYBRID_CPU, A cut into 4 shards shared by the IP and
+          the CPU (host CPU time, shapes with m a multiple of 64)
+  sparse  lab3_dma.c -DSPARSE_A with myip_v1_0 sparse = 1, A with 25% non-zeros
+          sent in CSR form
+  stream  lab3_dma.c -DSTREAM_ROWS with myip_stream_v1_0, B loaded once and the
+          rows of A streamed in chunks
+  wide    lab3_dma.c -DAXIS_LANES=16 with myip_v1_0 lanes = 16, 16 elements per
+          128-bit beat (shards of a multiple of 16 rows)
+  systolic lab3_dma.c -DMATRIX_B_COLS=4 with myip_systolic_v1_0 p = 4, B of 4
+          columns on a 4x4 systolic array (shards of a multiple of 4 rows)
+
+The inputs of every point are sliced with gen_vectors --in from one matbin
+container per shape and vector options (tools/matbin.h), generated once with
+as many records as the largest batch, and its results are checked with
+matbin check; the ERROR rows of a dropped job are expected as long as the
+DROPPED field of the STATS line counts the job.
+The IP is the host-emulated model by default, or the RTL with --verilator.
+--verilator is unverified, it has not been run with a real Verilator yet
+(lab3/srcs/sim/myip_verilated.cpp).
+The emulated model (myip_emulated.cpp) follows the RTL as read, it has only
+been compared with the RTL on a stand-in simulator, so the cycle counts of an
+emulated run and of BASELINE_emulated.json are those of the model and only
+track changes of the firmware and of the model itself.
+The dma, async, sparse, wide and systolic backends are also swept over the
+number of DMA/IP instances the rows of A are sharded across (--instances),
+and the throughput scaling over instances is printed for every shape and batch.
+Results are written as JSON (FORMAT_VERSION) and compared with a stored
+baseline; the script exits with 1 on a wrong result or a regression.
+
+Usage:
+  python bench.py [--backends cpu,fifo,dma,async,hybrid,sparse,stream,wide,systolic] [--shapes 64x8,32x32] [--batches 1,16]
+                  [--instances 1,2,4] [--verilator] [--out bench_results.json] [--baseline FILE]
+                  [--threshold 0.05] [--host-threshold 1.0] [--update-baseline]
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+FORMAT_NAME = "ee4218-bench"
+FORMAT_VERSION = 1
+
+repo_dir = Path(__file__).resolve().parents[2]
+sim_dir = repo_dir / "lab3" / "srcs" / "sim"
+captures_dir = repo_dir / "lab3" / "srcs" / "captures"
+default_baseline = captures_dir / "bench" / "BASELINE_emulated.json"
+
+RTL_SOURCES = ["myip_v1_0.sv", "matrix_multiply.sv", "mac.sv", "memory_RAM.sv", "perf_counters.sv"]
+SIM_SOURCES = ["sim_platform.cpp", "sim_fifo.cpp", "sim_dma.cpp"]
+
+# max_tx_words: FIFO depth (store-and-forward TX) or DMA length register (14 bits), per instance,
+#   in elements (bytes with lanes)
+# row_multiple: the rows of a shard must fill whole beats (AXIS_LANES) or tiles (grid_rows)
+# b_cols: columns of B (MATRIX_B_COLS)
+# shards: fixed number of row shards of A (NUM_SHARDS), one per instance otherwise
+# vectors: gen_vectors options of the input, params: myip_v1_0 parameters with --verilator
+# top, rtl: RTL top module and sources with --verilator when they are not myip_v1_0
+# rows_param: the top takes m (-Gm), all but myip_stream_v1_0
+# s_axi: the top has the AXI4-Lite counter bank, -DMYIP_NO_S_AXI for myip_verilated.cpp otherwise
+# shared: sources of another application it is built with, their folder joins the include paths
+BACKENDS = {
+    "cpu":  {"source": "lab2/srcs/lab2.c", "env": {"MYIP_SIM_LOOPBACK": "1", "MYIP_SIM_CPU_SCALE": "1"},
+             "timing": "host", "max_tx_words": 1024, "sharded": False},
+    "fifo": {"source": "lab3/srcs/fifo/c/lab3_fifo.c", "env": {}, "timing": "sim", "max_tx_words": 1024,
+             "sharded": False, "shared": ["lab3/srcs/dma/c/ipcounters.c"]},
+    "dma":  {"source": "lab3/srcs/dma/c/lab3_dma.c", "env": {}, "timing": "sim", "max_tx_words": 16383 // 4,
+             "sharded": True},
+    "async": {"source": "lab3/srcs/dma/c/lab3_dma.c", "env": {}, "timing": "sim", "max_tx_words": 16383 // 4,
+              "sharded": True, "defines": ["-DASYNC_QUEUE_DEPTH=2"]},
+    "hybrid": {"source": "lab3/srcs/dma/c/lab3_dma.c", "env": {"MYIP_SIM_CPU_SCALE": "1"}, "timing": "host",
+               "max_tx_words": 16383 // 4, "sharded": False, "shards": 4,
+               "defines": ["-DHYBRID_CPU", "-DNUM_SHARDS=4"]},
+    "sparse": {"source": "lab3/srcs/dma/c/lab3_dma.c", "env": {}, "timing": "sim", "max_tx_words": 16383 // 4,
+               "sharded": True, "defines": ["-DSPARSE_A"], "params": ["-Gsparse=1"],
+               "vectors": ["--density", "25", "--format", "csr"]},
+    "stream": {"source": "lab3/srcs/dma/c/lab3_dma.c", "env": {}, "timing": "sim", "max_tx_words": 1 << 32,
+               "sharded": False, "shards": 1, "defines": ["-DSTREAM_ROWS"], "vectors": ["--format", "stream"],
+               "top": "myip_stream_v1_0", "rtl": ["myip_stream_v1_0.sv", "mac.sv", "memory_RAM.sv"],
+               "rows_param": False, "s_axi": False},
+    "wide": {"source": "lab3/srcs/dma/c/lab3_dma.c", "env": {}, "timing": "sim", "max_tx_words": 16383,
+             "sharded": True, "row_multiple": 16, "defines": ["-DAXIS_LANES=16"], "params": ["-Glanes=16"]},
+    "systolic": {"source": "lab3/srcs/dma/c/lab3_dma.c", "env": {}, "timing": "sim", "max_tx_words": 16383 // 4,
+                 "sharded": True, "row_multiple": 4, "b_cols": 4, "defines": ["-DMATRIX_B_COLS=4"],
+                 "params": ["-Gp=4", "-Ggrid_rows=4"], "vectors": ["--format", "csv", "--p", "4"],
+                 "top": "myip_systolic_v1_0", "rtl": ["myip_systolic_v1_0.sv", "systolic_array.sv", "memory_RAM.sv"],
+                 "s_axi": False},
+}
+
+# metric -> True when higher is better
+METRICS = {
+    "tx_cycles": False,
+    "rx_cycles": False,
+    "matmul_cycles": False,
+    "total_cycles": False,
+    "latency_cycles": False,
+    "jobs_per_s": True,
+    # DMA fault counters, only reported by the firmware once there was a fault
+    "timeouts": False,
+    "dmaerrors": False,
+    "resets": False,
+    "replays": False,
+    "dropped": False,
+    # lab2 session, the bring-up at boot against the reset before each job
+    "init_cycles": False,
+    "reset_cycles": False,
+    "reinits": False,
+}
+
+# Stored with the report, what the cycle counts of a model stand for
+MODEL_NOTES = {
+    "emulated": "cycles of myip_emulated.cpp, a model written from the RTL and only compared with it on a stand-in simulator",
+    "verilator": "cycles of the RTL simulated by Verilator, through a shim not yet verified with a real Verilator",
+}
+
+CYCLE_STATS = {"tx", "rx", "total", "matmul", "init", "reset"}
+
+
+def run(cmd, **kwargs):
+    result = subprocess.run(cmd, **kwargs)
+    if result.returncode != 0:
+        sys.exit(f"Command failed: {' '.join(str(c) for c in cmd)}")
+    return result
+
+
+def build_tool(build_dir, name):
+    exe = build_dir / name
+    if not exe.exists():
+        run(["g++", "-O3", "-std=c++17", "-o", exe, repo_dir / "tools" / f"{name}.cpp"])
+    return exe
+
+
+def build_corpus(build_dir, generator, backend, m, n, count):
+    """The container all the batches of a backend and shape are sliced from, records 0 .. count - 1."""
+    # the text format does not change the records, only --density and --p do
+    vectors = BACKENDS[backend].get("vectors", ["--format", "csv"])
+    at = vectors.index("--format")
+    options = vectors[:at] + vectors[at + 2:]
+    corpus_dir = build_dir / ("corpus_" + "_".join([f"{m}x{n}", str(count), *(o.lstrip("-") for o in options)]))
+    if not (corpus_dir / "vectors.bin").exists():
+        corpus_dir.mkdir()
+        run([generator, "--m", str(m), "--n", str(n), "--count", str(count), "--seed", "4218", *options,
+             "--format", "bin", "--out", corpus_dir], stderr=subprocess.DEVNULL)
+    return corpus_dir / "vectors.bin"
+
+
+def build_firmware(build_dir, backend, m, n, instances, verilator):
+    exe = build_dir / f"{backend}_{m}x{n}_i{instances}"
+    if exe.exists():
+        return exe
+    # every translation unit of the application, like the Vitis src/ folder
+    sources = sorted((repo_dir / BACKENDS[backend]["source"]).parent.glob("*.c"))
+    shared = [repo_dir / s for s in BACKENDS[backend].get("shared", [])]
+    sources += shared
+    defines = [f"-DMATRIX_A_ROWS={m}", f"-DMATRIX_A_COLS={n}", f"-DXPAR_XAXIDMA_NUM_INSTANCES={instances}",
+               *BACKENDS[backend].get("defines", [])]
+    shards = BACKENDS[backend].get("shards", instances)
+    # lab2/srcs for the matmul_kernels.h rows of the hybrid build
+    includes = [f"-I{sim_dir / 'bsp'}", f"-I{sim_dir}", f"-I{repo_dir / 'lab2' / 'srcs'}",
+                *sorted({f"-I{s.parent}" for s in shared})]
+    sim_sources = [sim_dir / s for s in SIM_SOURCES]
+    if verilator:
+        # myip_verilated.cpp drives Vmyip_v1_0 whatever the top module
+        top = BACKENDS[backend].get("top", "myip_v1_0")
+        rows = [f"-Gm={m // shards}"] if BACKENDS[backend].get("rows_param", True) else []
+        s_axi = [] if BACKENDS[backend].get("s_axi", True) else ["-DMYIP_NO_S_AXI"]
+        run(["verilator", "--cc", "--exe", "--build", "-O3", "--top-module", top, "--prefix", "Vmyip_v1_0",
+             *rows, f"-Gn={n}", *BACKENDS[backend].get("params", []), "--Mdir", build_dir / f"obj_{backend}_{m}x{n}_i{instances}",
+             *[repo_dir / "lab1" / "srcs" / s for s in BACKENDS[backend].get("rtl", RTL_SOURCES)],
+             *sim_sources, sim_dir / "myip_verilated.cpp", *sources,
+             "-CFLAGS", " ".join(defines + s_axi + includes), "-o", exe.resolve()])
+    else:
+        run(["g++", "-O2", "-std=c++17", *defines, *includes, "-x", "c++", *sources, "-x", "none",
+             *sim_sources, sim_dir / "myip_emulated.cpp", "-o", exe])
+    return exe
+
+
+def run_point(build_dir, tools, corpus, backend, m, n, batch, instances, verilator):
+    exe = build_firmware(build_dir, backend, m, n, instances, verilator)
+    point_dir = build_dir / f"{backend}_{m}x{n}_b{batch}_i{instances}"
+    point_dir.mkdir(exist_ok=True)
+    vectors = BACKENDS[backend].get("vectors", ["--format", "csv"])
+    text_format = vectors[vectors.index("--format") + 1]
+    run([tools["gen_vectors"], "--in", corpus, "--count", str(batch), "--format", text_format, "--out", point_dir],
+        stderr=subprocess.DEVNULL)
+
+    jobs_csv = point_dir / "jobs.csv"
+    env = dict(os.environ, MYIP_SIM_JOBS_CSV=str(jobs_csv), **BACKENDS[backend]["env"])
+    stdin = (point_dir / "INPUT.csv").read_bytes() + b"TERMINATE\n"
+    # TERMINATE makes the firmware return XST_FAILURE from main, that is expected
+    output = subprocess.run([exe], input=stdin, env=env, capture_output=True).stdout.decode()
+
+    lines = [l.strip() for l in output.splitlines() if l.strip()]
+    stats = {}
+    if lines and lines[-1].startswith("STATS:"):
+        for field in lines.pop()[len("STATS:"):].split(","):
+            key, value = field.split("=")
+            stats[key.lower()] = int(value)
+    # a dropped job answers with ERROR rows (lab3_dma.h), right as long as the firmware counted it
+    check = subprocess.run([tools["matbin"], "check", "--allow-dropped", "--count", str(batch), corpus, "-"],
+                           input=output.encode(), capture_output=True)
+    dropped = re.search(r"(\d+) dropped", check.stdout.decode())
+    dropped_records = int(dropped.group(1)) if dropped else 0
+
+    metrics = {(f"{key}_cycles" if key in CYCLE_STATS else key): value for key, value in stats.items()}
+    jobs = [l.split(",") for l in jobs_csv.read_text().splitlines()[1:]] if jobs_csv.exists() else []
+    if jobs and BACKENDS[backend]["timing"] != "host":
+        # a job spans all instances, from its first input beat to its last result
+        spans = {}
+        for job in jobs:
+            first, last = spans.get(job[0], (int(job[1]), int(job[4])))
+            spans[job[0]] = (min(first, int(job[1])), max(last, int(job[4])))
+        latencies = [last - first + 1 for first, last in spans.values()]
+        span = max(last for _, last in spans.values()) - min(first for first, _ in spans.values()) + 1
+        metrics["latency_cycles"] = sum(latencies) / len(latencies)
+        metrics["jobs_per_s"] = 100e6 * len(spans) / span
+
+    return {
+        "backend": backend, "m": m, "n": n, "batch": batch, "instances": instances,
+        "timing": BACKENDS[backend]["timing"],
+        "correct": check.returncode == 0 and dropped_records == stats.get("dropped", 0),
+        "metrics": metrics,
+    }
+
+
+def key_of(result):
+    return (result["backend"], result["m"], result["n"], result["batch"], result.get("instances", 1))
+
+
+def compare(results, baseline, threshold, host_threshold):
+    failures = []
+    reference = {key_of(r): r for r in baseline["results"]}
+    for result in results:
+        base = reference.get(key_of(result))
+        if base is None:
+            continue
+        limit = host_threshold if result["timing"] == "host" else threshold
+        for metric, value in result["metrics"].items():
+            if metric not in base["metrics"] or base["metrics"][metric] == 0:
+                continue
+            change = value / base["metrics"][metric] - 1.0
+            worse = -change if METRICS.get(metric, False) else change
+            if worse > limit:
+                failures.append(f"{key_of(result)} {metric}: {base['metrics'][metric]:.1f} -> {value:.1f} "
+                                f"({change:+.1%}, limit {limit:.0%})")
+    return failures
+
+
+def scaling(results):
+    """jobs_per_s of every sharded point relative to the same point on one instance."""
+    single = {key_of(r)[:4]: r["metrics"].get("jobs_per_s") for r in results if r.get("instances", 1) == 1}
+    curves = {}
+    for result in results:
+        base = single.get(key_of(result)[:4])
+        if base and "jobs_per_s" in result["metrics"] and BACKENDS[result["backend"]]["sharded"]:
+            name = f"{result['backend']} {result['m']}x{result['n']} batch {result['batch']}"
+            curves.setdefault(name, {})[result["instances"]] = result["metrics"]["jobs_per_s"] / base
+    return curves
+
+
+def board_captures():
+    """The single-shape STATS lines captured on the KV260, for reference."""
+    captures = {}
+    for stats_file in captures_dir.glob("*/STATS_*.txt"):
+        line = stats_file.read_text().strip()
+        fields = dict(f.split("=") for f in line[len("STATS:"):].split(","))
+        captures[stats_file.parent.name] = {f"{k.lower()}_cycles": int(v) for k, v in fields.items()}
+    return captures
+
+
+def parse_list(text, convert):
+    return [convert(item) for item in text.split(",") if item]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Size-sweep benchmark with regression gates")
+    parser.add_argument("--backends", default="cpu,fifo,dma,async,hybrid,sparse,stream,wide,systolic")
+    parser.add_argument("--shapes", default="16x8,64x8,32x32,128x16")
+    parser.add_argument("--batches", default="1,16")
+    parser.add_argument("--instances", default="1,2,4", help="DMA/IP instance counts of the sharded backends")
+    parser.add_argument("--verilator", action="store_true", help="co-simulate the RTL instead of the emulated IP (unverified, see myip_verilated.cpp)")
+    parser.add_argument("--out", default="bench_results.json")
+    parser.add_argument("--baseline", default=str(default_baseline))
+    parser.add_argument("--threshold", type=float, default=0.05, help="allowed regression of simulated metrics")
+    parser.add_argument("--host-threshold", type=float, default=1.0, help="allowed regression of host-timed metrics")
+    parser.add_argument("--update-baseline", action="store_true")
+    args = parser.parse_args()
+
+    backends = parse_list(args.backends, str)
+    shapes = parse_list(args.shapes, lambda s: tuple(int(v) for v in s.split("x")))
+    batches = parse_list(args.batches, int)
+    instance_counts = parse_list(args.instances, int)
+
+    results = []
+    with tempfile.TemporaryDirectory() as tmp:
+        build_dir = Path(tmp)
+        tools = {name: build_tool(build_dir, name) for name in ("gen_vectors", "matbin")}
+        for backend in backends:
+            for m, n in shapes:
+                for instances in instance_counts if BACKENDS[backend]["sharded"] else [1]:
+                    shards = BACKENDS[backend].get("shards", instances)
+                    if m % shards != 0:
+                        print(f"skip {backend} {m}x{n} x{instances}: rows do not split evenly")
+                        continue
+                    if "-DHYBRID_CPU" in BACKENDS[backend].get("defines", []) and (m // shards) % 16 != 0:
+                        print(f"skip {backend} {m}x{n}: shards of the results are not whole cache lines")
+                        continue
+                    if (m // shards) % BACKENDS[backend].get("row_multiple", 1) != 0:
+                        print(f"skip {backend} {m}x{n} x{instances}: shards of the rows do not fill whole beats or tiles")
+                        continue
+                    words = (m // shards) * n + n * BACKENDS[backend].get("b_cols", 1)
+                    if words > BACKENDS[backend]["max_tx_words"]:
+                        print(f"skip {backend} {m}x{n} x{instances}: {words} input words do not fit one transfer")
+                        continue
+                    corpus = build_corpus(build_dir, tools["gen_vectors"], backend, m, n, max(batches))
+                    for batch in batches:
+                        result = run_point(build_dir, tools, corpus, backend, m, n, batch, instances, args.verilator)
+                        results.append(result)
+                        summary = " ".join(f"{k}={v:.0f}" for k, v in result["metrics"].items())
+                        print(f"{backend:4} {m:4}x{n:<4} x{instances} batch {batch:4} "
+                              f"{'ok   ' if result['correct'] else 'WRONG'} {summary}")
+
+    curves = scaling(results)
+    for name, curve in curves.items():
+        if len(curve) > 1:
+            print(f"scaling {name}: " + ", ".join(f"x{k} {v:.2f}" for k, v in sorted(curve.items())))
+
+    report = {
+        "format": FORMAT_NAME,
+        "version": FORMAT_VERSION,
+        "model": "verilator" if args.verilator else "emulated",
+        "model_note": MODEL_NOTES["verilator" if args.verilator else "emulated"],
+        "results": results,
+        "scaling": {name: {str(k): v for k, v in curve.items()} for name, curve in curves.items()},
+        "board_captures": board_captures(),
+    }
+    Path(args.out).write_text(json.dumps(report, indent=2) + "\n")
+    print(f"Results saved to {args.out}")
+
+    failures = [f"{key_of(r)} produced wrong results" for r in results if not r["correct"]]
+    if args.update_baseline:
+        Path(args.baseline).parent.mkdir(parents=True, exist_ok=True)
+        Path(args.baseline).write_text(json.dumps(report, indent=2) + "\n")
+        print(f"Baseline updated: {args.baseline}")
+    elif Path(args.baseline).exists():
+        baseline = json.loads(Path(args.baseline).read_text())
+        if baseline.get("format") != FORMAT_NAME or baseline.get("version") != FORMAT_VERSION:
+            sys.exit(f"{args.baseline} is not a version {FORMAT_VERSION} {FORMAT_NAME} file")
+        if baseline.get("model") != report["model"]:
+            print(f"Baseline was recorded with the {baseline.get('model')} model, not compared")
+        else:
+            failures += compare(results, baseline, args.threshold, args.host_threshold)
+
+    for failure in failures:
+        print(f"FAIL {failure}")
+    if failures:
+        sys.exit(1)
+    print("No regressions")
+
+
+if __name__ == "__main__":
+    main()
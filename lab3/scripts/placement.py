@@ -0,0 +1,154 @@
+"""
+Memory placement of the lab3 firmware, DDR against OCM.
+
+The firmware built with -DOCM_BUFFERS and -DOCM_CODE puts its DMA buffers in
+section .ocm_data and its hot functions in .ocm_text, which
+lab3/srcs/lscript_ocm.ld places in the OCM (see lab3_dma.h).
+
+  map      where the buffers and hot functions of an ELF ended up, with the
+           OCM the build takes. Run it on the .elf of the Vitis build, or on
+           a co-simulation binary to check the section annotations (host
+           addresses are not board addresses, the section names still are)
+  compare  the per-phase PMU lines (pmu.h) and the STATS line of two UART
+           captures, the DDR build and the OCM build of the same firmware,
+           both built with -DENABLE_PMU and fed the same jobs. The
+           co-simulation has no memory model, so only board captures tell the
+           two apart
+
+Usage:
+  python placement.py map lab3.elf [--objdump aarch64-none-elf-objdump]
+  python placement.py compare ddr.log ocm.log
+"""
+
+import argparse
+import re
+import shutil
+import subprocess
+import sys
+
+OCM_BASE = 0xFFFC0000
+OCM_BYTES = 256 * 1024
+
+# The buffers and hot loops OCM_DATA and OCM_TEXT are put on, shown even when in DDR
+HOT_SYMBOLS = ["SourceBuffer", "DestinationBuffer", "AsyncSource", "AsyncDestination", "StreamB", "ChunkA",
+               "ChunkRes", "ReceiveCSVData", "TxSend", "RxReceive", "WaitChannels"]
+
+PMU_COUNTERS = ["CYCLES", "INSTRUCTIONS", "L1D_REFILLS", "EXCEPTIONS", "STALLS"]
+
+
+def find_objdump(name):
+    for tool in ([name] if name else ["aarch64-none-elf-objdump", "aarch64-linux-gnu-objdump", "objdump"]):
+        if shutil.which(tool):
+            return tool
+    sys.exit("no objdump found, pass one with --objdump")
+
+
+def region_of(section, address):
+    return "OCM" if section.startswith(".ocm_") or OCM_BASE <= address < OCM_BASE + OCM_BYTES else "DDR"
+
+
+def read_symbols(objdump, elf):
+    """(name, section, address, size) of every data and function symbol, demangled and without arguments."""
+    output = subprocess.run([objdump, "-t", "-C", elf], capture_output=True, text=True, check=True).stdout
+    symbols = []
+    for line in output.splitlines():
+        match = re.match(r"^([0-9a-f]+) (.{7}) (\S+)\s+([0-9a-f]+)\s+(.+)$", line)
+        if match and match.group(2)[6] in "OF":
+            name = match.group(5).split("(")[0].strip()
+            symbols.append((name, match.group(3), int(match.group(1), 16), int(match.group(4), 16)))
+    return symbols
+
+
+def read_sections(objdump, elf):
+    """Size of every section, by name."""
+    output = subprocess.run([objdump, "-h", elf], capture_output=True, text=True, check=True).stdout
+    sections = {}
+    for line in output.splitlines():
+        match = re.match(r"^\s*\d+\s+(\S+)\s+([0-9a-f]+)\s+[0-9a-f]+", line)
+        if match:
+            sections[match.group(1)] = int(match.group(2), 16)
+    return sections
+
+
+def placement_map(args):
+    objdump = find_objdump(args.objdump)
+    symbols = read_symbols(objdump, args.elf)
+    sections = read_sections(objdump, args.elf)
+
+    shown = [s for s in symbols if s[0] in HOT_SYMBOLS or s[1].startswith(".ocm_")]
+    print(f"{'symbol':24} {'section':12} {'region':6} {'address':>18} {'bytes':>8}")
+    for name, section, address, size in sorted(shown, key=lambda s: (region_of(s[1], s[2]), s[1], s[2])):
+        print(f"{name:24} {section:12} {region_of(section, address):6} {address:#18x} {size:8}")
+
+    used = sum(size for name, size in sections.items() if name.startswith(".ocm_"))
+    for name in (".ocm_text", ".ocm_data"):
+        print(f"{name}: {sections.get(name, 0)} bytes")
+    print(f"OCM used: {used} of {OCM_BYTES} bytes ({100.0 * used / OCM_BYTES:.1f}%)")
+    if used > OCM_BYTES:
+        print("OCM overflow, the board link would fail")
+        return 1
+    return 0
+
+
+def read_capture(path):
+    """The PMU:PHASE lines by phase and the fields of the last STATS line of a capture."""
+    phases, stats = {}, {}
+    with open(path, errors="replace") as capture:
+        for line in capture:
+            line = line.strip()
+            if line.startswith("PMU:"):
+                fields = dict(f.split("=", 1) for f in line[len("PMU:"):].split(",") if "=" in f)
+                phase = fields.pop("PHASE")
+                phases[phase] = {k: int(v) for k, v in fields.items()}
+            elif line.startswith("STATS:"):
+                stats = {k: int(v) for k, v in (f.split("=", 1) for f in line[len("STATS:"):].split(",") if "=" in f)}
+    return phases, stats
+
+
+def change(ddr, ocm):
+    return f"{100.0 * (ocm - ddr) / ddr:+7.1f}%" if ddr else "      -"
+
+
+def placement_compare(args):
+    ddr_phases, ddr_stats = read_capture(args.ddr)
+    ocm_phases, ocm_stats = read_capture(args.ocm)
+    if not ddr_phases or not ocm_phases:
+        sys.exit("no PMU:PHASE lines, build both firmwares with -DENABLE_PMU")
+
+    print(f"{'phase':18} {'counter':13} {'DDR/call':>12} {'OCM/call':>12} {'change':>8}")
+    for phase in ddr_phases:
+        if phase not in ocm_phases:
+            print(f"{phase:18} only in the DDR capture")
+            continue
+        ddr, ocm = ddr_phases[phase], ocm_phases[phase]
+        if ddr.get("COUNT") != ocm.get("COUNT"):
+            print(f"{phase:18} called {ddr.get('COUNT')} times against {ocm.get('COUNT')}, not the same jobs?")
+        for counter in PMU_COUNTERS:
+            if counter in ddr and counter in ocm:
+                ddr_call = ddr[counter] / max(ddr.get("COUNT", 1), 1)
+                ocm_call = ocm[counter] / max(ocm.get("COUNT", 1), 1)
+                print(f"{phase:18} {counter:13} {ddr_call:12.0f} {ocm_call:12.0f} {change(ddr_call, ocm_call)}")
+
+    for field in ddr_stats:
+        if field in ocm_stats and field != "PMU_MISSING":   # a bit mask, not a count
+            print(f"{'STATS':18} {field:13} {ddr_stats[field]:12} {ocm_stats[field]:12} "
+                  f"{change(ddr_stats[field], ocm_stats[field])}")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="DDR/OCM placement map and per-phase comparison")
+    commands = parser.add_subparsers(dest="command", required=True)
+    map_parser = commands.add_parser("map", help="where the buffers and hot functions of an ELF are")
+    map_parser.add_argument("elf")
+    map_parser.add_argument("--objdump", help="objdump of the ELF's target, found on PATH by default")
+    compare_parser = commands.add_parser("compare", help="per-phase PMU totals of a DDR and an OCM capture")
+    compare_parser.add_argument("ddr")
+    compare_parser.add_argument("ocm")
+    args = parser.parse_args()
+
+    return placement_map(args) if args.command == "map" else placement_compare(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
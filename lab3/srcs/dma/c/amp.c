@@ -0,0 +1,113 @@
+/******************************************************************************
+* AMP split of the DMA firmware, see amp.h.
+******************************************************************************/
+
+#include "amp.h"
+
+#ifdef AMP_CPU
+
+#if AMP_CPU == 1
+
+static u32 Outstanding;
+
+
+/*
+ * Sends the results of finished jobs in submission order until at most
+ * MaxOutstanding jobs are still with CPU0, waiting for CPU0 if needed.
+ */
+static void AmpCollect(Stats *stats, u32 MaxOutstanding)
+{
+	u32 Slot;
+
+	while (Outstanding > 0) {
+		if (!SpscRingPop(&AMP_SHARED->Completions, &Slot)) {
+			if (Outstanding <= MaxOutstanding) {
+				return;
+			}
+			continue;
+		}
+		Outstanding--;
+
+		AmpJobSlot *JobSlot = &AMP_SLOTS[Slot];
+		stats->TxElapsed = JobSlot->JobStats.TxElapsed;
+		stats->RxElapsed = JobSlot->JobStats.RxElapsed;
+		stats->TotalElapsed = JobSlot->JobStats.TotalElapsed;
+		AddDmaFaults(stats, &JobSlot->JobStats);
+		if (JobSlot->Status != XST_SUCCESS) {
+			xil_printf("Job in slot %u dropped\r\n", Slot);
+			stats->DroppedJobs++;
+			SendErrorRows(MATRIX_A_ROWS);
+			continue;
+		}
+		TRACE_BEGIN(TRACE_SEND_RESULTS);
+		SendCSVResults(JobSlot->Destination, MATRIX_A_ROWS, MATRIX_B_COLS);
+		TRACE_END(TRACE_SEND_RESULTS, RX_ELEMENTS);
+	}
+}
+
+
+/* Called on TERMINATE so that every result goes out before the STATS line */
+void AmpDrain(Stats *stats)
+{
+	AmpCollect(stats, 0);
+}
+
+
+int RunIoCore(Stats *stats)
+{
+	int Status;
+	u32 Next = 0;
+	const Stats Cleared = {0};
+
+	while (__atomic_load_n(&AMP_SHARED->Ready, __ATOMIC_ACQUIRE) != AMP_READY_MAGIC) {
+	}
+
+	while (true) {
+		// Slots are used round robin and come back in order, so the one we
+		// need is free once fewer than AMP_JOB_SLOTS jobs are outstanding
+		AmpCollect(stats, AMP_JOB_SLOTS - 1);
+
+		Status = ReceiveJob(AMP_SLOTS[Next].Source, stats);
+		if (Status != XST_SUCCESS) {
+			return XST_FAILURE;
+		}
+		// CPU0 only adds to the fault counters of the slot
+		AMP_SLOTS[Next].JobStats = Cleared;
+		SpscRingPush(&AMP_SHARED->Requests, Next);
+		Outstanding++;
+		Next = (Next + 1) % AMP_JOB_SLOTS;
+
+		AmpCollect(stats, AMP_JOB_SLOTS);
+	}
+	return XST_SUCCESS;
+}
+
+#else
+
+int RunAcceleratorCore(XAxiDma *DmaInstancePtr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber)
+{
+	ChainJob Job;
+	u32 Slot;
+
+	__atomic_store_n(&AMP_SHARED->Ready, 0, __ATOMIC_RELAXED);
+	SpscRingInit(&AMP_SHARED->Requests);
+	SpscRingInit(&AMP_SHARED->Completions);
+	__atomic_store_n(&AMP_SHARED->Ready, AMP_READY_MAGIC, __ATOMIC_RELEASE);
+
+	while (true) {
+		while (!SpscRingPop(&AMP_SHARED->Requests, &Slot)) {
+		}
+
+		AmpJobSlot *JobSlot = &AMP_SLOTS[Slot];
+		BuildChainJob(&Job, JobSlot->Source, JobSlot->Destination);
+		JobSlot->Status = RunChain(DmaInstancePtr, &Job, TmrCtrInstancePtr, TmrCtrNumber, &JobSlot->JobStats);
+
+		// Never full, there are no more slots than ring entries
+		SpscRingPush(&AMP_SHARED->Completions, Slot);
+	}
+	return XST_SUCCESS;
+}
+
+#endif /* AMP_CPU == 1 */
+
+#endif /* AMP_CPU */
@@ -0,0 +1,54 @@
+/******************************************************************************
+* AMP split of the DMA firmware over two A53 cores of the KV260 APU.
+*
+* Build the application twice, with -DAMP_CPU=0 and -DAMP_CPU=1, and link the
+* two ELFs to disjoint DDR ranges below MEM_BASE_ADDR.
+*   CPU1  ReceiveCSVData / SendCSVResults, parses job k+1 while CPU0 runs job k
+*   CPU0  TxSend / RxReceive on the DMA/IP pairs
+* Jobs are built in place in AMP_JOB_SLOTS slots at TX_BUFFER_BASE and the
+* slot indices travel through two SPSC rings in OCM. The A53 cores are cache
+* coherent, so the rings only need the ordering of spsc_ring.h; CPU0 keeps the
+* cache maintenance for the DMA.
+******************************************************************************/
+
+#ifndef AMP_H
+#define AMP_H
+
+#include "lab3_dma.h"
+#include "spsc_ring.h"
+
+#ifdef AMP_CPU
+
+#ifndef AMP_SHARED_BASE
+#define AMP_SHARED_BASE     0xFFFC0000U     // OCM, free once the FSBL has handed over
+#endif
+#define AMP_SHARED_SIZE     0x1000U         // window .amp_shared of lscript_ocm.ld keeps free
+#define AMP_JOB_SLOTS       SPSC_RING_ENTRIES
+#define AMP_READY_MAGIC     0x414D5052U     // "AMPR"
+
+typedef struct {
+	u32 Source[CHAIN_LAYERS][NUM_SHARDS][SHARD_TX_ELEMENTS];
+	u32 Destination[RX_ELEMENTS];
+	Stats JobStats;
+	int Status;
+} AmpJobSlot;
+
+typedef struct {
+	SpscRing Requests;      // CPU1 -> CPU0, slots ready to run
+	SpscRing Completions;   // CPU0 -> CPU1, slots holding results
+	u32 Ready;              // AMP_READY_MAGIC once CPU0 has set up the rings
+} AmpShared;
+
+/* Fails to compile when the rings outgrow the window reserved for them */
+typedef char AmpSharedFits[sizeof(AmpShared) <= AMP_SHARED_SIZE ? 1 : -1];
+
+#define AMP_SHARED          ((AmpShared *) AMP_SHARED_BASE)
+#define AMP_SLOTS           ((AmpJobSlot *) TX_BUFFER_BASE)
+
+int RunIoCore(Stats *stats);
+int RunAcceleratorCore(XAxiDma *DmaInstancePtr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber);
+void AmpDrain(Stats *stats);
+
+#endif /* AMP_CPU */
+
+#endif /* AMP_H */
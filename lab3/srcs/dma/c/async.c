@@ -0,0 +1,361 @@
+/******************************************************************************
+* Non-blocking job submission for the DMA firmware, see async.h.
+******************************************************************************/
+
+#include "async.h"
+
+#if defined(ASYNC_QUEUE_DEPTH) && ASYNC_QUEUE_DEPTH > 0
+
+/*
+ * The queued jobs are run as one sequence of rounds, a round being a shard
+ * on each of up to NUM_DMA_INSTANCES instances. At most two rounds are on
+ * the hardware: Received, whose S2MM is armed, and the one after it, whose
+ * MM2S may already run. A simple-mode S2MM holds a single transfer, so the
+ * second round's S2MM is armed once the first one's results are in; the IP
+ * does not produce them before that anyway.
+ */
+typedef struct {
+	u32 Job;                // handle of the job
+	int Layer;
+	int First;              // first shard of the round
+} AsyncRound;
+
+typedef struct {
+	ChainJob Job;
+	Stats JobStats;
+	int Status;             // XST_DEVICE_BUSY until the last round is in
+	bool Collected;         // WaitJob has returned it, the slot is free
+	bool Started;
+	XTime Start;            // first MM2S, replays included in the job time
+} AsyncSlot;
+
+static XAxiDma *Dma;
+static AsyncSlot Slots[ASYNC_QUEUE_DEPTH];
+static u32 Submitted;           // handle of the next job
+static u32 NextResult;          // handle of the next job to send results for
+
+static AsyncRound Sent;         // next round to start MM2S for
+static AsyncRound Received;     // round being received, or the next one
+static AsyncRound TxRound;      // round of the running MM2S
+static bool TxBusy;
+static bool RxBusy;
+static XTime TxStart;
+static XTime RxStart;
+static int Replays;             // of the round being received
+
+/* Buffers of the jobs in flight, slot i belongs to the handles i + k * DEPTH */
+static u32 AsyncSource[ASYNC_QUEUE_DEPTH][CHAIN_LAYERS][NUM_SHARDS][SHARD_TX_ELEMENTS] __attribute__((aligned(64))) OCM_DATA;
+static u32 AsyncDestination[ASYNC_QUEUE_DEPTH][RX_ELEMENTS] __attribute__((aligned(64))) OCM_DATA;
+
+
+static AsyncSlot *SlotOf(u32 Handle)
+{
+	return &Slots[Handle % ASYNC_QUEUE_DEPTH];
+}
+
+
+static int RoundCount(const AsyncRound *Round)
+{
+	int Left = NUM_SHARDS - Round->First;
+	return Left < NUM_DMA_INSTANCES ? Left : NUM_DMA_INSTANCES;
+}
+
+
+static void NextRound(AsyncRound *Round)
+{
+	Round->First += NUM_DMA_INSTANCES;
+	if (Round->First >= NUM_SHARDS) {
+		Round->First = 0;
+		if (++Round->Layer == SlotOf(Round->Job)->Job.LayerCount) {
+			Round->Layer = 0;
+			Round->Job++;
+		}
+	}
+}
+
+
+static bool SameRound(const AsyncRound *A, const AsyncRound *B)
+{
+	return A->Job == B->Job && A->Layer == B->Layer && A->First == B->First;
+}
+
+
+/*
+ * DMASR of one channel of the instances of a round: XST_SUCCESS once all
+ * are idle, XST_DEVICE_BUSY while not timed out, XST_DMA_ERROR otherwise.
+ */
+static int CheckChannels(const AsyncRound *Round, u32 ChannelOffset, XTime Since, Stats *stats)
+{
+	XTime Now;
+
+	for (int s = 0; s < RoundCount(Round); s++) {
+		u32 Sr = XAxiDma_ReadReg(Dma[s].RegBase + ChannelOffset, XAXIDMA_SR_OFFSET);
+		if (Sr & XAXIDMA_ERR_ALL_MASK) {
+			xil_printf("DMA %d halted, DMASR 0x%08x\r\n", s, Sr);
+			stats->DmaErrors++;
+			return XST_DMA_ERROR;
+		}
+		if (!(Sr & XAXIDMA_IDLE_MASK)) {
+			XTime_GetTime(&Now);
+			if (Now - Since > DMA_TIMEOUT_TICKS) {
+				xil_printf("DMA %d timed out, DMASR 0x%08x\r\n", s, Sr);
+				stats->DmaTimeouts++;
+				return XST_DMA_ERROR;
+			}
+			return XST_DEVICE_BUSY;
+		}
+	}
+	return XST_SUCCESS;
+}
+
+
+static int StartChannels(const AsyncRound *Round, int Direction)
+{
+	ChainJob *Job = &SlotOf(Round->Job)->Job;
+	u32 **Buffers = Direction == XAXIDMA_DMA_TO_DEVICE
+		? &Job->Source[Round->Layer][Round->First] : &Job->Destination[Round->Layer][Round->First];
+	for (int s = 0; s < RoundCount(Round); s++) {
+		u32 Length = Direction == XAXIDMA_DMA_TO_DEVICE ? Job->TxLength[Round->Layer][Round->First + s] : RX_PKT_LEN;
+		if (XAxiDma_SimpleTransfer(&Dma[s], (UINTPTR) Buffers[s], Length, Direction) != XST_SUCCESS) {
+			xil_printf("Failed to start DMA %d\r\n", s);
+			return XST_FAILURE;
+		}
+	}
+	return XST_SUCCESS;
+}
+
+
+/*
+ * Resets every engine and replays from the round being received, dropping
+ * its job once it has been replayed DMA_MAX_REPLAYS times.
+ */
+static void Recover(void)
+{
+	AsyncSlot *Slot = SlotOf(Received.Job);
+
+	TxBusy = false;
+	RxBusy = false;
+	if (ResetDMA(Dma, NUM_DMA_INSTANCES, &Slot->JobStats) != XST_SUCCESS || Replays == DMA_MAX_REPLAYS) {
+		xil_printf("Job %u dropped after %d replays\r\n", Received.Job, Replays);
+		Slot->Status = XST_FAILURE;
+		Received.Job++;
+		Received.Layer = 0;
+		Received.First = 0;
+		Replays = 0;
+	}
+	else {
+		Slot->JobStats.Replays++;
+		Replays++;
+	}
+	Sent = Received;
+}
+
+
+/* Moves the queue as far as the hardware allows without waiting */
+void AsyncPoll(void)
+{
+	XTime Now;
+	int Status;
+
+	if (TxBusy) {
+		AsyncSlot *Slot = SlotOf(TxRound.Job);
+		Status = CheckChannels(&TxRound, XAXIDMA_TX_OFFSET, TxStart, &Slot->JobStats);
+		if (Status == XST_DMA_ERROR) {
+			Recover();
+		}
+		else if (Status == XST_SUCCESS) {
+			XTime_GetTime(&Now);
+			Slot->JobStats.TxElapsed += TICKS_TO_TIMER_CYCLES(Now - TxStart);
+			TxBusy = false;
+		}
+	}
+
+	if (RxBusy) {
+		AsyncSlot *Slot = SlotOf(Received.Job);
+		Status = CheckChannels(&Received, XAXIDMA_RX_OFFSET, RxStart, &Slot->JobStats);
+		if (Status == XST_DMA_ERROR) {
+			Recover();
+		}
+		else if (Status == XST_SUCCESS) {
+			for (int s = 0; s < RoundCount(&Received); s++) {
+				Xil_DCacheInvalidateRange((UINTPTR) Slot->Job.Destination[Received.Layer][Received.First + s], RX_PKT_LEN);
+			}
+			u32 Job = Received.Job;
+			RxBusy = false;
+			Replays = 0;
+			NextRound(&Received);
+			if (Received.Job != Job) {
+				// That was the last round of the job
+				XTime_GetTime(&Now);
+				Slot->JobStats.TotalElapsed = TICKS_TO_TIMER_CYCLES(Now - Slot->Start);
+				Slot->JobStats.RxElapsed = Slot->JobStats.TotalElapsed - Slot->JobStats.TxElapsed;
+				Slot->Status = XST_SUCCESS;
+			}
+		}
+	}
+
+	// S2MM first, so that it is armed before the MM2S of the same round starts
+	if (!RxBusy && Received.Job != Submitted) {
+		if (StartChannels(&Received, XAXIDMA_DEVICE_TO_DMA) != XST_SUCCESS) {
+			Recover();
+			return;
+		}
+		XTime_GetTime(&RxStart);
+		RxBusy = true;
+	}
+
+	// The next round may only overtake Received within the same layer or job boundary
+	AsyncRound Ahead = Received;
+	NextRound(&Ahead);
+	bool Ready = SameRound(&Sent, &Received)
+		|| (SameRound(&Sent, &Ahead) && (Sent.Job != Received.Job || Sent.Layer == Received.Layer));
+	if (!TxBusy && Sent.Job != Submitted && Ready) {
+		AsyncSlot *Slot = SlotOf(Sent.Job);
+		if (Sent.First == 0) {
+			if (!Slot->Started) {
+				XTime_GetTime(&Slot->Start);
+				Slot->Started = true;
+			}
+			if (NUM_SHARDS > 1) {
+				ShareB(&Slot->Job, Sent.Layer);
+			}
+		}
+		XTime_GetTime(&TxStart);
+		if (StartChannels(&Sent, XAXIDMA_DMA_TO_DEVICE) != XST_SUCCESS) {
+			Recover();
+			return;
+		}
+		TxRound = Sent;
+		TxBusy = true;
+		NextRound(&Sent);
+	}
+}
+
+
+void AsyncInit(XAxiDma *DmaInstancePtr)
+{
+	Dma = DmaInstancePtr;
+	for (int i = 0; i < ASYNC_QUEUE_DEPTH; i++) {
+		Slots[i].Collected = true;
+	}
+}
+
+
+/*
+ * Queues a job and starts it if the hardware is free. The buffers of the job
+ * must stay untouched until WaitJob has returned. XST_DEVICE_BUSY when
+ * ASYNC_QUEUE_DEPTH jobs have not been waited for yet.
+ */
+int SubmitJob(ChainJob *Job, JobHandle *Handle)
+{
+	AsyncSlot *Slot = SlotOf(Submitted);
+	const Stats Cleared = {0};
+
+	if (!Slot->Collected) {
+		return XST_DEVICE_BUSY;
+	}
+	for (int l = 0; l < Job->LayerCount; l++) {
+		for (int s = 0; s < NUM_SHARDS; s++) {
+			FlushDCaches(Job->Source[l][s], Job->Destination[l][s]);
+		}
+	}
+
+	Slot->Job = *Job;
+	Slot->Status = XST_DEVICE_BUSY;
+	Slot->Collected = false;
+	Slot->Started = false;
+	Slot->JobStats = Cleared;
+	*Handle = Submitted++;
+
+	AsyncPoll();
+	return XST_SUCCESS;
+}
+
+
+/* XST_DEVICE_BUSY while the job runs, then XST_SUCCESS, or XST_FAILURE if it was dropped */
+int PollJob(JobHandle Handle)
+{
+	AsyncPoll();
+	return SlotOf(Handle)->Status;
+}
+
+
+/*
+ * Polls until the job is done and frees its slot. Its timing replaces the
+ * one in stats and its fault counters are added.
+ */
+int WaitJob(JobHandle Handle, Stats *stats)
+{
+	AsyncSlot *Slot = SlotOf(Handle);
+	int Status;
+
+	while ((Status = PollJob(Handle)) == XST_DEVICE_BUSY) {
+		usleep(1U);
+	}
+
+	stats->TxElapsed = Slot->JobStats.TxElapsed;
+	stats->RxElapsed = Slot->JobStats.RxElapsed;
+	stats->TotalElapsed = Slot->JobStats.TotalElapsed;
+	AddDmaFaults(stats, &Slot->JobStats);
+	if (Status != XST_SUCCESS) {
+		stats->DroppedJobs++;
+	}
+	Slot->Collected = true;
+	return Status;
+}
+
+
+/* Waits for the oldest job and sends its results, ERROR rows for a dropped job */
+static void SendOldest(Stats *stats)
+{
+	JobHandle Handle = NextResult++;
+
+	TRACE_BEGIN(TRACE_SEND_RESULTS);
+	if (WaitJob(Handle, stats) == XST_SUCCESS) {
+		SendCSVResults(AsyncDestination[Handle % ASYNC_QUEUE_DEPTH], MATRIX_A_ROWS, MATRIX_B_COLS);
+	} else {
+		SendErrorRows(MATRIX_A_ROWS);
+	}
+	TRACE_END(TRACE_SEND_RESULTS, RX_ELEMENTS);
+}
+
+
+/* Called on TERMINATE so that every result goes out before the STATS line */
+void AsyncDrain(Stats *stats)
+{
+	while (NextResult != Submitted) {
+		SendOldest(stats);
+	}
+}
+
+
+int RunAsyncJobs(XAxiDma *DmaInstancePtr, Stats *stats)
+{
+	ChainJob Job;
+	JobHandle Handle;
+	int Status;
+
+	AsyncInit(DmaInstancePtr);
+	while (true) {
+		u32 Slot = Submitted % ASYNC_QUEUE_DEPTH;
+		if (Submitted - NextResult == ASYNC_QUEUE_DEPTH) {
+			SendOldest(stats);
+		}
+
+		TRACE_BEGIN(TRACE_JOB);
+		Status = ReceiveJob(AsyncSource[Slot], stats);
+		if (Status != XST_SUCCESS) {
+			return XST_FAILURE;
+		}
+		BuildChainJob(&Job, AsyncSource[Slot], AsyncDestination[Slot]);
+		SubmitJob(&Job, &Handle);
+		TRACE_END(TRACE_JOB, Handle);
+
+		while (NextResult != Submitted && PollJob(NextResult) != XST_DEVICE_BUSY) {
+			SendOldest(stats);
+		}
+	}
+	return XST_SUCCESS;
+}
+
+#endif /* ASYNC_QUEUE_DEPTH */
@@ -0,0 +1,48 @@
+/******************************************************************************
+* Non-blocking job submission for the DMA firmware.
+*
+* Build with -DASYNC_QUEUE_DEPTH=N to run up to N jobs through the DMA/IP
+* pairs without blocking: SubmitJob() queues a ChainJob and returns a handle,
+* PollJob() moves the queue along and reports whether the job is done, and
+* WaitJob() polls until it is. For every round S2MM is armed before MM2S, and
+* the MM2S of the next round starts as soon as the current one is idle, so
+* the IP finds its next inputs waiting while it streams out the results.
+* The main loop parses job k+1 from the UART (polling the queue after every
+* value) while job k runs, and sends results in submission order.
+*
+* The queue is driven by polling only, the DMA interrupts stay disabled.
+* Without the flag the blocking TxSend/RxReceive path is used.
+******************************************************************************/
+
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include "lab3_dma.h"
+
+#if defined(ASYNC_QUEUE_DEPTH) && ASYNC_QUEUE_DEPTH > 0
+
+#if defined(AMP_CPU) || defined(HYBRID_CPU)
+#error "ASYNC_QUEUE_DEPTH cannot be combined with AMP_CPU or HYBRID_CPU"
+#endif
+
+typedef u32 JobHandle;
+
+void AsyncInit(XAxiDma *DmaInstancePtr);
+int SubmitJob(ChainJob *Job, JobHandle *Handle);
+int PollJob(JobHandle Handle);
+int WaitJob(JobHandle Handle, Stats *stats);
+void AsyncPoll(void);
+
+int RunAsyncJobs(XAxiDma *DmaInstancePtr, Stats *stats);
+void AsyncDrain(Stats *stats);
+
+/* Called by ReceiveCSVData after every value */
+#define ASYNC_POLL()        AsyncPoll()
+
+#else
+
+#define ASYNC_POLL()        do {} while (0)
+
+#endif /* ASYNC_QUEUE_DEPTH */
+
+#endif /* ASYNC_H */
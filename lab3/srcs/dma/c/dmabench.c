@@ -0,0 +1,200 @@
+/******************************************************************************
+* Raw DMA bandwidth microbenchmark for the DMA firmware, see dmabench.h.
+******************************************************************************/
+
+#include "dmabench.h"
+
+#ifdef DMA_BENCH
+
+#include "string.h"
+
+typedef enum {
+	BENCH_MM2S = 0,
+	BENCH_S2MM,
+	BENCH_BOTH,
+	BENCH_MODE_COUNT
+} BenchMode;
+
+static const char *BenchNames[BENCH_MODE_COUNT] = {"MM2S", "S2MM", "BOTH"};
+
+#define DMA_BENCH_TIMEOUT_TICKS ((XTime)DMA_BENCH_TIMEOUT_US * (COUNTS_PER_SECOND / 1000000U))
+#define DMA_BENCH_PATTERN(Word) ((u32)(Word) & 0x3FFFFFFFU)    // reads as a LOOP command
+
+/* Cache line aligned, the DMA and the CPU work on them by whole lines */
+static u32 BenchTx[DMA_BENCH_MAX_BYTES / WORD_SIZE] __attribute__((aligned(64)));
+static u32 BenchRx[DMA_BENCH_MAX_BYTES / WORD_SIZE] __attribute__((aligned(64)));
+static u32 BenchCommand[64 / WORD_SIZE] __attribute__((aligned(64)));
+
+
+static void BenchSendString(const char *Str)
+{
+	for (const char *p = Str; *p != '\0'; p++) {
+		XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
+	}
+}
+
+
+/* Busy-polls DMASR of one channel until it is idle, no usleep between reads */
+static int BenchWait(XAxiDma *DmaInstancePtr, u32 ChannelOffset)
+{
+	XTime Start, Now;
+
+	XTime_GetTime(&Start);
+	while (true) {
+		u32 Sr = XAxiDma_ReadReg(DmaInstancePtr->RegBase + ChannelOffset, XAXIDMA_SR_OFFSET);
+		if (Sr & XAXIDMA_ERR_ALL_MASK) {
+			xil_printf("DMA halted, DMASR 0x%08x\r\n", Sr);
+			return XST_DMA_ERROR;
+		}
+		if (Sr & XAXIDMA_IDLE_MASK) {
+			return XST_SUCCESS;
+		}
+		XTime_GetTime(&Now);
+		if (Now - Start > DMA_BENCH_TIMEOUT_TICKS) {
+			xil_printf("DMA timed out, DMASR 0x%08x\r\n", Sr);
+			return XST_DMA_ERROR;
+		}
+	}
+}
+
+
+/*
+ * Moves one packet of Bytes in transfers of at most DMA_BENCH_CHUNK_BYTES and
+ * returns the XTime ticks it took in Ticks. S2MM is armed before MM2S, as in
+ * RunRound. With BENCH_S2MM the IP produces every transfer from the command
+ * sent with the first one.
+ */
+static int BenchPacket(XAxiDma *DmaInstancePtr, BenchMode Mode, u32 Bytes, XTime *Ticks)
+{
+	u32 Chunk = Bytes < DMA_BENCH_CHUNK_BYTES ? Bytes : DMA_BENCH_CHUNK_BYTES;
+	u32 Transfers = Bytes / Chunk;
+	u8 *Tx = (u8 *) BenchTx;
+	u8 *Rx = (u8 *) BenchRx;
+	int Status = XST_SUCCESS;
+	XTime Start, End;
+
+	BenchCommand[0] = DMA_BENCH_SOURCE_COMMAND(Chunk / DMA_BENCH_BEAT_BYTES, Transfers);
+	Xil_DCacheFlushRange((UINTPTR) BenchCommand, sizeof(BenchCommand));
+	Xil_DCacheFlushRange((UINTPTR) Tx, Bytes);
+	Xil_DCacheFlushRange((UINTPTR) Rx, Bytes);
+
+	XTime_GetTime(&Start);
+	for (u32 t = 0; t < Transfers && Status == XST_SUCCESS; t++) {
+		if (Mode != BENCH_MM2S) {
+			Status = XAxiDma_SimpleTransfer(DmaInstancePtr, (UINTPTR) (Rx + t * Chunk), Chunk, XAXIDMA_DEVICE_TO_DMA);
+		}
+		if (Status == XST_SUCCESS && Mode != BENCH_S2MM) {
+			Status = XAxiDma_SimpleTransfer(DmaInstancePtr, (UINTPTR) (Tx + t * Chunk), Chunk, XAXIDMA_DMA_TO_DEVICE);
+		}
+		else if (Status == XST_SUCCESS && t == 0) {
+			Status = XAxiDma_SimpleTransfer(DmaInstancePtr, (UINTPTR) BenchCommand, DMA_BENCH_BEAT_BYTES,
+				XAXIDMA_DMA_TO_DEVICE);
+		}
+		if (Status == XST_SUCCESS && Mode != BENCH_S2MM) {
+			Status = BenchWait(DmaInstancePtr, XAXIDMA_TX_OFFSET);
+		}
+		if (Status == XST_SUCCESS && Mode != BENCH_MM2S) {
+			Status = BenchWait(DmaInstancePtr, XAXIDMA_RX_OFFSET);
+		}
+	}
+	XTime_GetTime(&End);
+
+	if (Mode != BENCH_MM2S) {
+		Xil_DCacheInvalidateRange((UINTPTR) Rx, Bytes);
+	}
+	*Ticks = End - Start;
+	return Status;
+}
+
+
+/* Words of the looped back packet that differ from the ones sent */
+static u32 BenchErrors(u32 Bytes)
+{
+	u32 Errors = 0;
+	for (u32 i = 0; i < Bytes / WORD_SIZE; i++) {
+		Errors += BenchRx[i] != BenchTx[i];
+	}
+	return Errors;
+}
+
+
+/* Sets the first word of every transfer of the largest packet to Command */
+static void BenchSetCommands(u32 Command)
+{
+	for (u32 i = 0; i < DMA_BENCH_MAX_BYTES / WORD_SIZE; i += DMA_BENCH_CHUNK_BYTES / WORD_SIZE) {
+		BenchTx[i] = Command | DMA_BENCH_PATTERN(i);
+	}
+}
+
+
+static u32 BenchMbps(u32 Bytes, XTime Ticks)
+{
+	return Ticks == 0 ? 0 : (u32)((u64)Bytes * COUNTS_PER_SECOND / Ticks / 1000000U);
+}
+
+
+/*
+ * Runs the sweep of every mode and sends its lines. SETUP is fitted on the
+ * packets of one transfer, the smallest and the largest, and PEAK_MBPS is the
+ * rate of the largest packet.
+ */
+int RunDmaBench(XAxiDma *DmaInstancePtr)
+{
+	char Line[128];
+
+	for (u32 i = 0; i < DMA_BENCH_MAX_BYTES / WORD_SIZE; i++) {
+		BenchTx[i] = DMA_BENCH_PATTERN(i);
+	}
+
+	xil_printf("DMA bandwidth sweep, %d to %d bytes\r\n", DMA_BENCH_MIN_BYTES, DMA_BENCH_MAX_BYTES);
+	for (int Mode = 0; Mode < BENCH_MODE_COUNT; Mode++) {
+		XTime FirstTicks = 0, SingleTicks = 0, LastTicks = 0;
+		u32 SingleBytes = DMA_BENCH_MIN_BYTES;
+
+		BenchSetCommands(Mode == BENCH_MM2S ? DMA_BENCH_SINK : DMA_BENCH_LOOP);
+		for (u32 Bytes = DMA_BENCH_MIN_BYTES; Bytes <= DMA_BENCH_MAX_BYTES; Bytes *= 2) {
+			XTime Best = 0;
+			for (int r = 0; r < DMA_BENCH_REPEATS; r++) {
+				XTime Ticks;
+				int Status = BenchPacket(DmaInstancePtr, (BenchMode) Mode, Bytes, &Ticks);
+				if (Status != XST_SUCCESS) {
+					xil_printf("%s transfer of %d bytes failed\r\n", BenchNames[Mode], Bytes);
+					return XST_FAILURE;
+				}
+				Best = (r == 0 || Ticks < Best) ? Ticks : Best;
+			}
+
+			sprintf(Line, "DMABENCH:DIR=%s,BYTES=%u,TRANSFERS=%u,CYCLES=%u,MBPS=%u", BenchNames[Mode],
+				(unsigned int)Bytes, (unsigned int)(Bytes < DMA_BENCH_CHUNK_BYTES ? 1 : Bytes / DMA_BENCH_CHUNK_BYTES),
+				(unsigned int)TICKS_TO_TIMER_CYCLES(Best), (unsigned int)BenchMbps(Bytes, Best));
+			BenchSendString(Line);
+			if (Mode == BENCH_BOTH && BenchErrors(Bytes) != 0) {
+				sprintf(Line, ",ERRORS=%u", (unsigned int)BenchErrors(Bytes));
+				BenchSendString(Line);
+			}
+			BenchSendString("\r\n");
+
+			FirstTicks = Bytes == DMA_BENCH_MIN_BYTES ? Best : FirstTicks;
+			if (Bytes <= DMA_BENCH_CHUNK_BYTES) {
+				SingleTicks = Best;
+				SingleBytes = Bytes;
+			}
+			LastTicks = Best;
+		}
+
+		// The smallest packet less the time its bytes take at the rate between the two
+		XTime Setup = FirstTicks;
+		if (SingleBytes > DMA_BENCH_MIN_BYTES && SingleTicks > FirstTicks) {
+			XTime Wire = (SingleTicks - FirstTicks) * DMA_BENCH_MIN_BYTES / (SingleBytes - DMA_BENCH_MIN_BYTES);
+			Setup = Wire < FirstTicks ? FirstTicks - Wire : 0;
+		}
+		sprintf(Line, "DMABENCH:DIR=%s,SETUP=%u,PEAK_MBPS=%u\r\n", BenchNames[Mode],
+			(unsigned int)TICKS_TO_TIMER_CYCLES(Setup), (unsigned int)BenchMbps(DMA_BENCH_MAX_BYTES, LastTicks));
+		BenchSendString(Line);
+	}
+	BenchSetCommands(DMA_BENCH_LOOP);
+
+	return XST_SUCCESS;
+}
+
+#endif /* DMA_BENCH */
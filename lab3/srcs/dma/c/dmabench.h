@@ -0,0 +1,81 @@
+/******************************************************************************
+* Raw DMA bandwidth microbenchmark for the DMA firmware.
+*
+* Build with -DDMA_BENCH against a block design with axis_loopback
+* (lab1/srcs) in place of myip_v1_0 behind AXI DMA 0. Instead of taking jobs,
+* main sweeps packet sizes from DMA_BENCH_MIN_BYTES to DMA_BENCH_MAX_BYTES,
+* doubling, through three modes of the loopback:
+*   MM2S  the packet is sent and dropped by the IP (SINK)
+*   S2MM  a one-beat command makes the IP produce the packet (SOURCE)
+*   BOTH  the packet is looped back, both channels run at once (LOOP)
+* The first word of every MM2S transfer is the command of axis_loopback. A
+* packet larger than DMA_BENCH_CHUNK_BYTES is moved in transfers of that size,
+* each started once the previous one is idle, as simple mode only takes one
+* at a time on a channel with a 14-bit length. Every point is run
+* DMA_BENCH_REPEATS times and the fastest run is kept. Times are taken with
+* XTime around the transfers only, from the first register write of a
+* channel to it reading idle, busy-polled without sleeping; cache maintenance
+* is done before and after. One line per point is sent on the UART:
+*   DMABENCH:DIR=MM2S,BYTES=64,TRANSFERS=1,CYCLES=..,MBPS=..
+* then one per mode with the fixed cost of a transfer, fitted as
+* cost = SETUP + BYTES / rate on the smallest and the largest packet of one
+* transfer, and the sustained rate of the largest packet:
+*   DMABENCH:DIR=MM2S,SETUP=..,PEAK_MBPS=..
+* CYCLES and SETUP are in cycles of the AXI timer (the PL clock). The looped
+* back data is checked after each BOTH point, ERRORS=.. is appended to its
+* line when words differ. The other modes of the firmware are not built.
+*
+* On the host: MYIP_SIM_LOOPBACK=2 puts the same loopback model behind the
+* simulated DMA.
+******************************************************************************/
+
+#ifndef DMABENCH_H
+#define DMABENCH_H
+
+#include "lab3_dma.h"
+
+/* Command word of axis_loopback, the first 32 bits of a packet */
+#define DMA_BENCH_LOOP          (0U << 30)  // echo the packet, the command included
+#define DMA_BENCH_SINK          (1U << 30)  // drop the packet
+#define DMA_BENCH_SOURCE        (2U << 30)  // then send Packets packets of Beats beats
+#define DMA_BENCH_SOURCE_COMMAND(Beats, Packets) \
+	(DMA_BENCH_SOURCE | ((u32)(Beats) & 0x3FFFU) << 16 | ((u32)(Packets) & 0xFFFFU))
+
+#ifndef DMA_BENCH_MIN_BYTES
+#define DMA_BENCH_MIN_BYTES     64
+#endif
+#ifndef DMA_BENCH_MAX_BYTES
+#define DMA_BENCH_MAX_BYTES     (4 << 20)
+#endif
+/* The largest power of two a transfer of 14-bit length takes */
+#ifndef DMA_BENCH_CHUNK_BYTES
+#define DMA_BENCH_CHUNK_BYTES   8192
+#endif
+#ifndef DMA_BENCH_REPEATS
+#define DMA_BENCH_REPEATS       4
+#endif
+/* A transfer still busy after this long is given up */
+#ifndef DMA_BENCH_TIMEOUT_US
+#define DMA_BENCH_TIMEOUT_US    10000
+#endif
+
+#define DMA_BENCH_BEAT_BYTES    (AXIS_DATA_WIDTH / 8)
+
+#ifdef DMA_BENCH
+
+#if defined(AMP_CPU) || defined(ENABLE_IP_COUNTERS)
+#error "DMA_BENCH runs on one core without myip, it cannot be combined with AMP_CPU or ENABLE_IP_COUNTERS"
+#endif
+#if DMA_BENCH_CHUNK_BYTES > DMA_MAX_TRANSFER_LEN || DMA_BENCH_CHUNK_BYTES / DMA_BENCH_BEAT_BYTES > 0x3FFF
+#error "A transfer of DMA_BENCH_CHUNK_BYTES must fit the DMA length register and the beats of a command"
+#endif
+#if (DMA_BENCH_MIN_BYTES & (DMA_BENCH_MIN_BYTES - 1)) != 0 || (DMA_BENCH_CHUNK_BYTES & (DMA_BENCH_CHUNK_BYTES - 1)) != 0 \
+	|| DMA_BENCH_MIN_BYTES < DMA_BENCH_BEAT_BYTES || DMA_BENCH_MAX_BYTES / DMA_BENCH_CHUNK_BYTES > 0xFFFF
+#error "DMA_BENCH sizes must be powers of two of whole beats, with at most 65535 transfers per packet"
+#endif
+
+int RunDmaBench(XAxiDma *DmaInstancePtr);
+
+#endif /* DMA_BENCH */
+
+#endif /* DMABENCH_H */
@@ -0,0 +1,135 @@
+/******************************************************************************
+* Hybrid CPU + accelerator execution of the DMA firmware, see hybrid.h.
+******************************************************************************/
+
+#include "lab3_dma.h"
+#include "sparse.h"
+
+#ifdef HYBRID_CPU
+
+#include "matmul_kernels.h"     // lab2/srcs
+
+typedef struct {
+	u32 **Source;           // TX buffers of the CPU shards, weights then B
+	u32 **Destination;      // Where their results go, like the S2MM of the shard
+	int Shards;
+	int Shard;              // Next row to compute
+	int Row;
+	const u32 *Entry;       // Packed words of the next row (SPARSE_A)
+	int Rows;               // Rows computed and the time they took
+	XTime Busy;
+	XTime IpStart;
+} CpuWork;
+
+static CpuWork Work;
+static int CpuShards;
+static u64 IpRoundTicks;    // Running averages, 0 until measured
+static u64 CpuRowTicks;
+
+
+#ifndef SPARSE_A
+/* The U8_Q8_ACC32_WRAP kernel of lab2 on one row, the same contract and masking as myip */
+DEFINE_MATMUL_ROW_U8_Q8_ACC32_WRAP(ComputeRow, MATRIX_A_COLS, MATRIX_B_COLS)
+#endif
+
+
+static u64 Average(u64 Old, u64 New)
+{
+	return Old == 0 ? New : (3 * Old + New) / 4;
+}
+
+
+int HybridCpuShards(void)
+{
+	return CpuShards;
+}
+
+
+void HybridBegin(u32 **Source, u32 **Destination, int Shards)
+{
+	Work.Source = Source;
+	Work.Destination = Destination;
+	Work.Shards = Shards;
+	Work.Shard = 0;
+	Work.Row = 0;
+	Work.Rows = 0;
+	Work.Busy = 0;
+	XTime_GetTime(&Work.IpStart);
+}
+
+
+bool HybridStep(void)
+{
+	XTime Start, End;
+
+	if (Work.Shard == Work.Shards) {
+		return false;
+	}
+
+	XTime_GetTime(&Start);
+	u32 *Source = Work.Source[Work.Shard];
+#ifdef SPARSE_A
+	if (Work.Row == 0) {
+		Work.Entry = Source + SHARD_A_OFFSET;
+	}
+	Work.Entry = SparseRow(Work.Entry, Source + SHARD_B_OFFSET, Work.Destination[Work.Shard] + Work.Row);
+#else
+	ComputeRow(Source + Work.Row * MATRIX_A_COLS, Source + SHARD_B_OFFSET,
+		Work.Destination[Work.Shard] + Work.Row * MATRIX_B_COLS);
+#endif
+	XTime_GetTime(&End);
+	Work.Busy += End - Start;
+	Work.Rows++;
+
+	if (++Work.Row == SHARD_ROWS) {
+		Work.Row = 0;
+		Work.Shard++;
+	}
+	return true;
+}
+
+
+/*
+ * Called once the accelerator rounds of the layer are done: computes the
+ * CPU rows still left, makes them visible to the DMA (they may be the B of
+ * the next layer) and re-tunes the split. An unmeasured side counts as
+ * free, so the first jobs probe the accelerator and then the CPU.
+ * Returns the time the CPU kept the layer going after the accelerator was
+ * done, in AXI timer cycles.
+ */
+u32 HybridFinish(int IpRounds)
+{
+	XTime IpEnd, End;
+	u64 Best = ~0ULL;
+
+	XTime_GetTime(&IpEnd);
+	while (HybridStep()) {
+	}
+	for (int s = 0; s < Work.Shards; s++) {
+		Xil_DCacheFlushRange((UINTPTR) Work.Destination[s], RX_PKT_LEN);
+	}
+	XTime_GetTime(&End);
+
+	if (IpRounds > 0) {
+		IpRoundTicks = Average(IpRoundTicks, (IpEnd - Work.IpStart) / IpRounds);
+	}
+	if (Work.Rows > 0) {
+		CpuRowTicks = Average(CpuRowTicks, Work.Busy / Work.Rows);
+	}
+
+	for (int k = 0; k <= NUM_SHARDS; k++) {
+		u64 Rounds = (NUM_SHARDS - k + NUM_DMA_INSTANCES - 1) / NUM_DMA_INSTANCES;
+		u64 Ip = Rounds * IpRoundTicks;
+		u64 Cpu = (u64)k * SHARD_ROWS * CpuRowTicks;
+		u64 Finish = Ip > Cpu ? Ip : Cpu;
+		if (Finish < Best) {
+			Best = Finish;
+			CpuShards = k;
+		}
+	}
+	xil_printf("Hybrid split: %d of %d shards on the CPU\r\n", CpuShards, NUM_SHARDS);
+
+	return TICKS_TO_TIMER_CYCLES(End - IpEnd);
+}
+
+#endif /* HYBRID_CPU */
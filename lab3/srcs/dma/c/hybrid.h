@@ -0,0 +1,41 @@
+/******************************************************************************
+* Hybrid CPU + accelerator execution of the DMA firmware.
+*
+* Build with -DHYBRID_CPU to let the CPU compute the last few row shards of
+* every layer itself, one row at a time inside the DMA busy-polling loops,
+* while the DMA/IP pairs run the others. After every layer the split is
+* re-tuned from the measured time of an accelerator round and of a CPU row
+* (XTime), picking the number of CPU shards that finishes both sides first.
+* With SPARSE_A the CPU rows skip the zeros of A as well (SparseRow), without
+* it they run the U8_Q8_ACC32_WRAP row of lab2/srcs/matmul_kernels.h, so add
+* lab2/srcs to the include paths of the application.
+* Without the flag everything runs on the accelerator and the hooks compile
+* to nothing.
+******************************************************************************/
+
+#ifndef HYBRID_H
+#define HYBRID_H
+
+#include "xil_types.h"
+#include "stdbool.h"
+
+#ifdef HYBRID_CPU
+
+int HybridCpuShards(void);
+void HybridBegin(u32 **Source, u32 **Destination, int Shards);
+bool HybridStep(void);
+u32 HybridFinish(int IpRounds);
+
+/* Spend the wait on a CPU row when there is one left */
+#define POLL_IDLE()                 do { if (!HybridStep()) usleep(1U); } while (0)
+
+#else
+
+#define HybridCpuShards()                       0
+#define HybridBegin(Source, Destination, Shards) do {} while (0)
+#define HybridFinish(IpRounds)                  0U
+#define POLL_IDLE()                             usleep(1U)
+
+#endif /* HYBRID_CPU */
+
+#endif /* HYBRID_H */
@@ -0,0 +1,46 @@
+/******************************************************************************
+* Performance counters inside the accelerator, see ipcounters.h.
+******************************************************************************/
+
+#include "ipcounters.h"
+
+#ifdef ENABLE_IP_COUNTERS
+
+#include "xil_io.h"
+
+static const char *IpCounterLabels[IP_COUNTER_COUNT] = {
+	",IPJOBS=", ",IPREADA=", ",IPREADB=", ",IPCOMPUTE=", ",IPWRITE=", ",IPINSTALLS=", ",IPOUTSTALLS="
+};
+
+
+static UINTPTR IpCountersBase(int Instance)
+{
+	return (UINTPTR)IP_COUNTERS_BASEADDR + (UINTPTR)Instance * IP_COUNTERS_STRIDE;
+}
+
+
+void IpCountersInit(int Count)
+{
+	for (int s = 0; s < Count; s++) {
+		Xil_Out32(IpCountersBase(s) + IP_COUNTERS_CTRL_OFFSET, IP_COUNTERS_CTRL_CLEAR);
+	}
+}
+
+
+void IpCountersRead(int Count, u32 Total[IP_COUNTER_COUNT])
+{
+	for (int i = 0; i < IP_COUNTER_COUNT; i++) {
+		Total[i] = 0;
+		for (int s = 0; s < Count; s++) {
+			Total[i] += Xil_In32(IpCountersBase(s) + IP_COUNTERS_FIRST_OFFSET + 4 * i);
+		}
+	}
+}
+
+
+const char *IpCounterLabel(IpCounterId Id)
+{
+	return IpCounterLabels[Id];
+}
+
+#endif /* ENABLE_IP_COUNTERS */
@@ -0,0 +1,67 @@
+/******************************************************************************
+* Performance counters inside the accelerator (lab1/srcs/perf_counters.sv).
+*
+* Every myip_v1_0 counts, on its own AXI4-Lite slave, the PL cycles it
+* spends per state, the cycles S_AXIS_TVALID is low while it waits for
+* input, the cycles M_AXIS_TREADY holds back a valid result, and the jobs
+* it has completed. Build with -DENABLE_IP_COUNTERS to clear them at start
+* up and read them into Stats when TERMINATE arrives, summed over the DMA/IP
+* pairs, as extra STATS fields:
+*   ,IPJOBS=..,IPREADA=..,IPREADB=..,IPCOMPUTE=..,IPWRITE=..,IPINSTALLS=..,IPOUTSTALLS=..
+* IPINSTALLS high against IPREADA + IPREADB means the IP was starved by the
+* DMA / interconnect, IPOUTSTALLS means S2MM could not keep up. The registers
+* are only read outside the timed section, so TX/RX/TOTAL are unchanged.
+* Without the flag every IP_COUNTERS_* macro compiles to nothing.
+*
+* The counters are 32-bit and wrap, about 43 s of one state at 100 MHz.
+* IP_COUNTERS_BASEADDR is the S_AXI base of the first instance, the next
+* ones are IP_COUNTERS_STRIDE apart (the address editor default of 64 KB).
+******************************************************************************/
+
+#ifndef IPCOUNTERS_H
+#define IPCOUNTERS_H
+
+#include "xil_types.h"
+#include "xparameters.h"
+
+/* Byte offsets of the register bank */
+#define IP_COUNTERS_CTRL_OFFSET     0x00    // write 1 to clear every counter
+#define IP_COUNTERS_FIRST_OFFSET    0x04    // IP_JOBS, the others follow at 4 byte steps
+
+#define IP_COUNTERS_CTRL_CLEAR      0x1
+
+typedef enum {
+	IP_JOBS = 0,
+	IP_READ_A,
+	IP_READ_B,
+	IP_COMPUTE,
+	IP_WRITE_OUTPUTS,
+	IP_IN_STALLS,
+	IP_OUT_STALLS,
+	IP_COUNTER_COUNT
+} IpCounterId;
+
+#ifndef IP_COUNTERS_BASEADDR
+#define IP_COUNTERS_BASEADDR        XPAR_MYIP_0_S_AXI_BASEADDR
+#endif
+#ifndef IP_COUNTERS_STRIDE
+#define IP_COUNTERS_STRIDE          0x10000U
+#endif
+
+#ifdef ENABLE_IP_COUNTERS
+
+void IpCountersInit(int Count);
+void IpCountersRead(int Count, u32 Total[IP_COUNTER_COUNT]);
+const char *IpCounterLabel(IpCounterId Id);
+
+#define IP_COUNTERS_INIT(Count)         IpCountersInit(Count)
+#define IP_COUNTERS_READ(Count, Total)  IpCountersRead(Count, Total)
+
+#else
+
+#define IP_COUNTERS_INIT(Count)         do {} while (0)
+#define IP_COUNTERS_READ(Count, Total)  do {} while (0)
+
+#endif /* ENABLE_IP_COUNTERS */
+
+#endif /* IPCOUNTERS_H */
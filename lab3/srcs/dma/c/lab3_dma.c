@@ -5,35 +5,77 @@
 ******************************************************************************/
 
 #include "lab3_dma.h"
-
-XAxiDma DmaInstance;
+#include "amp.h"
+#include "async.h"
+#include "dmabench.h"
+#include "layout.h"
+#include "sparse.h"
+#include "stream.h"
+
+XAxiDma DmaInstance[NUM_DMA_INSTANCES];
 XTmrCtr TmrCtrInstance;
 
-u32 MatrixA[MatrixA_Size];
-u32 MatrixB[MatrixB_Size];
-u32 SourceBuffer[TX_ELEMENTS];
-u32 DestinationBuffer[RX_ELEMENTS];
+#ifdef SDT
+static const UINTPTR DmaBaseAddress[] = {
+	XPAR_XAXIDMA_0_BASEADDR,
+#ifdef XPAR_XAXIDMA_1_BASEADDR
+	XPAR_XAXIDMA_1_BASEADDR,
+#endif
+#ifdef XPAR_XAXIDMA_2_BASEADDR
+	XPAR_XAXIDMA_2_BASEADDR,
+#endif
+#ifdef XPAR_XAXIDMA_3_BASEADDR
+	XPAR_XAXIDMA_3_BASEADDR,
+#endif
+};
+#endif
+
+#ifndef STREAM_ROWS
+/* Cache line aligned, the DMA and the CPU work on them by whole lines */
+u32 SourceBuffer[CHAIN_LAYERS][NUM_SHARDS][SHARD_TX_ELEMENTS] __attribute__((aligned(64))) OCM_DATA;
+u32 DestinationBuffer[RX_ELEMENTS] __attribute__((aligned(64))) OCM_DATA;
+#endif
 
 char TERMINATE_TOKEN[] = "TERMINATE";
 
 int main()
 {
 	int Status = XST_SUCCESS;
-	Stats stats = {0, 0, 0, 0};
+	Stats stats = {0};
 
 #ifdef XPAR_UARTNS550_0_BASEADDR
 	Uart550_Setup();
 #endif
 
+	Status = PMU_INIT();
+	if (Status != XST_SUCCESS) {
+		// Carry on without the per-phase counters, PmuBegin/PmuEnd/PmuDump do nothing now
+		xil_printf("PMU Initialization Failed, no PMU lines will be sent\r\n");
+	}
+
+	Status = LayoutInit();
+	if (Status != XST_SUCCESS) {
+		xil_printf("No TX layout for this IP\r\n");
+		return XST_FAILURE;
+	}
+
+#if defined(AMP_CPU) && AMP_CPU == 1
+	// The UART side of the AMP split never touches the DMA or the timer
+	return RunIoCore(&stats);
+#endif
+
+	for (int s = 0; s < NUM_DMA_INSTANCES; s++) {
 #ifndef SDT
-    Status = InitDMA(&DmaInstance, DMA_DEV_ID);
+		Status = InitDMA(&DmaInstance[s], DMA_DEV_ID + s);
 #else
-    Status = InitDMA(&DmaInstance, XPAR_XAXIDMA_0_BASEADDR);
+		Status = InitDMA(&DmaInstance[s], DmaBaseAddress[s]);
 #endif
-    if (Status != XST_SUCCESS) {
-        xil_printf("DMA Initialization Failed\r\n");
-        return XST_FAILURE;
-    }
+		if (Status != XST_SUCCESS) {
+			xil_printf("DMA %d Initialization Failed\r\n", s);
+			return XST_FAILURE;
+		}
+	}
+	IP_COUNTERS_INIT(NUM_DMA_INSTANCES);
 
 #ifndef SDT
     Status = InitTmrCtr(&TmrCtrInstance, TMRCTR_DEVICE_ID, TIMER_COUNTER_0);
@@ -45,9 +87,25 @@ int main()
         return XST_FAILURE;
     }
 
+#ifdef DMA_BENCH
+	return RunDmaBench(&DmaInstance[0]);
+#endif
+
+#if defined(AMP_CPU) && AMP_CPU == 0
+	return RunAcceleratorCore(DmaInstance, &TmrCtrInstance, TIMER_COUNTER_0);
+#endif
+
+#if defined(ASYNC_QUEUE_DEPTH) && ASYNC_QUEUE_DEPTH > 0
+	return RunAsyncJobs(DmaInstance, &stats);
+#endif
+
 	xil_printf("DMA IP Implementation\r\n");
 	while (true) {
-		Status = RunMatrixAssignment(&DmaInstance, &TmrCtrInstance, TIMER_COUNTER_0, &stats);
+#ifdef STREAM_ROWS
+		Status = RunStreamJob(DmaInstance, &TmrCtrInstance, TIMER_COUNTER_0, &stats);
+#else
+		Status = RunMatrixAssignment(DmaInstance, &TmrCtrInstance, TIMER_COUNTER_0, &stats);
+#endif
 		if (Status != XST_SUCCESS) {
 			xil_printf("Failed to execute\r\n");
 			xil_printf("--- Exiting main() ---\r\n");
@@ -59,46 +117,216 @@ int main()
 }
 
 
+#ifndef STREAM_ROWS
 int RunMatrixAssignment(XAxiDma *DmaInstancePtr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
 {
 	int Status;
+	ChainJob Job;
 
-	xil_printf("Ready! Please use RealTerm -> 'Send File' to send A.csv\r\n");
-    Status = ReceiveCSVData(MatrixA, MatrixA_Size, stats);
-    if (Status != XST_SUCCESS) {
-        xil_printf("Failed to receive Matrix A\r\n");
-        return XST_FAILURE;
-    }
+	TRACE_BEGIN(TRACE_JOB);
+	Status = ReceiveJob(SourceBuffer, stats);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	BuildChainJob(&Job, SourceBuffer, DestinationBuffer);
+	Status = RunChain(DmaInstancePtr, &Job, TmrCtrInstancePtr, TmrCtrNumber, stats);
+	if (Status != XST_SUCCESS) {
+		// The engines are reset, carry on with the next job instead of exiting main
+		xil_printf("Job dropped after %d replays\r\n", DMA_MAX_REPLAYS);
+		stats->DroppedJobs++;
+		SendErrorRows(MATRIX_A_ROWS);
+		TRACE_END(TRACE_JOB, 0);
+		return XST_SUCCESS;
+	}
+
+	xil_printf("Data received successfully!, output is a %dx%d matrix\r\n", MATRIX_A_ROWS, MATRIX_B_COLS);
+
+	TRACE_BEGIN(TRACE_SEND_RESULTS);
+	SendCSVResults(DestinationBuffer, MATRIX_A_ROWS, MATRIX_B_COLS);
+	TRACE_END(TRACE_SEND_RESULTS, RX_ELEMENTS);
+	TRACE_END(TRACE_JOB, stats->TotalElapsed);
+
+	return Status;
+}
+#endif /* STREAM_ROWS */
+
+
+/*
+ * Parses A a row at a time and B in one go, each straight into its place in
+ * the TX buffers through the layout stage (layout.h).
+ */
+int ReceiveJob(u32 Source[CHAIN_LAYERS][NUM_SHARDS][SHARD_TX_ELEMENTS], Stats *stats)
+{
+	int Status = XST_SUCCESS;
+	static u32 Values[MATRIX_A_COLS > MatrixB_Size ? MATRIX_A_COLS : MatrixB_Size];
+
+	for (int l = 0; l < CHAIN_LAYERS; l++) {
+		xil_printf("Ready! Please use RealTerm -> 'Send File' to send A.csv of layer %d\r\n", l);
+		TRACE_BEGIN(TRACE_RECEIVE_A);
+		for (int s = 0; s < NUM_SHARDS && Status == XST_SUCCESS; s++) {
+#ifdef SPARSE_A
+			Status = ReceiveSparseRows(Source[l][s] + SHARD_A_OFFSET, SHARD_ROWS, stats);
+#else
+			for (int r = 0; r < SHARD_ROWS && Status == XST_SUCCESS; r++) {
+				Status = ReceiveCSVData(Values, MATRIX_A_COLS, stats);
+				if (Status == XST_SUCCESS) {
+					LayoutWriteA(&TxLayout, Source[l][s], r, Values);
+				}
+			}
+#endif
+		}
+		TRACE_END(TRACE_RECEIVE_A, MatrixA_Size);
+		if (Status != XST_SUCCESS) {
+			xil_printf("Failed to receive Matrix A\r\n");
+			return XST_FAILURE;
+		}
+	}
     xil_printf("Matrix A Received. Now please send B.csv\r\n");
-    Status = ReceiveCSVData(MatrixB, MatrixB_Size, stats);
+	TRACE_BEGIN(TRACE_RECEIVE_B);
+    Status = ReceiveCSVData(Values, MatrixB_Size, stats);
+	TRACE_END(TRACE_RECEIVE_B, MatrixB_Size);
     if (Status != XST_SUCCESS) {
         xil_printf("Failed to receive Matrix B\r\n");
         return XST_FAILURE;
     }
+	LayoutWriteB(&TxLayout, Source[0][0], Values);
 
 	xil_printf("All data received successfully!\r\n");
-	xil_printf("Merging data into SourceBuffer...\r\n");
-	MergeArrays(SourceBuffer, MatrixA, MatrixA_Size, MatrixB, MatrixB_Size);
+	return XST_SUCCESS;
+}
 
-    FlushDCaches(SourceBuffer, DestinationBuffer);
 
-	Status = TxSend(DmaInstancePtr, SourceBuffer, TmrCtrInstancePtr, TmrCtrNumber, stats);
-	if (Status != XST_SUCCESS){
-		xil_printf("Transmission of Data failed\r\n");
-		return XST_FAILURE;
+void BuildChainJob(ChainJob *Job, u32 Source[CHAIN_LAYERS][NUM_SHARDS][SHARD_TX_ELEMENTS], u32 *Destination)
+{
+	Job->LayerCount = CHAIN_LAYERS;
+	for (int l = 0; l < CHAIN_LAYERS; l++) {
+		for (int s = 0; s < NUM_SHARDS; s++) {
+			Job->Source[l][s] = Source[l][s];
+			Job->Destination[l][s] = (l + 1 < CHAIN_LAYERS)
+				? Source[l + 1][0] + SHARD_B_OFFSET + s * SHARD_RX_WORDS
+				: Destination + s * SHARD_RX_WORDS;
+#ifdef SPARSE_A
+			Job->TxLength[l][s] = SparseTxLength(Source[l][s]);
+#else
+			Job->TxLength[l][s] = TX_PKT_LEN;
+#endif
+		}
 	}
+}
 
-	Status = RxReceive(DmaInstancePtr, DestinationBuffer, TmrCtrInstancePtr, TmrCtrNumber, stats);
-	if (Status != XST_SUCCESS){
-		xil_printf("Receiving data failed");
-		return XST_FAILURE;
+
+/*
+ * Each layer's results are gathered in row order into the B slot of shard 0
+ * of the next layer, every other shard needs its own copy of B.
+ */
+void ShareB(ChainJob *Job, int Layer)
+{
+	u32 *B = Job->Source[Layer][0] + SHARD_B_OFFSET;
+
+	for (int s = 1; s < NUM_SHARDS; s++) {
+		u32 *Copy = Job->Source[Layer][s] + SHARD_B_OFFSET;
+		for (int i = 0; i < B_SLOT_WORDS; i++) {
+			Copy[i] = B[i];
+		}
+		Xil_DCacheFlushRange((UINTPTR) Copy, B_SLOT_WORDS * WORD_SIZE);
 	}
+}
 
-	xil_printf("Data received successfully!, output is a %dx%d matrix\r\n", MATRIX_A_ROWS, MATRIX_B_COLS);
 
-	SendCSVResults(DestinationBuffer, MATRIX_A_ROWS, MATRIX_B_COLS);
+/*
+ * One round: a shard on each of the first Count instances. A round only
+ * reads its TX buffers, so after a timeout or a DMA error the engines are
+ * reset and it is simply sent again. The time lost stays in TotalElapsed.
+ */
+static int RunRound(XAxiDma *DmaInstancePtr, u32 **Source, u32 *Length, u32 **Destination, int Count,
+	XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
+{
+	int Status;
+	u32 Lost = 0;
+	u32 Bytes = 0;
 
-	return Status;
+	for (int s = 0; s < Count; s++) {
+		Bytes += Length[s];
+	}
+
+	for (int Replay = 0; ; Replay++) {
+		TRACE_BEGIN(TRACE_TX);
+		Status = TxSend(DmaInstancePtr, Source, Length, Count, TmrCtrInstancePtr, TmrCtrNumber, stats);
+		TRACE_END(TRACE_TX, Bytes);
+		if (Status == XST_SUCCESS) {
+			TRACE_BEGIN(TRACE_RX);
+			Status = RxReceive(DmaInstancePtr, Destination, Count, TmrCtrInstancePtr, TmrCtrNumber, stats);
+			TRACE_END(TRACE_RX, Count * RX_PKT_LEN);
+		}
+		if (Status == XST_SUCCESS) {
+			stats->TotalElapsed += Lost;
+			return XST_SUCCESS;
+		}
+
+		Lost += XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
+		XTmrCtr_Stop(TmrCtrInstancePtr, TmrCtrNumber);
+		if (ResetDMA(DmaInstancePtr, Count, stats) != XST_SUCCESS || Replay == DMA_MAX_REPLAYS) {
+			return XST_FAILURE;
+		}
+		stats->Replays++;
+	}
+}
+
+
+/*
+ * Runs the layers of a job back to back. Only the last layer's results come
+ * back to the CPU, the others never leave DDR. Stats are summed over layers.
+ */
+int RunChain(XAxiDma *DmaInstancePtr, ChainJob *Job, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
+{
+	int Status;
+
+	TRACE_BEGIN(TRACE_FLUSH);
+	for (int l = 0; l < Job->LayerCount; l++) {
+		for (int s = 0; s < NUM_SHARDS; s++) {
+			FlushDCaches(Job->Source[l][s], Job->Destination[l][s]);
+		}
+	}
+	TRACE_END(TRACE_FLUSH, Job->LayerCount * NUM_SHARDS * (TX_PKT_LEN + RX_PKT_LEN));
+
+	stats->TxElapsed = 0;
+	stats->RxElapsed = 0;
+	stats->TotalElapsed = 0;
+
+	for (int l = 0; l < Job->LayerCount; l++) {
+		TRACE_BEGIN(TRACE_LAYER);
+		if (NUM_SHARDS > 1) {
+			ShareB(Job, l);
+		}
+
+		// The last shards go to the CPU (HYBRID_CPU), which works on them while polling
+		int IpShards = NUM_SHARDS - HybridCpuShards();
+		int IpRounds = 0;
+		HybridBegin(&Job->Source[l][IpShards], &Job->Destination[l][IpShards], NUM_SHARDS - IpShards);
+
+		for (int First = 0; First < IpShards; First += NUM_DMA_INSTANCES, IpRounds++) {
+			int Count = (IpShards - First < NUM_DMA_INSTANCES) ? IpShards - First : NUM_DMA_INSTANCES;
+
+			Stats LayerStats = {0};
+			Status = RunRound(DmaInstancePtr, &Job->Source[l][First], &Job->TxLength[l][First],
+				&Job->Destination[l][First], Count, TmrCtrInstancePtr, TmrCtrNumber, &LayerStats);
+			AddDmaFaults(stats, &LayerStats);
+			if (Status != XST_SUCCESS){
+				xil_printf("Round %d of layer %d failed\r\n", IpRounds, l);
+				return XST_FAILURE;
+			}
+
+			stats->TxElapsed += LayerStats.TxElapsed;
+			stats->RxElapsed += LayerStats.RxElapsed;
+			stats->TotalElapsed += LayerStats.TotalElapsed;
+		}
+
+		stats->TotalElapsed += HybridFinish(IpRounds);
+		TRACE_END(TRACE_LAYER, l);
+	}
+
+	return XST_SUCCESS;
 }
 
 
@@ -109,28 +337,97 @@ void FlushDCaches(u32 *SourceAddr, u32 *DestinationAddr)
 }
 
 
-int TxSend(XAxiDma *DmaInstancePtr, u32  *SourceAddr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
+/*
+ * Polls DMASR of one channel of the first Count instances until all are
+ * idle. Fails on the first channel that halts with an error or is still
+ * busy DMA_TIMEOUT_US after the wait started.
+ */
+OCM_TEXT int WaitChannels(XAxiDma *DmaInstancePtr, int Count, u32 ChannelOffset, Stats *stats)
+{
+	XTime Start, Now;
+
+	XTime_GetTime(&Start);
+	for (int s = 0; s < Count; s++) {
+		while (true) {
+			u32 Sr = XAxiDma_ReadReg(DmaInstancePtr[s].RegBase + ChannelOffset, XAXIDMA_SR_OFFSET);
+			if (Sr & XAXIDMA_ERR_ALL_MASK) {
+				xil_printf("DMA %d halted, DMASR 0x%08x\r\n", s, Sr);
+				stats->DmaErrors++;
+				return XST_DMA_ERROR;
+			}
+			if (Sr & XAXIDMA_IDLE_MASK) {
+				break;
+			}
+			XTime_GetTime(&Now);
+			if (Now - Start > DMA_TIMEOUT_TICKS) {
+				xil_printf("DMA %d timed out, DMASR 0x%08x\r\n", s, Sr);
+				stats->DmaTimeouts++;
+				return XST_DMA_ERROR;
+			}
+			POLL_IDLE();
+		}
+	}
+	return XST_SUCCESS;
+}
+
+
+/*
+ * Soft resets the engines of the first Count instances, which also resets
+ * their IP as long as mm2s_prmry_reset_out_n drives its ARESETN in the
+ * block design. Interrupts come out of reset disabled, as InitDMA leaves them.
+ */
+int ResetDMA(XAxiDma *DmaInstancePtr, int Count, Stats *stats)
+{
+	TRACE_BEGIN(TRACE_RESET);
+	for (int s = 0; s < Count; s++) {
+		int TimeOut = RESET_TIMEOUT_COUNTER;
+
+		XAxiDma_Reset(&DmaInstancePtr[s]);
+		while (!XAxiDma_ResetIsDone(&DmaInstancePtr[s])) {
+			if (--TimeOut == 0) {
+				xil_printf("DMA %d reset timed out\r\n", s);
+				return XST_RESET_ERROR;
+			}
+		}
+		stats->DmaResets++;
+	}
+	TRACE_END(TRACE_RESET, Count);
+	return XST_SUCCESS;
+}
+
+
+/* Adds the fault counters of Job to Total */
+void AddDmaFaults(Stats *Total, const Stats *Job)
+{
+	Total->DmaTimeouts += Job->DmaTimeouts;
+	Total->DmaErrors += Job->DmaErrors;
+	Total->DmaResets += Job->DmaResets;
+	Total->Replays += Job->Replays;
+	Total->DroppedJobs += Job->DroppedJobs;
+}
+
+
+OCM_TEXT int TxSend(XAxiDma *DmaInstancePtr, u32 **SourceAddr, u32 *Length, int Count, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
 {
     int Status;
-    int TimeOut = POLL_TIMEOUT_COUNTER;
 	// Print before starting the timer to avoid affecting timing results, but still provide feedback to user
 	xil_printf("Transmitting Data...\r\n");
 
 	XTmrCtr_Reset(TmrCtrInstancePtr, TmrCtrNumber);
 	XTmrCtr_Start(TmrCtrInstancePtr, TmrCtrNumber);
 
-    Status = XAxiDma_SimpleTransfer(DmaInstancePtr, (UINTPTR) SourceAddr, TX_PKT_LEN, XAXIDMA_DMA_TO_DEVICE);
-    if (Status != XST_SUCCESS) {
-        xil_printf("Failed to start DMA transfer\r\n");
-        return XST_FAILURE;
-    }
-    while (TimeOut) {
-        if (!(XAxiDma_Busy(DmaInstancePtr, XAXIDMA_DMA_TO_DEVICE))) {
-            break;
-        }
-        TimeOut--;
-        usleep(1U);
-    }
+	// Start every MM2S transfer before waiting on any of them
+	for (int s = 0; s < Count; s++) {
+		Status = XAxiDma_SimpleTransfer(&DmaInstancePtr[s], (UINTPTR) SourceAddr[s], Length[s], XAXIDMA_DMA_TO_DEVICE);
+		if (Status != XST_SUCCESS) {
+			xil_printf("Failed to start DMA %d transfer\r\n", s);
+			return XST_FAILURE;
+		}
+	}
+	Status = WaitChannels(DmaInstancePtr, Count, XAXIDMA_TX_OFFSET, stats);
+	if (Status != XST_SUCCESS) {
+		return Status;
+	}
 
 	u32 TxElapsed = XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
 
@@ -140,30 +437,29 @@ int TxSend(XAxiDma *DmaInstancePtr, u32  *SourceAddr, XTmrCtr *TmrCtrInstancePtr
 }
 
 
-int RxReceive (XAxiDma *DmaInstancePtr, u32* DestinationAddr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
+OCM_TEXT int RxReceive (XAxiDma *DmaInstancePtr, u32 **DestinationAddr, int Count, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
 {
 	int Status;
-    int TimeOut = POLL_TIMEOUT_COUNTER;
 
     u32 Elapsed = XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
 
-    Status = XAxiDma_SimpleTransfer(DmaInstancePtr, (UINTPTR) DestinationAddr, RX_PKT_LEN, XAXIDMA_DEVICE_TO_DMA);
-    if (Status != XST_SUCCESS) {
-        xil_printf("Failed to start DMA receive\r\n");
-        return XST_FAILURE;
-    }
-
-    while (TimeOut) {
-            if (!(XAxiDma_Busy(DmaInstancePtr, XAXIDMA_DEVICE_TO_DMA))) {
-            break;
-        }
-        TimeOut--;
-        usleep(1U);
-    }
+	for (int s = 0; s < Count; s++) {
+		Status = XAxiDma_SimpleTransfer(&DmaInstancePtr[s], (UINTPTR) DestinationAddr[s], RX_PKT_LEN, XAXIDMA_DEVICE_TO_DMA);
+		if (Status != XST_SUCCESS) {
+			xil_printf("Failed to start DMA %d receive\r\n", s);
+			return XST_FAILURE;
+		}
+	}
+	Status = WaitChannels(DmaInstancePtr, Count, XAXIDMA_RX_OFFSET, stats);
+	if (Status != XST_SUCCESS) {
+		return Status;
+	}
 
     u32 TotalElapsed = XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
 	XTmrCtr_Stop(TmrCtrInstancePtr, TmrCtrNumber);
-    Xil_DCacheInvalidateRange((UINTPTR) DestinationAddr, RX_PKT_LEN);
+	for (int s = 0; s < Count; s++) {
+		Xil_DCacheInvalidateRange((UINTPTR) DestinationAddr[s], RX_PKT_LEN);
+	}
 
 	stats->TotalElapsed = TotalElapsed;  // Total elapsed time since Tx started, which includes MatMul and Rx
 	stats->RxElapsed = TotalElapsed - Elapsed;
@@ -179,7 +475,7 @@ int RxReceive (XAxiDma *DmaInstancePtr, u32* DestinationAddr, XTmrCtr *TmrCtrIns
 }
 
 
-int ReceiveCSVData(u32 *Buffer, int TotalElements, Stats *stats)
+OCM_TEXT int ReceiveCSVData(u32 *Buffer, int TotalElements, Stats *stats)
 {
     char msg[20];
     int msg_idx = 0;
@@ -201,12 +497,20 @@ int ReceiveCSVData(u32 *Buffer, int TotalElements, Stats *stats)
 
 				if (strcmp(msg, TERMINATE_TOKEN) == 0) {
 					xil_printf("Termination command received. Stopping reception.\r\n");
+#if defined(AMP_CPU) && AMP_CPU == 1
+					AmpDrain(stats);
+#endif
+#if defined(ASYNC_QUEUE_DEPTH) && ASYNC_QUEUE_DEPTH > 0
+					AsyncDrain(stats);
+#endif
 					SendStats(stats);
+					TRACE_DUMP();
 					return XST_FAILURE;
 				}
                 Buffer[count] = atoi(msg);
                 count++;
                 msg_idx = 0;
+                ASYNC_POLL();
 
                 if (count % 64 == 0) {
                     xil_printf("Progress: %d/%d values received\r\n", count, TotalElements);
@@ -234,29 +538,40 @@ int ReceiveCSVData(u32 *Buffer, int TotalElements, Stats *stats)
 }
 
 
-void MergeArrays(u32 *dest, u32 *A, int sizeA, u32 *B, int sizeB)
-{
-    for (int i = 0; i < sizeA; i++) {
-        dest[i] = A[i];
-    }
-    for (int i = 0; i < sizeB; i++) {
-        dest[sizeA + i] = B[i];
-    }
-}
-
-
+/* The fault counters are only appended once there was a fault */
 void SendStats(Stats *stats)
 {
 	char buf[12];
-	const char *labels[] = {"STATS:TX=", ",RX=", ",TOTAL="};
-	u32 values[] = {stats->TxElapsed, stats->RxElapsed, stats->TotalElapsed};
-	for (int l = 0; l < 3; l++) {
+	const char *labels[] = {"STATS:TX=", ",RX=", ",TOTAL=", ",TIMEOUTS=", ",DMAERRORS=", ",RESETS=", ",REPLAYS=", ",DROPPED="};
+	u32 values[] = {stats->TxElapsed, stats->RxElapsed, stats->TotalElapsed,
+		stats->DmaTimeouts, stats->DmaErrors, stats->DmaResets, stats->Replays, stats->DroppedJobs};
+	int Fields = (stats->DmaTimeouts | stats->DmaErrors | stats->DmaResets | stats->DroppedJobs) ? 8 : 3;
+	for (int l = 0; l < Fields; l++) {
 		for (const char *p = labels[l]; *p != '\0'; p++)
 			XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
 		sprintf(buf, "%u", (unsigned int)values[l]);
 		for (char *p = buf; *p != '\0'; p++)
 			XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
 	}
+#ifdef ENABLE_IP_COUNTERS
+	IP_COUNTERS_READ(NUM_DMA_INSTANCES, stats->IpCounters);
+	for (int i = 0; i < IP_COUNTER_COUNT; i++) {
+		for (const char *p = IpCounterLabel((IpCounterId)i); *p != '\0'; p++)
+			XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
+		sprintf(buf, "%u", (unsigned int)stats->IpCounters[i]);
+		for (char *p = buf; *p != '\0'; p++)
+			XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
+	}
+#endif
+#ifdef ENABLE_PMU
+	if (PmuMissingCounters() != 0) {
+		for (const char *p = ",PMU_MISSING="; *p != '\0'; p++)
+			XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
+		sprintf(buf, "%u", (unsigned int)PmuMissingCounters());
+		for (char *p = buf; *p != '\0'; p++)
+			XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
+	}
+#endif
 	XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, '\r');
 	XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, '\n');
 }
@@ -264,10 +579,12 @@ void SendStats(Stats *stats)
 
 void SendCSVResults(u32 *data, int rows, int cols)
 {
+	const Element *Values = (const Element *) data;
+
 	for (int i = 0; i < rows; i++) {
 		for (int j = 0; j < cols; j++) {
 			char buffer[12];
-			sprintf(buffer, "%d", data[i * cols + j]);
+			sprintf(buffer, "%d", (int) Values[i * cols + j]);
 			for (char *p = buffer; *p != '\0'; p++) {
 				XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
 			}
@@ -281,6 +598,19 @@ void SendCSVResults(u32 *data, int rows, int cols)
 }
 
 
+/* The answer of rows without results, one ERROR_ROW line for each */
+void SendErrorRows(int rows)
+{
+	for (int i = 0; i < rows; i++) {
+		for (const char *p = ERROR_ROW; *p != '\0'; p++) {
+			XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
+		}
+		XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, '\r');
+		XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, '\n');
+	}
+}
+
+
 #ifndef SDT
 int InitDMA(XAxiDma *DmaInstancePtr, u16 DmaDeviceId)
 #else
@@ -315,6 +645,13 @@ int InitDMA(XAxiDma *DmaInstancePtr, UINTPTR DmaBaseAddress)
 		return XST_FAILURE;
 	}
 
+	// The packing of the TX buffers is fixed at build time by AXIS_LANES
+	if (CfgPtr->Mm2SDataWidth != AXIS_DATA_WIDTH || CfgPtr->S2MmDataWidth != AXIS_DATA_WIDTH) {
+		xil_printf("DMA streams are %d/%d bits, built for %d\r\n",
+			CfgPtr->Mm2SDataWidth, CfgPtr->S2MmDataWidth, AXIS_DATA_WIDTH);
+		return XST_FAILURE;
+	}
+
 	/* Disable interrupts, we use polling mode
 	 */
 	XAxiDma_IntrDisable(DmaInstancePtr, XAXIDMA_IRQ_ALL_MASK,
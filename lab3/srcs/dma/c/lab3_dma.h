@@ -15,11 +15,15 @@
 #include "xtmrctr.h"
 #include "xuartps.h"
 #include "xaxidma.h"
+#include "xtime_l.h"
 #include "xparameters.h"
 #include "xdebug.h"
 #include "sleep.h"
 #include "stdio.h"
 #include "stdbool.h"
+#include "trace.h"
+#include "hybrid.h"
+#include "ipcounters.h"
 
 #ifdef XPAR_UARTNS550_0_BASEADDR
 #include "xuartns550_l.h"
@@ -63,13 +67,14 @@ DEFAULT SET TO 0x01000000
 #define RX_BUFFER_BASE		(MEM_BASE_ADDR + 0x00300000)
 // #define RX_BUFFER_HIGH		(MEM_BASE_ADDR + 0x004FFFFF)
 
-#define TX_PKT_LEN		0x820 // 520 words, 2080 bytes
-#define RX_PKT_LEN		0x100 // 64 words, 256 bytes
+#define TX_PKT_LEN		((ShardA_Size + BEAT_ELEMENTS(MatrixB_Size)) * ELEMENT_BYTES) // per instance, 520 words, 2080 bytes for 64x8, at most that with SPARSE_A
+#define RX_PKT_LEN		(SHARD_RX_ELEMENTS * ELEMENT_BYTES) // per instance, 64 words, 256 bytes for 64x8
+#define DMA_MAX_TRANSFER_LEN	((1 << 14) - 1)	// C_SG_LENGTH_WIDTH = 14 in lab3_dma.xsa
 
 #define TEST_START_VALUE	0xC
 
 #define NUMBER_OF_TRANSFERS	10
-#define POLL_TIMEOUT_COUNTER    1000000U
+#define RESET_TIMEOUT_COUNTER   10000U
 
 /* ----- Timer Definitions ----- */
 #ifndef SDT
@@ -81,27 +86,212 @@ DEFAULT SET TO 0x01000000
 #define TIMER_COUNTER_0     0
 #define WORD_SIZE           4
 
-/* ----- Matrix dimensions ----- */
+/* ----- Matrix dimensions (must match m, n and p of the IP, overridable with -D) ----- */
+/* MATRIX_B_COLS > 1 needs myip_systolic_v1_0 with p = MATRIX_B_COLS. B is then
+   received row-major, n rows of p values, and the results are sent as m rows of p */
+#ifndef MATRIX_A_ROWS
 #define MATRIX_A_ROWS 64
+#endif
+#ifndef MATRIX_A_COLS
 #define MATRIX_A_COLS 8
-#define MATRIX_B_ROWS 8
+#endif
+#define MATRIX_B_ROWS MATRIX_A_COLS
+#ifndef MATRIX_B_COLS
 #define MATRIX_B_COLS 1
+#endif
 
 #define MatrixA_Size    (MATRIX_A_COLS * MATRIX_A_ROWS)
 #define MatrixB_Size    (MATRIX_B_COLS * MATRIX_B_ROWS)
 #define TX_ELEMENTS    (MatrixA_Size + MatrixB_Size)
 #define RX_ELEMENTS    (MATRIX_A_ROWS * MATRIX_B_COLS)
 
+/* ----- Accelerator instances (one AXI DMA per myip, overridable with -D) ----- */
+/* The BSP numbers the DMA instances consecutively */
+#ifndef NUM_DMA_INSTANCES
+#ifndef SDT
+#ifdef XPAR_XAXIDMA_NUM_INSTANCES
+#define NUM_DMA_INSTANCES XPAR_XAXIDMA_NUM_INSTANCES
+#else
+#define NUM_DMA_INSTANCES 1
+#endif
+#else
+#if defined(XPAR_XAXIDMA_3_BASEADDR)
+#define NUM_DMA_INSTANCES 4
+#elif defined(XPAR_XAXIDMA_2_BASEADDR)
+#define NUM_DMA_INSTANCES 3
+#elif defined(XPAR_XAXIDMA_1_BASEADDR)
+#define NUM_DMA_INSTANCES 2
+#else
+#define NUM_DMA_INSTANCES 1
+#endif
+#endif
+#endif
+
+/* ----- Row shards of A (overridable with -D) ----- */
+/* A is cut into NUM_SHARDS shards of SHARD_ROWS rows and each IP is built
+   with m = SHARD_ROWS. Shard s runs on instance s % NUM_DMA_INSTANCES, in
+   rounds of NUM_DMA_INSTANCES shards, or on the CPU with HYBRID_CPU */
+#ifndef NUM_SHARDS
+#define NUM_SHARDS NUM_DMA_INSTANCES
+#endif
+#if MATRIX_A_ROWS % NUM_SHARDS != 0
+#error "MATRIX_A_ROWS must be a multiple of the number of shards"
+#endif
+
+#define SHARD_ROWS          (MATRIX_A_ROWS / NUM_SHARDS)
+#define ShardA_Size         (SHARD_ROWS * MATRIX_A_COLS)
+#define SHARD_TX_ELEMENTS   (ShardA_Size + MatrixB_Size)
+#define SHARD_RX_ELEMENTS   (SHARD_ROWS * MATRIX_B_COLS)
+
+/* CPU and DMA must never write the same cache line of the results */
+#if defined(HYBRID_CPU) && (SHARD_RX_ELEMENTS * WORD_SIZE) % 64 != 0
+#error "HYBRID_CPU needs the results of a shard to fill whole cache lines (SHARD_ROWS a multiple of 16)"
+#endif
+
+/* ----- AXI-Stream width (overridable with -D) ----- */
+/* AXIS_LANES elements per beat. With 1 every element is sent in bits [7:0]
+   of a 32-bit word. With 8 or 16 the elements are packed one byte each into
+   the 64 or 128-bit beats of myip_v1_0 built with lanes = AXIS_LANES, behind
+   DMA channels of that stream width. The TX buffers then hold bytes, B is
+   padded to whole beats and the results come back packed the same way */
+#ifndef AXIS_LANES
+#define AXIS_LANES 1
+#endif
+#if AXIS_LANES == 1
+#define AXIS_DATA_WIDTH     32
+#define ELEMENT_BYTES       WORD_SIZE
+typedef u32 Element;
+#elif AXIS_LANES == 8 || AXIS_LANES == 16
+#define AXIS_DATA_WIDTH     (AXIS_LANES * 8)
+#define ELEMENT_BYTES       1
+typedef u8 Element;
+#else
+#error "AXIS_LANES must be 1, 8 or 16"
+#endif
+#define ELEMENTS_PER_WORD   (WORD_SIZE / ELEMENT_BYTES)
+#define BEAT_ELEMENTS(Count) (((Count) + AXIS_LANES - 1) / AXIS_LANES * AXIS_LANES)
+
+#if AXIS_LANES > 1 && (ShardA_Size % AXIS_LANES != 0 || SHARD_RX_ELEMENTS % AXIS_LANES != 0)
+#error "AXIS_LANES must divide the elements of A and the rows of a shard"
+#endif
+#if AXIS_LANES > 1 && (defined(SPARSE_A) || defined(STREAM_ROWS) || defined(HYBRID_CPU) || defined(AMP_CPU))
+#error "AXIS_LANES cannot be combined with SPARSE_A, STREAM_ROWS, HYBRID_CPU or AMP_CPU"
+#endif
+#if MATRIX_B_COLS > 1 && (AXIS_LANES > 1 || defined(STREAM_ROWS))
+#error "MATRIX_B_COLS > 1 (myip_systolic_v1_0) cannot be combined with AXIS_LANES or STREAM_ROWS"
+#endif
+#if defined(ENABLE_IP_COUNTERS) && (MATRIX_B_COLS > 1 || defined(STREAM_ROWS))
+#error "ENABLE_IP_COUNTERS needs myip_v1_0, myip_systolic_v1_0 and myip_stream_v1_0 have no counter bank"
+#endif
+
+/* u32 offsets in the TX buffer of a shard and of a shard's results */
+#define SHARD_RX_WORDS      (SHARD_RX_ELEMENTS / ELEMENTS_PER_WORD)
+#define B_SLOT_WORDS        (BEAT_ELEMENTS(MatrixB_Size) / ELEMENTS_PER_WORD)
+
+/* ----- Sparse A (opt-in with -DSPARSE_A) ----- */
+/* Only the non-zeros of A are sent, see sparse.h. B then comes first in the
+   TX buffer of a shard, so that it keeps a fixed offset in front of the
+   variable number of packed rows */
+#ifdef SPARSE_A
+#define SHARD_B_OFFSET      0
+#define SHARD_A_OFFSET      MatrixB_Size
+#else
+#define SHARD_B_OFFSET      (ShardA_Size / ELEMENTS_PER_WORD)
+#define SHARD_A_OFFSET      0
+#endif
+
+/* ----- Layer chaining (overridable with -D) ----- */
+/* Weight matrices applied in sequence per job, the results of each layer are
+   gathered by the DMA straight into the B slot of the next layer's TX buffer */
+#ifndef CHAIN_LAYERS
+#define CHAIN_LAYERS 1
+#endif
+#if CHAIN_LAYERS > 1 && RX_ELEMENTS != MatrixB_Size
+#error "Chaining layers needs a square IP (MATRIX_A_ROWS == MATRIX_A_COLS)"
+#endif
+
+/* ----- Row streaming (opt-in with -DSTREAM_ROWS) ----- */
+/* B is loaded into the IP once per job and the rows of A follow in chunks of
+   STREAM_CHUNK_ROWS rows, see stream.h. No buffer is sized by MATRIX_A_ROWS.
+   The default is 64 rows, or as many as one transfer takes */
+#if defined(STREAM_ROWS) && !defined(STREAM_CHUNK_ROWS)
+#if 64 * MATRIX_A_COLS * WORD_SIZE > DMA_MAX_TRANSFER_LEN
+#define STREAM_CHUNK_ROWS   (DMA_MAX_TRANSFER_LEN / (MATRIX_A_COLS * WORD_SIZE))
+#else
+#define STREAM_CHUNK_ROWS   64
+#endif
+#endif
+#if defined(STREAM_ROWS) && !defined(DMA_TIMEOUT_US)
+#define DMA_TIMEOUT_US      (10 + 4 * (MatrixB_Size + STREAM_CHUNK_ROWS * (2 * MATRIX_A_COLS + 2)) / 100)
+#endif
+
+/* ----- Fault recovery (overridable with -D) ----- */
+/* A channel that is neither idle nor halted with an error DMA_TIMEOUT_US
+   after the wait on it started is taken as stalled. The round is then reset
+   and replayed, at most DMA_MAX_REPLAYS times before the job is dropped.
+   The default is 4x a round at one beat per PL cycle (100 MHz) plus 10 us.
+   A dropped job still answers with MATRIX_A_ROWS lines, ERROR_ROW in place
+   of every row without a result, so the host stays in step with the jobs */
+#ifndef DMA_TIMEOUT_US
+#define DMA_TIMEOUT_US      (10 + 4 * (SHARD_TX_ELEMENTS + SHARD_ROWS * (MATRIX_A_COLS + 4) + SHARD_RX_ELEMENTS) / 100)
+#endif
+#ifndef DMA_MAX_REPLAYS
+#define DMA_MAX_REPLAYS     3
+#endif
+#define DMA_TIMEOUT_TICKS   ((XTime)DMA_TIMEOUT_US * (COUNTS_PER_SECOND / 1000000U))
+#define ERROR_ROW           "ERROR"
+
+/* ----- Memory placement (opt-in with -DOCM_BUFFERS and -DOCM_CODE) ----- */
+/* The DMA buffers marked OCM_DATA go to section .ocm_data and the hot
+   functions marked OCM_TEXT to .ocm_text, which lab3/srcs/lscript_ocm.ld
+   places in the 256 KB OCM when it is added to the link. Without the flags
+   they stay in .bss and .text, in DDR. lab3/scripts/placement.py prints the
+   map of a build and compares the per-phase PMU lines of the two */
+#ifdef OCM_BUFFERS
+#define OCM_DATA    __attribute__((section(".ocm_data")))
+#else
+#define OCM_DATA
+#endif
+#ifdef OCM_CODE
+#define OCM_TEXT    __attribute__((section(".ocm_text"), noinline))
+#else
+#define OCM_TEXT
+#endif
+
+/* XTime ticks to cycles of the AXI timer, the unit of Stats */
+#define TICKS_TO_TIMER_CYCLES(Ticks) \
+	((u32)((Ticks) * (XPAR_TMRCTR_0_CLOCK_FREQ_HZ / 1000U) / (COUNTS_PER_SECOND / 1000U)))
+
 /* ----- Timing stats struct ----- */
 typedef struct {
     u32 TxElapsed;
     u32 RxElapsed;
     u32 MatMulElapsed;
     u32 TotalElapsed;
+    // Fault counters, cumulative over jobs
+    u32 DmaTimeouts;    // Channel waits that ran out of DMA_TIMEOUT_US
+    u32 DmaErrors;      // Channels halted with an error bit in DMASR
+    u32 DmaResets;      // Engines reset
+    u32 Replays;        // Rounds run again after a reset
+    u32 DroppedJobs;    // Jobs given up after DMA_MAX_REPLAYS
+    // Accelerator counters (ipcounters.h), PL cycles summed over the IPs, read at TERMINATE
+    u32 IpCounters[IP_COUNTER_COUNT];
 } Stats;
 
+/* ----- Job descriptor ----- */
+typedef struct {
+    int LayerCount;
+    u32 *Source[CHAIN_LAYERS][NUM_SHARDS];      // Rows of the layer's weights followed by its B vector
+    u32 *Destination[CHAIN_LAYERS][NUM_SHARDS]; // Rows of the B slot of the next layer, of DestinationBuffer for the last one
+    u32 TxLength[CHAIN_LAYERS][NUM_SHARDS];     // Bytes sent from each Source, TX_PKT_LEN unless SPARSE_A
+} ChainJob;
+
 /* ----- Function declarations ----- */
 int RunMatrixAssignment(XAxiDma *DmaInstancePtr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats);
+int ReceiveJob(u32 Source[CHAIN_LAYERS][NUM_SHARDS][SHARD_TX_ELEMENTS], Stats *stats);
+void BuildChainJob(ChainJob *Job, u32 Source[CHAIN_LAYERS][NUM_SHARDS][SHARD_TX_ELEMENTS], u32 *Destination);
+void ShareB(ChainJob *Job, int Layer);
+int RunChain(XAxiDma *DmaInstancePtr, ChainJob *Job, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats);
 
 #ifndef SDT
 int InitDMA(XAxiDma *DmaInstancePtr, u16 DmaDeviceId);
@@ -112,20 +302,22 @@ int InitTmrCtr(XTmrCtr *TmrCtrInstancePtr, UINTPTR TmrCtrBaseAddress, u8 TmrCtrN
 #endif
 
 void FlushDCaches(u32 *SourceAddr, u32 *DestinationAddr);
+int WaitChannels(XAxiDma *DmaInstancePtr, int Count, u32 ChannelOffset, Stats *stats);
+int ResetDMA(XAxiDma *DmaInstancePtr, int Count, Stats *stats);
+void AddDmaFaults(Stats *Total, const Stats *Job);
 
 int TxSend(
-    XAxiDma *DmaInstancePtr, u32  *SourceAddr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats
+    XAxiDma *DmaInstancePtr, u32 **SourceAddr, u32 *Length, int Count, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats
 );
 
 int RxReceive (
-    XAxiDma *DmaInstancePtr, u32* DestinationAddr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats
+    XAxiDma *DmaInstancePtr, u32 **DestinationAddr, int Count, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats
 );
 
 int ReceiveCSVData(u32 *Buffer, int TotalElements, Stats *stats);
 void SendCSVResults(u32 *data, int rows, int cols);
+void SendErrorRows(int rows);
 void SendStats(Stats *stats);
 
-void MergeArrays(u32 *dest, u32 *A, int sizeA, u32 *B, int sizeB);
-
 
 #endif /* LAB3_DMA_H */
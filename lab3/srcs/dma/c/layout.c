@@ -0,0 +1,113 @@
+/******************************************************************************
+* TX layout stage of the DMA firmware, see layout.h.
+******************************************************************************/
+
+#include "layout.h"
+#include "string.h"
+
+#ifdef ENABLE_IP_COUNTERS
+#include "xil_io.h"
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+Layout TxLayout = {
+#ifdef SPARSE_A
+	LAYOUT_B_FIRST,
+#else
+	LAYOUT_A_FIRST,
+#endif
+	AXIS_LANES,
+	LAYOUT_BANKS
+};
+
+
+int LayoutInit(void)
+{
+#ifdef ENABLE_IP_COUNTERS
+	u32 Caps = Xil_In32(IP_COUNTERS_BASEADDR + LAYOUT_CAPS_OFFSET);
+
+	if (!LAYOUT_CAPS_VALID(Caps)) {
+		xil_printf("IP advertises no capabilities, keeping the layout of the build\r\n");
+		return XST_SUCCESS;
+	}
+	if (LAYOUT_CAPS_LANES(Caps) != TxLayout.Lanes || LAYOUT_CAPS_B_FIRST(Caps) != (u32)TxLayout.Order) {
+		xil_printf("IP takes %d lanes%s, the build sends %d lanes%s\r\n",
+			(int)LAYOUT_CAPS_LANES(Caps), LAYOUT_CAPS_B_FIRST(Caps) ? " B first" : "",
+			(int)TxLayout.Lanes, TxLayout.Order == LAYOUT_B_FIRST ? " B first" : "");
+		return XST_FAILURE;
+	}
+	u32 Banks = LAYOUT_CAPS_BANKS(Caps) ? LAYOUT_CAPS_BANKS(Caps) : 1;
+	if (SHARD_ROWS % Banks != 0 || (LAYOUT_ROW_MAJOR_ONLY && Banks > 1)) {
+		xil_printf("IP reads A from %d banks, not possible with this build\r\n", (int)Banks);
+		return XST_FAILURE;
+	}
+	TxLayout.Banks = Banks;
+#endif
+	return XST_SUCCESS;
+}
+
+
+/* Low byte of Count words, 16 at a time with NEON */
+static void LayoutNarrow(u8 *Dest, const u32 *Values, int Count)
+{
+	int i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	for (; i + 16 <= Count; i += 16) {
+		uint16x8_t Low = vcombine_u16(vmovn_u32(vld1q_u32(Values + i)), vmovn_u32(vld1q_u32(Values + i + 4)));
+		uint16x8_t High = vcombine_u16(vmovn_u32(vld1q_u32(Values + i + 8)), vmovn_u32(vld1q_u32(Values + i + 12)));
+		vst1q_u8(Dest + i, vcombine_u8(vmovn_u16(Low), vmovn_u16(High)));
+	}
+#endif
+	for (; i < Count; i++) {
+		Dest[i] = (u8) Values[i];
+	}
+}
+
+
+/* Count values to element Index of Shard on, Stride elements apart */
+static void LayoutStore(const Layout *L, u32 *Shard, u32 Index, u32 Stride, const u32 *Values, int Count)
+{
+	if (L->Lanes == 1) {
+		u32 *Dest = Shard + Index;
+		if (Stride == 1) {
+			memcpy(Dest, Values, Count * sizeof(u32));
+		}
+		else {
+			for (int i = 0; i < Count; i++) {
+				Dest[i * Stride] = Values[i];
+			}
+		}
+	}
+	else {
+		u8 *Dest = (u8 *) Shard + Index;
+		if (Stride == 1) {
+			LayoutNarrow(Dest, Values, Count);
+		}
+		else {
+			for (int i = 0; i < Count; i++) {
+				Dest[i * Stride] = (u8) Values[i];
+			}
+		}
+	}
+}
+
+
+void LayoutWriteA(const Layout *L, u32 *Shard, int Row, const u32 *Values)
+{
+	u32 Base = (L->Order == LAYOUT_B_FIRST) ? MatrixB_Size : 0;
+	u32 Tile = Row / L->Banks;
+	u32 Bank = Row % L->Banks;
+
+	LayoutStore(L, Shard, Base + Tile * L->Banks * MATRIX_A_COLS + Bank, L->Banks, Values, MATRIX_A_COLS);
+}
+
+
+void LayoutWriteB(const Layout *L, u32 *Shard, const u32 *Values)
+{
+	u32 Base = (L->Order == LAYOUT_B_FIRST) ? 0 : ShardA_Size;
+
+	LayoutStore(L, Shard, Base, 1, Values, MatrixB_Size);
+}
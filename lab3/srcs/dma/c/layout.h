@@ -0,0 +1,70 @@
+/******************************************************************************
+* TX layout stage of the DMA firmware.
+*
+* ReceiveJob parses A one row at a time and B in one go, and hands the
+* values to LayoutWriteA / LayoutWriteB, which store them straight into the
+* TX buffer of their shard in the order the IP reads them. Nothing is copied
+* or packed again before MM2S. A layout is
+*   Order  LAYOUT_A_FIRST, A then B (myip_v1_0), or LAYOUT_B_FIRST, B then A
+*          (myip_v1_0 with sparse = 1, SPARSE_A)
+*   Lanes  1: one element per 32-bit word, 8 / 16: one byte per element,
+*          packed into the beats of myip_v1_0 built with lanes = AXIS_LANES
+*   Banks  1: A row-major. N: row-interleaved, element k of rows
+*          t*N .. t*N+N-1 next to each other, for an IP that deals the rows
+*          of A to N banks and reads them in step (-DLAYOUT_BANKS)
+* The byte packing is vectorized with NEON where the compiler targets it.
+*
+* TxLayout starts as the layout of the build. With the S_AXI bank of the IP
+* mapped (-DENABLE_IP_COUNTERS) LayoutInit reads the capabilities the IP
+* advertises in its CAPS register (perf_counters.sv) and takes its bank
+* count. Order and lanes also size the buffers and the DMA stream width, so
+* an IP that wants others than the build is reported and LayoutInit fails.
+******************************************************************************/
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include "lab3_dma.h"
+
+/* CAPS register of the S_AXI bank, see perf_counters.sv */
+#define LAYOUT_CAPS_OFFSET      0x20
+#define LAYOUT_CAPS_LANES(Caps)     ((Caps) & 0xFFU)
+#define LAYOUT_CAPS_BANKS(Caps)     (((Caps) >> 8) & 0xFFU)
+#define LAYOUT_CAPS_B_FIRST(Caps)   (((Caps) >> 16) & 0x1U)
+#define LAYOUT_CAPS_VALID(Caps)     (((Caps) >> 24) == 0x4DU)   // 'M', older bitstreams read 0
+
+#ifndef LAYOUT_BANKS
+#define LAYOUT_BANKS 1
+#endif
+#if SHARD_ROWS % LAYOUT_BANKS != 0
+#error "LAYOUT_BANKS must divide the rows of a shard"
+#endif
+/* The CPU rows of HYBRID_CPU, the packed rows of SPARSE_A and the results
+   gathered into B by CHAIN_LAYERS all need A row-major */
+#if defined(HYBRID_CPU) || defined(SPARSE_A) || CHAIN_LAYERS > 1
+#define LAYOUT_ROW_MAJOR_ONLY 1
+#else
+#define LAYOUT_ROW_MAJOR_ONLY 0
+#endif
+#if LAYOUT_BANKS > 1 && LAYOUT_ROW_MAJOR_ONLY
+#error "LAYOUT_BANKS cannot be combined with HYBRID_CPU, SPARSE_A or CHAIN_LAYERS"
+#endif
+
+typedef enum {
+	LAYOUT_A_FIRST = 0,
+	LAYOUT_B_FIRST
+} LayoutOrder;
+
+typedef struct {
+	LayoutOrder Order;
+	u32 Lanes;
+	u32 Banks;
+} Layout;
+
+extern Layout TxLayout;
+
+int LayoutInit(void);
+void LayoutWriteA(const Layout *L, u32 *Shard, int Row, const u32 *Values);
+void LayoutWriteB(const Layout *L, u32 *Shard, const u32 *Values);
+
+#endif /* LAYOUT_H */
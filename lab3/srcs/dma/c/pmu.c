@@ -0,0 +1,266 @@
+/******************************************************************************
+* Per-phase hardware counters for the DMA firmware, see pmu.h.
+******************************************************************************/
+
+#include "pmu.h"
+
+#ifdef ENABLE_PMU
+
+/* System headers of the host backend first, the BSP sleep.h of the
+ * co-simulation (through lab3_dma.h) redefines sleep() */
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "lab3_dma.h"
+#include "string.h"
+
+static const char *PmuNames[PMU_COUNTER_COUNT] = {
+	"CYCLES", "INSTRUCTIONS", "L1D_REFILLS", "EXCEPTIONS", "STALLS"
+};
+
+/* Set by a successful PmuInit, the phases are neither sampled nor dumped without it */
+static int PmuEnabled;
+
+/* Bit per PmuCounterId that reads 0, sent as PMU_MISSING in the STATS line */
+static u32 PmuMissing;
+
+#if defined(__aarch64__) && !defined(__linux__)
+
+/*
+* A53 PMUv3. PMCCNTR_EL0 is 64-bit with PMCR_EL0.LC set, the event counters
+* are 32-bit and wrap, so their deltas are taken modulo 2^32.
+*/
+#define PMCR_E          (1U << 0)
+#define PMCR_P          (1U << 1)
+#define PMCR_C          (1U << 2)
+#define PMCR_LC         (1U << 6)
+#define PMCNTEN_CYCLES  (1U << 31)
+
+#define PMU_EVENT_COUNTERS (PMU_COUNTER_COUNT - 1)
+
+static const u32 PmuEvents[PMU_EVENT_COUNTERS] = {
+	PMU_EVENT_INSTRUCTIONS, PMU_EVENT_L1D_REFILLS, PMU_EVENT_EXCEPTIONS, PMU_EVENT_STALLS
+};
+
+#define PMU_READ_SYSREG(Reg, Value)  __asm__ volatile("mrs %0, " #Reg : "=r"(Value))
+#define PMU_WRITE_SYSREG(Reg, Value) __asm__ volatile("msr " #Reg ", %0" : : "r"((u64)(Value)))
+#define PMU_ISB()                    __asm__ volatile("isb" : : : "memory")
+
+
+static int PmuEventImplemented(u32 Event)
+{
+	u64 Ceid;
+
+	if (Event >= 0x40) {
+		return 1;   // implementation defined, not described by PMCEID
+	}
+	if (Event < 32) {
+		PMU_READ_SYSREG(PMCEID0_EL0, Ceid);
+	} else {
+		PMU_READ_SYSREG(PMCEID1_EL0, Ceid);
+	}
+	return (Ceid >> (Event & 31)) & 1;
+}
+
+
+int PmuInit(void)
+{
+	u64 Pmcr;
+	u32 Available;
+
+	PMU_READ_SYSREG(PMCR_EL0, Pmcr);
+	Available = (u32)(Pmcr >> 11) & 0x1F;
+	if (Available < PMU_EVENT_COUNTERS) {
+		PmuMissing = (1U << PMU_COUNTER_COUNT) - 1;
+		return XST_FAILURE;
+	}
+
+	for (int i = 0; i < PMU_EVENT_COUNTERS; i++) {
+		if (!PmuEventImplemented(PmuEvents[i])) {
+			PmuMissing |= 1U << (i + 1);
+		}
+		PMU_WRITE_SYSREG(PMSELR_EL0, i);
+		PMU_ISB();
+		PMU_WRITE_SYSREG(PMXEVTYPER_EL0, PmuEvents[i]);
+	}
+
+	PMU_WRITE_SYSREG(PMCR_EL0, PMCR_E | PMCR_P | PMCR_C | PMCR_LC);
+	PMU_WRITE_SYSREG(PMCNTENSET_EL0, PMCNTEN_CYCLES | ((1U << PMU_EVENT_COUNTERS) - 1));
+	PMU_ISB();
+	PmuEnabled = 1;
+	return XST_SUCCESS;
+}
+
+
+void PmuRead(PmuSample *Sample)
+{
+	u64 Value;
+
+	PMU_ISB();
+	PMU_READ_SYSREG(PMCCNTR_EL0, Value);
+	Sample->Value[PMU_CYCLES] = Value;
+	for (int i = 0; i < PMU_EVENT_COUNTERS; i++) {
+		PMU_WRITE_SYSREG(PMSELR_EL0, i);
+		PMU_ISB();
+		PMU_READ_SYSREG(PMXEVCNTR_EL0, Value);
+		Sample->Value[i + 1] = Value;
+	}
+}
+
+
+static u64 PmuDelta(int Counter, u64 End, u64 Begin)
+{
+	if (Counter == PMU_CYCLES) {
+		return End - Begin;
+	}
+	return (u32)(End - Begin);
+}
+
+#elif defined(__linux__)
+
+/*
+* Host co-simulation: the closest perf_event_open events, user space of the
+* calling thread only. Page faults stand in for exceptions taken.
+*/
+
+static int PmuFd[PMU_COUNTER_COUNT] = { -1, -1, -1, -1, -1 };
+
+
+static int PmuOpen(u32 Type, u64 Config)
+{
+	struct perf_event_attr Attr;
+
+	memset(&Attr, 0, sizeof(Attr));
+	Attr.size = sizeof(Attr);
+	Attr.type = Type;
+	Attr.config = Config;
+	Attr.exclude_kernel = 1;
+	Attr.exclude_hv = 1;
+	return (int)syscall(__NR_perf_event_open, &Attr, 0, -1, -1, 0);
+}
+
+
+int PmuInit(void)
+{
+	PmuFd[PMU_CYCLES] = PmuOpen(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	PmuFd[PMU_INSTRUCTIONS] = PmuOpen(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+	PmuFd[PMU_L1D_REFILLS] = PmuOpen(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+		(PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+	PmuFd[PMU_EXCEPTIONS] = PmuOpen(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+	PmuFd[PMU_STALLS] = PmuOpen(PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND);
+
+	int Opened = 0;
+	for (int i = 0; i < PMU_COUNTER_COUNT; i++) {
+		if (PmuFd[i] < 0) {
+			PmuMissing |= 1U << i;
+		} else {
+			Opened++;
+		}
+	}
+	if (Opened == 0) {
+		return XST_FAILURE;     // perf_event_open refused, e.g. perf_event_paranoid
+	}
+	PmuEnabled = 1;
+	return XST_SUCCESS;
+}
+
+
+void PmuRead(PmuSample *Sample)
+{
+	for (int i = 0; i < PMU_COUNTER_COUNT; i++) {
+		u64 Value = 0;
+		if (PmuFd[i] < 0 || read(PmuFd[i], &Value, sizeof(Value)) != (ssize_t)sizeof(Value)) {
+			Value = 0;
+		}
+		Sample->Value[i] = Value;
+	}
+}
+
+
+static u64 PmuDelta(int Counter, u64 End, u64 Begin)
+{
+	(void)Counter;
+	return End - Begin;
+}
+
+#else
+#error "ENABLE_PMU needs an AArch64 bare-metal or a Linux host build"
+#endif
+
+typedef struct {
+	u32 Count;
+	u64 Sum[PMU_COUNTER_COUNT];
+} PmuTotal;
+
+static PmuTotal PmuTotals[TRACE_EVENT_COUNT];
+static PmuSample PmuOpenSample[TRACE_EVENT_COUNT];
+
+
+u32 PmuMissingCounters(void)
+{
+	return PmuMissing;
+}
+
+
+void PmuBegin(u32 Phase)
+{
+	if (!PmuEnabled) {
+		return;
+	}
+	PmuRead(&PmuOpenSample[Phase]);
+}
+
+
+void PmuEnd(u32 Phase)
+{
+	PmuSample Now;
+	if (!PmuEnabled) {
+		return;
+	}
+	PmuRead(&Now);
+
+	PmuTotal *Total = &PmuTotals[Phase];
+	for (int i = 0; i < PMU_COUNTER_COUNT; i++) {
+		Total->Sum[i] += PmuDelta(i, Now.Value[i], PmuOpenSample[Phase].Value[i]);
+	}
+	Total->Count++;
+}
+
+
+static void PmuSendString(const char *Str)
+{
+	for (const char *p = Str; *p != '\0'; p++) {
+		XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
+	}
+}
+
+
+void PmuDump(void)
+{
+	char Line[64];
+
+	if (!PmuEnabled) {
+		return;
+	}
+	for (u32 Phase = 0; Phase < TRACE_EVENT_COUNT; Phase++) {
+		PmuTotal *Total = &PmuTotals[Phase];
+		if (Total->Count == 0) {
+			continue;
+		}
+		sprintf(Line, "PMU:PHASE=%s,COUNT=%u", TraceEventName((TraceEventId)Phase), (unsigned int)Total->Count);
+		PmuSendString(Line);
+		for (int i = 0; i < PMU_COUNTER_COUNT; i++) {
+			sprintf(Line, ",%s=%llu", PmuNames[i], (unsigned long long)Total->Sum[i]);
+			PmuSendString(Line);
+		}
+		PmuSendString("\r\n");
+	}
+
+	memset(PmuTotals, 0, sizeof(PmuTotals));
+}
+
+#endif /* ENABLE_PMU */
@@ -0,0 +1,82 @@
+/******************************************************************************
+* Per-phase hardware counters for the DMA firmware.
+*
+* Build with -DENABLE_PMU to sample the performance monitor around every
+* phase marked with TRACE_BEGIN/TRACE_END (trace.h) and add up, per phase,
+* the number of calls and the counter deltas below. The totals are dumped
+* over the UART after the STATS line when TERMINATE arrives, one line per
+* phase:
+*   PMU:PHASE=TxSend,COUNT=40,CYCLES=..,INSTRUCTIONS=..,L1D_REFILLS=..,EXCEPTIONS=..,STALLS=..
+* Without the flag every PMU_* macro compiles to nothing and PMU_INIT() is
+* XST_SUCCESS. When PmuInit fails the counters are left alone and no PMU
+* line is sent. Counters that read 0, all of them when PmuInit failed, are
+* reported in the STATS line as PMU_MISSING, one bit per PmuCounterId, only
+* when there is one.
+*
+* Backends, same API:
+*   board  the A53 PMUv3, read through system registers, so sampling costs
+*          no bus access: PMCCNTR_EL0 (CPU clock) and four event counters
+*          programmed with PMU_EVENT_* (overridable with -D)
+*   host   perf_event_open on the calling thread (__linux__), user space
+*          only. Counters the host does not offer read as 0. In the
+*          co-simulation the TX/RX phases include the simulator itself,
+*          the parsing, formatting and cache phases are the firmware's own
+******************************************************************************/
+
+#ifndef PMU_H
+#define PMU_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+typedef enum {
+	PMU_CYCLES = 0,
+	PMU_INSTRUCTIONS,
+	PMU_L1D_REFILLS,
+	PMU_EXCEPTIONS,
+	PMU_STALLS,
+	PMU_COUNTER_COUNT
+} PmuCounterId;
+
+typedef struct {
+	u64 Value[PMU_COUNTER_COUNT];
+} PmuSample;
+
+/* PMUv3 event numbers of the event counters */
+#ifndef PMU_EVENT_INSTRUCTIONS
+#define PMU_EVENT_INSTRUCTIONS  0x08    // INST_RETIRED
+#endif
+#ifndef PMU_EVENT_L1D_REFILLS
+#define PMU_EVENT_L1D_REFILLS   0x03    // L1D_CACHE_REFILL
+#endif
+#ifndef PMU_EVENT_EXCEPTIONS
+#define PMU_EVENT_EXCEPTIONS    0x09    // EXC_TAKEN
+#endif
+#ifndef PMU_EVENT_STALLS
+#define PMU_EVENT_STALLS        0x24    // STALL_BACKEND, optional in ARMv8.0, see PMU_MISSING
+#endif
+
+#ifdef ENABLE_PMU
+
+int PmuInit(void);
+void PmuRead(PmuSample *Sample);
+void PmuBegin(u32 Phase);
+void PmuEnd(u32 Phase);
+void PmuDump(void);
+u32 PmuMissingCounters(void);
+
+#define PMU_INIT()              PmuInit()
+#define PMU_BEGIN(Phase)        PmuBegin(Phase)
+#define PMU_END(Phase)          PmuEnd(Phase)
+#define PMU_DUMP()              PmuDump()
+
+#else
+
+#define PMU_INIT()              (XST_SUCCESS)
+#define PMU_BEGIN(Phase)        do {} while (0)
+#define PMU_END(Phase)          do {} while (0)
+#define PMU_DUMP()              do {} while (0)
+
+#endif /* ENABLE_PMU */
+
+#endif /* PMU_H */
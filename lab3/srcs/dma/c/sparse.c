@@ -0,0 +1,80 @@
+/******************************************************************************
+* Sparse A for the DMA firmware, see sparse.h.
+******************************************************************************/
+
+#include "sparse.h"
+
+#ifdef SPARSE_A
+
+static u32 Pairs[2 * MATRIX_A_COLS];
+
+
+/*
+ * Receives Rows rows of A in CSR form and packs their non-zeros into
+ * Entries, one word each. A shard never takes more words than its dense
+ * rows would, every row has at most MATRIX_A_COLS of them.
+ */
+int ReceiveSparseRows(u32 *Entries, int Rows, Stats *stats)
+{
+	for (int i = 0; i < Rows; i++) {
+		u32 Count;
+
+		if (ReceiveCSVData(&Count, 1, stats) != XST_SUCCESS) {
+			return XST_FAILURE;
+		}
+		if (Count > MATRIX_A_COLS) {
+			xil_printf("ERROR: Row %d has %u non-zeros, at most %d columns\r\n", i, Count, MATRIX_A_COLS);
+			return XST_FAILURE;
+		}
+		if (Count == 0) {
+			*Entries++ = SPARSE_EOR;
+			continue;
+		}
+		if (ReceiveCSVData(Pairs, 2 * Count, stats) != XST_SUCCESS) {
+			return XST_FAILURE;
+		}
+		for (u32 k = 0; k < Count; k++) {
+			u32 Col = Pairs[2 * k];
+			if (Col >= MATRIX_A_COLS) {
+				xil_printf("ERROR: Row %d has a non-zero in column %u\r\n", i, Col);
+				return XST_FAILURE;
+			}
+			*Entries++ = (Pairs[2 * k + 1] & SPARSE_VALUE_MASK) | (Col << SPARSE_COL_SHIFT)
+				| (k + 1 == Count ? SPARSE_EOR : 0);
+		}
+	}
+	return XST_SUCCESS;
+}
+
+
+/* Bytes to send from a shard's TX buffer: B and the packed words of SHARD_ROWS rows */
+u32 SparseTxLength(const u32 *Source)
+{
+	const u32 *Entry = Source + SHARD_A_OFFSET;
+
+	for (int i = 0; i < SHARD_ROWS; i++) {
+		while (!(*Entry++ & SPARSE_EOR)) {
+		}
+	}
+	return (u32)(Entry - Source) * WORD_SIZE;
+}
+
+
+/*
+ * One row on the CPU, same contract as myip. Returns the first word of the
+ * next row.
+ */
+const u32 *SparseRow(const u32 *Entry, const u32 *B, u32 *RES)
+{
+	u32 Acc = 0;
+	u32 Word;
+
+	do {
+		Word = *Entry++;
+		Acc += ((Word & SPARSE_VALUE_MASK) * B[(Word >> SPARSE_COL_SHIFT) & SPARSE_COL_MASK]) >> 8;
+	} while (!(Word & SPARSE_EOR));
+	*RES = Acc & 0xFF;
+	return Entry;
+}
+
+#endif /* SPARSE_A */
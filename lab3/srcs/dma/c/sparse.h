@@ -0,0 +1,39 @@
+/******************************************************************************
+* Sparse A for the DMA firmware.
+*
+* Build with -DSPARSE_A, and myip_v1_0 with sparse = 1, to receive the rows
+* of A in compressed sparse row form and send only their non-zeros, so the
+* UART, the MM2S transfer and the MAC loop of the IP all scale with the
+* number of non-zeros instead of m x n. Every row of A is one CSV line
+*   k,c1,v1,...,ck,vk
+* with its k non-zeros as (column, value) pairs, B follows as before. Each
+* non-zero is packed into one TX word, behind B:
+*   [7:0] value  [23:8] column  [31] SPARSE_EOR, last word of the row
+* An empty row is sent as a single zero with SPARSE_EOR set. The results keep
+* the myip contract, RES = (sum((A * B) >> 8)) & 0xFF, as every skipped
+* product is 0.
+******************************************************************************/
+
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include "lab3_dma.h"
+
+#define SPARSE_VALUE_MASK   0xFFU
+#define SPARSE_COL_SHIFT    8
+#define SPARSE_COL_MASK     0xFFFFU
+#define SPARSE_EOR          (1U << 31)
+
+#ifdef SPARSE_A
+
+#if MATRIX_B_COLS != 1 || MATRIX_A_COLS > SPARSE_COL_MASK + 1
+#error "SPARSE_A needs a single column of B and at most 65536 columns of A"
+#endif
+
+int ReceiveSparseRows(u32 *Entries, int Rows, Stats *stats);
+u32 SparseTxLength(const u32 *Source);
+const u32 *SparseRow(const u32 *Entry, const u32 *B, u32 *RES);
+
+#endif /* SPARSE_A */
+
+#endif /* SPARSE_H */
@@ -0,0 +1,68 @@
+/******************************************************************************
+* Lock-free single-producer/single-consumer ring of u32 messages.
+*
+* Head is only written by the producer and Tail only by the consumer, each on
+* its own cache line. Push publishes the entry (and everything written before
+* it) with a store-release of Head, Pop returns the entry to the producer with
+* a store-release of Tail; the loads of the other side's index are
+* load-acquire. On the A53 these are LDAR/STLR, so no DMB is needed. Header
+* only, the host build tests the same code with two threads
+* (lab3/srcs/sim/spsc_ring_test.cpp).
+******************************************************************************/
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include "xil_types.h"
+#include "stdbool.h"
+
+/* Must be a power of two */
+#ifndef SPSC_RING_ENTRIES
+#define SPSC_RING_ENTRIES   4
+#endif
+#define SPSC_CACHE_LINE     64
+
+typedef struct {
+	u32 Head __attribute__((aligned(SPSC_CACHE_LINE)));    // next entry to write
+	u32 Tail __attribute__((aligned(SPSC_CACHE_LINE)));    // next entry to read
+	u32 Entries[SPSC_RING_ENTRIES] __attribute__((aligned(SPSC_CACHE_LINE)));
+} SpscRing;
+
+
+static inline void SpscRingInit(SpscRing *Ring)
+{
+	__atomic_store_n(&Ring->Head, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&Ring->Tail, 0, __ATOMIC_RELAXED);
+}
+
+
+/* Producer side, returns false when the ring is full */
+static inline bool SpscRingPush(SpscRing *Ring, u32 Value)
+{
+	u32 Head = __atomic_load_n(&Ring->Head, __ATOMIC_RELAXED);
+	u32 Tail = __atomic_load_n(&Ring->Tail, __ATOMIC_ACQUIRE);
+
+	if (Head - Tail == SPSC_RING_ENTRIES) {
+		return false;
+	}
+	Ring->Entries[Head & (SPSC_RING_ENTRIES - 1)] = Value;
+	__atomic_store_n(&Ring->Head, Head + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+
+/* Consumer side, returns false when the ring is empty */
+static inline bool SpscRingPop(SpscRing *Ring, u32 *Value)
+{
+	u32 Tail = __atomic_load_n(&Ring->Tail, __ATOMIC_RELAXED);
+	u32 Head = __atomic_load_n(&Ring->Head, __ATOMIC_ACQUIRE);
+
+	if (Head == Tail) {
+		return false;
+	}
+	*Value = Ring->Entries[Tail & (SPSC_RING_ENTRIES - 1)];
+	__atomic_store_n(&Ring->Tail, Tail + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+#endif /* SPSC_RING_H */
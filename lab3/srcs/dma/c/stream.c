@@ -0,0 +1,156 @@
+/******************************************************************************
+* Row streaming for the DMA firmware, see stream.h.
+******************************************************************************/
+
+#include "stream.h"
+
+#ifdef STREAM_ROWS
+
+/* Cache line aligned, the DMA and the CPU work on them by whole lines */
+static u32 StreamB[MatrixB_Size] __attribute__((aligned(64))) OCM_DATA;
+static u32 ChunkA[STREAM_CHUNK_ROWS * MATRIX_A_COLS] __attribute__((aligned(64))) OCM_DATA;
+static u32 ChunkRes[STREAM_CHUNK_ROWS * MATRIX_B_COLS] __attribute__((aligned(64))) OCM_DATA;
+
+
+/*
+ * One transfer through the IP: S2MM is armed before MM2S, as the IP only
+ * holds a few results and stops taking rows once they are not collected.
+ * ResLength is 0 for B, which gives no results. The times are added to stats.
+ */
+static int StreamTransfer(XAxiDma *DmaInstancePtr, u32 *Source, u32 Length, u32 *Res, u32 ResLength,
+	XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
+{
+	int Status = XST_SUCCESS;
+
+	XTmrCtr_Reset(TmrCtrInstancePtr, TmrCtrNumber);
+	XTmrCtr_Start(TmrCtrInstancePtr, TmrCtrNumber);
+
+	if (ResLength != 0) {
+		Status = XAxiDma_SimpleTransfer(DmaInstancePtr, (UINTPTR) Res, ResLength, XAXIDMA_DEVICE_TO_DMA);
+	}
+	if (Status == XST_SUCCESS) {
+		Status = XAxiDma_SimpleTransfer(DmaInstancePtr, (UINTPTR) Source, Length, XAXIDMA_DMA_TO_DEVICE);
+	}
+	if (Status != XST_SUCCESS) {
+		xil_printf("Failed to start a stream transfer\r\n");
+		return XST_FAILURE;
+	}
+
+	TRACE_BEGIN(TRACE_TX);
+	Status = WaitChannels(DmaInstancePtr, 1, XAXIDMA_TX_OFFSET, stats);
+	TRACE_END(TRACE_TX, Length);
+	u32 TxElapsed = XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
+	if (Status == XST_SUCCESS && ResLength != 0) {
+		TRACE_BEGIN(TRACE_RX);
+		Status = WaitChannels(DmaInstancePtr, 1, XAXIDMA_RX_OFFSET, stats);
+		TRACE_END(TRACE_RX, ResLength);
+	}
+	u32 TotalElapsed = XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
+	XTmrCtr_Stop(TmrCtrInstancePtr, TmrCtrNumber);
+
+	// The time lost on a failed transfer stays in TotalElapsed, as with RunRound
+	stats->TotalElapsed += TotalElapsed;
+	if (Status != XST_SUCCESS) {
+		return Status;
+	}
+	stats->TxElapsed += TxElapsed;
+	stats->RxElapsed += TotalElapsed - TxElapsed;
+	return XST_SUCCESS;
+}
+
+
+/* Loads B into the IP, then runs one chunk of Rows rows. Reset and replayed on a fault */
+static int RunStreamChunk(XAxiDma *DmaInstancePtr, bool LoadB, int Rows,
+	XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
+{
+	int Status;
+	u32 ResLength = Rows * MATRIX_B_COLS * WORD_SIZE;
+
+	for (int Replay = 0; ; Replay++) {
+		Status = LoadB
+			? StreamTransfer(DmaInstancePtr, StreamB, MatrixB_Size * WORD_SIZE, NULL, 0, TmrCtrInstancePtr, TmrCtrNumber, stats)
+			: XST_SUCCESS;
+		if (Status == XST_SUCCESS) {
+			Status = StreamTransfer(DmaInstancePtr, ChunkA, Rows * MATRIX_A_COLS * WORD_SIZE, ChunkRes, ResLength,
+				TmrCtrInstancePtr, TmrCtrNumber, stats);
+		}
+		if (Status == XST_SUCCESS) {
+			Xil_DCacheInvalidateRange((UINTPTR) ChunkRes, ResLength);
+			return XST_SUCCESS;
+		}
+
+		if (ResetDMA(DmaInstancePtr, 1, stats) != XST_SUCCESS || Replay == DMA_MAX_REPLAYS) {
+			return XST_FAILURE;
+		}
+		stats->Replays++;
+		LoadB = true;
+	}
+}
+
+
+/*
+ * One job: B, then MATRIX_A_ROWS rows a chunk at a time. Once a chunk is
+ * dropped the rest of the job's rows are still read off the UART and
+ * answered with ERROR_ROW lines, and the job is counted in DroppedJobs.
+ */
+int RunStreamJob(XAxiDma *DmaInstancePtr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
+{
+	int Status;
+	bool Dropped = false;
+
+	TRACE_BEGIN(TRACE_JOB);
+	xil_printf("Ready! Please send B.csv, then the %d rows of A.csv\r\n", MATRIX_A_ROWS);
+	TRACE_BEGIN(TRACE_RECEIVE_B);
+	Status = ReceiveCSVData(StreamB, MatrixB_Size, stats);
+	TRACE_END(TRACE_RECEIVE_B, MatrixB_Size);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Failed to receive Matrix B\r\n");
+		return XST_FAILURE;
+	}
+	StreamB[0] |= STREAM_LOAD_B;
+	Xil_DCacheFlushRange((UINTPTR) StreamB, MatrixB_Size * WORD_SIZE);
+
+	stats->TxElapsed = 0;
+	stats->RxElapsed = 0;
+	stats->TotalElapsed = 0;
+
+	for (int Row = 0; Row < MATRIX_A_ROWS; Row += STREAM_CHUNK_ROWS) {
+		int Rows = (MATRIX_A_ROWS - Row < STREAM_CHUNK_ROWS) ? MATRIX_A_ROWS - Row : STREAM_CHUNK_ROWS;
+
+		TRACE_BEGIN(TRACE_RECEIVE_A);
+		Status = ReceiveCSVData(ChunkA, Rows * MATRIX_A_COLS, stats);
+		TRACE_END(TRACE_RECEIVE_A, Rows * MATRIX_A_COLS);
+		if (Status != XST_SUCCESS) {
+			xil_printf("Failed to receive Matrix A\r\n");
+			return XST_FAILURE;
+		}
+		if (Dropped) {
+			SendErrorRows(Rows);
+			continue;
+		}
+
+		TRACE_BEGIN(TRACE_FLUSH);
+		Xil_DCacheFlushRange((UINTPTR) ChunkA, Rows * MATRIX_A_COLS * WORD_SIZE);
+		Xil_DCacheFlushRange((UINTPTR) ChunkRes, Rows * MATRIX_B_COLS * WORD_SIZE);
+		TRACE_END(TRACE_FLUSH, Rows * (MATRIX_A_COLS + MATRIX_B_COLS) * WORD_SIZE);
+
+		Status = RunStreamChunk(DmaInstancePtr, Row == 0, Rows, TmrCtrInstancePtr, TmrCtrNumber, stats);
+		if (Status != XST_SUCCESS) {
+			// The engine is reset, the next job loads B again
+			xil_printf("Job dropped at row %d after %d replays\r\n", Row, DMA_MAX_REPLAYS);
+			stats->DroppedJobs++;
+			Dropped = true;
+			SendErrorRows(Rows);
+			continue;
+		}
+
+		TRACE_BEGIN(TRACE_SEND_RESULTS);
+		SendCSVResults(ChunkRes, Rows, MATRIX_B_COLS);
+		TRACE_END(TRACE_SEND_RESULTS, Rows * MATRIX_B_COLS);
+	}
+
+	TRACE_END(TRACE_JOB, stats->TotalElapsed);
+	return XST_SUCCESS;
+}
+
+#endif /* STREAM_ROWS */
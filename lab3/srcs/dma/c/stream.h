@@ -0,0 +1,39 @@
+/******************************************************************************
+* Row streaming for the DMA firmware.
+*
+* Build with -DSTREAM_ROWS, against myip_stream_v1_0 (lab1/srcs), for A
+* taller than any IP RAM: a job sends B first over the UART, then its
+* MATRIX_A_ROWS rows of A. B is loaded into the IP once, then the rows are
+* received, sent and answered in chunks of STREAM_CHUNK_ROWS rows, one MM2S
+* and one S2MM transfer each, while the IP keeps a single row in flight
+* through its MAC. Neither side holds more than B and one chunk, so
+* MATRIX_A_ROWS is only bounded by time. The first word of B is sent with
+* STREAM_LOAD_B set, the rows as they are. Results are sent as every chunk
+* comes back, in row order, with the myip contract.
+* Stats are summed over the chunks of a job, and a chunk is replayed after a
+* reset like a round, B first since the reset clears it from the IP.
+******************************************************************************/
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "lab3_dma.h"
+
+#define STREAM_LOAD_B       (1U << 31)
+
+#ifdef STREAM_ROWS
+
+#if NUM_SHARDS != 1 || CHAIN_LAYERS != 1 || defined(SPARSE_A) || defined(HYBRID_CPU) || defined(AMP_CPU) \
+	|| (defined(ASYNC_QUEUE_DEPTH) && ASYNC_QUEUE_DEPTH > 0)
+#error "STREAM_ROWS runs one DMA/IP pair without shards, layers, SPARSE_A, HYBRID_CPU, AMP_CPU or ASYNC_QUEUE_DEPTH"
+#endif
+
+#if STREAM_CHUNK_ROWS * MATRIX_A_COLS * WORD_SIZE > DMA_MAX_TRANSFER_LEN
+#error "A chunk of STREAM_CHUNK_ROWS rows must fit one DMA transfer"
+#endif
+
+int RunStreamJob(XAxiDma *DmaInstancePtr, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats);
+
+#endif /* STREAM_ROWS */
+
+#endif /* STREAM_H */
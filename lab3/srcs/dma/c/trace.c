@@ -0,0 +1,96 @@
+/******************************************************************************
+* Per-phase event tracer for the DMA firmware, see trace.h.
+******************************************************************************/
+
+#include "trace.h"
+
+static const char *TraceNames[TRACE_EVENT_COUNT] = {
+	"Job", "ReceiveCSVData A", "ReceiveCSVData B", "Layer",
+	"FlushDCaches", "TxSend", "RxReceive", "SendCSVResults", "ResetDMA"
+};
+
+
+const char *TraceEventName(TraceEventId Id)
+{
+	return TraceNames[Id];
+}
+
+#ifdef ENABLE_TRACE
+
+#include "xparameters.h"
+#include "xtime_l.h"
+#include "xuartps.h"
+#include "stdio.h"
+
+typedef struct {
+	XTime Start;
+	u32 Duration;
+	u32 Arg;
+	u32 Id;
+} TraceEntry;
+
+static TraceEntry TraceBuffer[TRACE_BUFFER_ENTRIES];
+static u32 TraceHead;
+static XTime TraceOpen[TRACE_EVENT_COUNT];
+
+
+void TraceBegin(TraceEventId Id)
+{
+	XTime_GetTime(&TraceOpen[Id]);
+}
+
+
+void TraceEnd(TraceEventId Id, u32 Arg)
+{
+	XTime Now;
+	XTime_GetTime(&Now);
+
+	TraceEntry *Entry = &TraceBuffer[TraceHead & (TRACE_BUFFER_ENTRIES - 1)];
+	Entry->Start = TraceOpen[Id];
+	Entry->Duration = (u32)(Now - TraceOpen[Id]);
+	Entry->Arg = Arg;
+	Entry->Id = Id;
+	TraceHead++;
+}
+
+
+static void TraceSendString(const char *Str)
+{
+	for (const char *p = Str; *p != '\0'; p++) {
+		XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
+	}
+}
+
+
+/* Ticks to microseconds with three decimals, as Chrome trace "ts"/"dur" expect.
+ * Whole seconds are scaled apart from the rest, Ticks * 10^9 would overflow
+ * after about three minutes of uptime at 100 MHz */
+static void TraceFormatMicroseconds(char *Buffer, u64 Ticks)
+{
+	u64 Nanoseconds = (Ticks / COUNTS_PER_SECOND) * 1000000000ULL
+		+ (Ticks % COUNTS_PER_SECOND) * 1000000000ULL / COUNTS_PER_SECOND;
+	sprintf(Buffer, "%llu.%03llu", (unsigned long long)(Nanoseconds / 1000), (unsigned long long)(Nanoseconds % 1000));
+}
+
+
+void TraceDump(void)
+{
+	char Line[160];
+	char Ts[24];
+	char Dur[24];
+	u32 Count = TraceHead < TRACE_BUFFER_ENTRIES ? TraceHead : TRACE_BUFFER_ENTRIES;
+
+	TraceSendString("{\"traceEvents\":[");
+	for (u32 i = TraceHead - Count; i != TraceHead; i++) {
+		TraceEntry *Entry = &TraceBuffer[i & (TRACE_BUFFER_ENTRIES - 1)];
+		TraceFormatMicroseconds(Ts, Entry->Start);
+		TraceFormatMicroseconds(Dur, Entry->Duration);
+		sprintf(Line, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%s,\"dur\":%s,\"args\":{\"arg\":%u}}",
+			i == TraceHead - Count ? "" : ",", TraceNames[Entry->Id], Ts, Dur, (unsigned int)Entry->Arg);
+		TraceSendString(Line);
+	}
+	TraceSendString("],\"displayTimeUnit\":\"ns\"}\r\n");
+	TraceHead = 0;
+}
+
+#endif /* ENABLE_TRACE */
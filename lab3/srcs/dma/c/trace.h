@@ -0,0 +1,59 @@
+/******************************************************************************
+* Per-phase event tracer for the DMA firmware.
+*
+* Build with -DENABLE_TRACE to record one (event id, timestamp, duration,
+* arg) entry per phase into a fixed ring buffer; without it every TRACE_*
+* macro compiles to nothing. Timestamps come from the free-running A53
+* generic timer (XTime), so they are not disturbed by the XTmrCtr resets
+* in TxSend. The buffer is dumped over the UART after the STATS line when
+* TERMINATE arrives, as one line of Chrome trace JSON
+* (chrome://tracing or https://ui.perfetto.dev).
+* The same phases are measured with the PMU when built with -DENABLE_PMU,
+* see pmu.h.
+******************************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "xil_types.h"
+#include "pmu.h"
+
+typedef enum {
+	TRACE_JOB = 0,
+	TRACE_RECEIVE_A,
+	TRACE_RECEIVE_B,
+	TRACE_LAYER,
+	TRACE_FLUSH,
+	TRACE_TX,
+	TRACE_RX,
+	TRACE_SEND_RESULTS,
+	TRACE_RESET,
+	TRACE_EVENT_COUNT
+} TraceEventId;
+
+/* Must be a power of two, the oldest entries are overwritten */
+#ifndef TRACE_BUFFER_ENTRIES
+#define TRACE_BUFFER_ENTRIES 1024
+#endif
+
+const char *TraceEventName(TraceEventId Id);
+
+#ifdef ENABLE_TRACE
+
+void TraceBegin(TraceEventId Id);
+void TraceEnd(TraceEventId Id, u32 Arg);
+void TraceDump(void);
+
+#define TRACE_BEGIN(Id)         do { TraceBegin(Id); PMU_BEGIN(Id); } while (0)
+#define TRACE_END(Id, Arg)      do { PMU_END(Id); TraceEnd((Id), (u32)(Arg)); } while (0)
+#define TRACE_DUMP()            do { TraceDump(); PMU_DUMP(); } while (0)
+
+#else
+
+#define TRACE_BEGIN(Id)         PMU_BEGIN(Id)
+#define TRACE_END(Id, Arg)      PMU_END(Id)
+#define TRACE_DUMP()            PMU_DUMP()
+
+#endif /* ENABLE_TRACE */
+
+#endif /* TRACE_H */
@@ -0,0 +1,143 @@
+/******************************************************************************
+* FIFO occupancy profiler for the AXI-Stream FIFO firmware, see fifoprof.h.
+******************************************************************************/
+
+#include "fifoprof.h"
+
+#ifdef FIFO_PROFILE
+
+#include "xparameters.h"
+#include "xtime_l.h"
+#include "xuartps.h"
+#include "stdio.h"
+#include "string.h"
+
+/* XTime ticks to cycles of the AXI timer, as in the DMA firmware */
+#define FIFO_PROFILE_CYCLES(Ticks) \
+	((u64)(Ticks) * (XPAR_TMRCTR_0_CLOCK_FREQ_HZ / 1000U) / (COUNTS_PER_SECOND / 1000U))
+
+typedef struct {
+	u32 Transfers;
+	u32 Polls;
+	u32 Words;              // polls that found room or data, one word moved each
+	u32 ZeroPolls;
+	XTime Stall;            // from a zero poll up to the next poll with room or data
+	XTime FirstWait;        // RX only, the stall before the first word
+	XTime Elapsed;
+	u32 Histogram[FIFO_PROFILE_BUCKETS];
+} FifoProfileTotal;
+
+static const char *FifoProfileNames[FIFO_PROFILE_DIR_COUNT] = {"TX", "TXDONE", "RX"};
+static FifoProfileTotal FifoProfileTotals[FIFO_PROFILE_DIR_COUNT];
+FifoProfileOpen FifoProfileCurrent[FIFO_PROFILE_DIR_COUNT];
+
+
+/* The end of a run of zero polls, counted as stalled from its first poll */
+static void FifoProfileClose(FifoProfileDir Dir, XTime Now)
+{
+	FifoProfileOpen *Open = &FifoProfileCurrent[Dir];
+	FifoProfileTotal *Total = &FifoProfileTotals[Dir];
+
+	if (!Open->Stalled) {
+		return;
+	}
+	if (Dir == FIFO_PROFILE_RX && !Open->Moved) {
+		Total->FirstWait += Now - Open->StallStart;
+	}
+	else {
+		Total->Stall += Now - Open->StallStart;
+	}
+	Open->Stalled = 0;
+}
+
+
+void FifoProfileBegin(FifoProfileDir Dir)
+{
+	FifoProfileOpen *Open = &FifoProfileCurrent[Dir];
+
+	memset(Open, 0, sizeof(*Open));
+	Open->Watch = 1;
+	XTime_GetTime(&Open->Start);
+}
+
+
+/* A zero poll, or the first poll with room or data after zero polls or the start */
+void FifoProfileEdge(FifoProfileDir Dir, u32 Value)
+{
+	FifoProfileOpen *Open = &FifoProfileCurrent[Dir];
+	XTime Now;
+
+	if (Value == 0) {
+		Open->ZeroPolls++;
+		if (!Open->Stalled) {
+			XTime_GetTime(&Open->StallStart);
+			Open->Stalled = 1;
+		}
+		Open->Watch = 1;
+		return;
+	}
+	if (Open->Stalled) {
+		XTime_GetTime(&Now);
+		FifoProfileClose(Dir, Now);
+	}
+	Open->Moved = 1;
+	Open->Watch = 0;
+}
+
+
+void FifoProfileEnd(FifoProfileDir Dir)
+{
+	FifoProfileOpen *Open = &FifoProfileCurrent[Dir];
+	FifoProfileTotal *Total = &FifoProfileTotals[Dir];
+	XTime Now;
+	u32 Polls = 0;
+
+	XTime_GetTime(&Now);
+	FifoProfileClose(Dir, Now);
+	for (int b = 0; b < FIFO_PROFILE_BUCKETS; b++) {
+		Total->Histogram[b] += Open->Histogram[b];
+		Polls += Open->Histogram[b];
+	}
+	Total->Transfers++;
+	Total->Polls += Polls;
+	Total->ZeroPolls += Open->ZeroPolls;
+	Total->Words += Dir == FIFO_PROFILE_TX_DONE ? 0 : Polls - Open->ZeroPolls;
+	Total->Elapsed += Now - Open->Start;
+}
+
+
+static void FifoProfileSendString(const char *Str)
+{
+	for (const char *p = Str; *p != '\0'; p++) {
+		XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
+	}
+}
+
+
+void FifoProfileDump(void)
+{
+	char Line[160];
+
+	for (int d = 0; d < FIFO_PROFILE_DIR_COUNT; d++) {
+		FifoProfileTotal *Total = &FifoProfileTotals[d];
+		if (Total->Transfers == 0) {
+			continue;
+		}
+		sprintf(Line, "FIFOPROF:DIR=%s,TRANSFERS=%u,POLLS=%u,WORDS=%u,ZEROPOLLS=%u,STALL=%llu,FIRSTWAIT=%llu,CYCLES=%llu,HIST=",
+			FifoProfileNames[d], (unsigned int)Total->Transfers, (unsigned int)Total->Polls,
+			(unsigned int)Total->Words, (unsigned int)Total->ZeroPolls,
+			(unsigned long long)FIFO_PROFILE_CYCLES(Total->Stall),
+			(unsigned long long)FIFO_PROFILE_CYCLES(Total->FirstWait),
+			(unsigned long long)FIFO_PROFILE_CYCLES(Total->Elapsed));
+		FifoProfileSendString(Line);
+		for (int b = 0; b < FIFO_PROFILE_BUCKETS; b++) {
+			sprintf(Line, b == 0 ? "%u" : "/%u", (unsigned int)Total->Histogram[b]);
+			FifoProfileSendString(Line);
+		}
+		FifoProfileSendString("\r\n");
+	}
+
+	memset(FifoProfileTotals, 0, sizeof(FifoProfileTotals));
+}
+
+#endif /* FIFO_PROFILE */
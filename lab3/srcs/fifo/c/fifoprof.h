@@ -0,0 +1,104 @@
+/******************************************************************************
+* FIFO occupancy profiler for the AXI-Stream FIFO firmware.
+*
+* Build with -DFIFO_PROFILE to keep the values TxSend and RxReceive already
+* poll, no register access is added, so the register traffic of a job is
+* unchanged:
+*   TX      XLlFifo_iTxVacancy before every word put, 0 is a full poll
+*   TXDONE  XLlFifo_IsTxDone after the length is written, the packet leaving
+*           the FIFO for the IP
+*   RX      XLlFifo_iRxOccupancy before every word taken, 0 is an empty poll
+* The time from a zero poll to the next poll is counted as stalled. For RX the
+* stall before the first result (the IP still computing) is kept apart from
+* the stalls after it. Totals over all jobs are sent after the STATS line when
+* TERMINATE arrives, one line per direction:
+*   FIFOPROF:DIR=TX,TRANSFERS=..,POLLS=..,WORDS=..,ZEROPOLLS=..,STALL=..,FIRSTWAIT=..,CYCLES=..,HIST=../..
+* STALL, FIRSTWAIT and CYCLES are cycles of the AXI timer, HIST counts the
+* polls per FIFO_PROFILE_BUCKETS equal slices of 0 .. FIFO_PROFILE_DEPTH words.
+*
+* Reading it: TX CYCLES / WORDS near two register accesses with no zero polls
+* means the per-word register access is the limit, zero TX polls mean the FIFO
+* is too shallow for the packet (and the words polled full are not sent). An
+* RX histogram at the low end with STALL high after FIRSTWAIT means the IP
+* produces slower than the CPU drains, one at the high end that the CPU is
+* the limit. TXDONE CYCLES is the time the IP takes the packet at.
+*
+* Overhead: a poll costs an inline histogram increment and a test of the value,
+* the counts are folded into the totals once per transfer. XTime is only read
+* (a system register read on the A53) at the start and end of a transfer and
+* on the first zero poll of a run of them and the poll that ends it. On the
+* board the TX, RX and TOTAL cycles of a -DFIFO_PROFILE build still include
+* this work, a few cycles per poll, so take the STATS line of a build without
+* the flag for the timings and this one for where the time goes.
+* Without the flag every FIFO_PROFILE_* macro compiles to nothing.
+******************************************************************************/
+
+#ifndef FIFOPROF_H
+#define FIFOPROF_H
+
+#include "xil_types.h"
+
+typedef enum {
+	FIFO_PROFILE_TX = 0,
+	FIFO_PROFILE_TX_DONE,
+	FIFO_PROFILE_RX,
+	FIFO_PROFILE_DIR_COUNT
+} FifoProfileDir;
+
+/* C_TX_FIFO_DEPTH / C_RX_FIFO_DEPTH in lab3_fifo.xsa, in words */
+#ifndef FIFO_PROFILE_DEPTH
+#define FIFO_PROFILE_DEPTH      1024
+#endif
+#ifndef FIFO_PROFILE_BUCKETS
+#define FIFO_PROFILE_BUCKETS    8
+#endif
+
+#ifdef FIFO_PROFILE
+
+#include "xtime_l.h"
+
+/* The transfer being polled, folded into the totals by FifoProfileEnd */
+typedef struct {
+	XTime Start;
+	XTime StallStart;       // first zero poll of the current run
+	u32 ZeroPolls;
+	u32 Watch;              // a zero poll, or none with data yet: FifoProfileEdge sees the next poll
+	u32 Stalled;            // in a run of zero polls
+	u32 Moved;              // a poll found room or data
+	u32 Histogram[FIFO_PROFILE_BUCKETS];
+} FifoProfileOpen;
+
+extern FifoProfileOpen FifoProfileCurrent[FIFO_PROFILE_DIR_COUNT];
+
+void FifoProfileBegin(FifoProfileDir Dir);
+void FifoProfileEdge(FifoProfileDir Dir, u32 Value);
+void FifoProfileEnd(FifoProfileDir Dir);
+void FifoProfileDump(void);
+
+/* Every poll, kept inline: the histogram, and the stall bookkeeping only around zero polls */
+static inline void FifoProfileSample(FifoProfileDir Dir, u32 Value)
+{
+	FifoProfileOpen *Open = &FifoProfileCurrent[Dir];
+	u32 Bucket = Value * FIFO_PROFILE_BUCKETS / FIFO_PROFILE_DEPTH;
+
+	Open->Histogram[Bucket < FIFO_PROFILE_BUCKETS ? Bucket : FIFO_PROFILE_BUCKETS - 1]++;
+	if (Value == 0 || Open->Watch) {
+		FifoProfileEdge(Dir, Value);
+	}
+}
+
+#define FIFO_PROFILE_BEGIN(Dir)         FifoProfileBegin(Dir)
+#define FIFO_PROFILE_SAMPLE(Dir, Value) FifoProfileSample(Dir, Value)
+#define FIFO_PROFILE_END(Dir)           FifoProfileEnd(Dir)
+#define FIFO_PROFILE_DUMP()             FifoProfileDump()
+
+#else
+
+#define FIFO_PROFILE_BEGIN(Dir)         do {} while (0)
+#define FIFO_PROFILE_SAMPLE(Dir, Value) do {} while (0)
+#define FIFO_PROFILE_END(Dir)           do {} while (0)
+#define FIFO_PROFILE_DUMP()             do {} while (0)
+
+#endif /* FIFO_PROFILE */
+
+#endif /* FIFOPROF_H */
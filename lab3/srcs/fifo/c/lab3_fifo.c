@@ -9,17 +9,16 @@
 XLlFifo FifoInstance;
 XTmrCtr TmrCtrInstance;
 
-u32 MatrixA[MatrixA_Size];
-u32 MatrixB[MatrixB_Size];
-u32 SourceBuffer[FIFO_TX_ELEMENTS];
-u32 DestinationBuffer[FIFO_RX_ELEMENTS];
+/* A then B, the order myip_v1_0 reads them, so both are parsed into place */
+u32 SourceBuffer[FIFO_TX_ELEMENTS] OCM_DATA;
+u32 DestinationBuffer[FIFO_RX_ELEMENTS] OCM_DATA;
 
 char TERMINATE_TOKEN[] = "TERMINATE";
 
 int main()
 {
 	int Status = XST_SUCCESS;
-	Stats stats = {0, 0, 0, 0};
+	Stats stats = {0};
 
 #ifndef SDT
 	Status = InitFifo(&FifoInstance, FIFO_DEV_ID);
@@ -31,6 +30,8 @@ int main()
 		return XST_FAILURE;
 	}
 
+	IP_COUNTERS_INIT(1);
+
 #ifndef SDT
 	Status = InitTmrCtr(&TmrCtrInstance, TMRCTR_DEVICE_ID, TIMER_COUNTER_0);
 #else
@@ -59,22 +60,20 @@ int RunMatrixAssignment(XLlFifo *FifoInstancePtr, XTmrCtr *TmrCtrInstancePtr, u8
 	int Status;
 
 	xil_printf("Ready! Please use RealTerm -> 'Send File' to send A.csv\r\n");
-    Status = ReceiveCSVData(MatrixA, MatrixA_Size, stats);
+    Status = ReceiveCSVData(SourceBuffer, MatrixA_Size, stats);
     if (Status != XST_SUCCESS) {
         xil_printf("Failed to receive Matrix A\r\n");
         return XST_FAILURE;
     }
 
     xil_printf("Matrix A Received. Now please send B.csv\r\n");
-    Status = ReceiveCSVData(MatrixB, MatrixB_Size, stats);
+    Status = ReceiveCSVData(SourceBuffer + MatrixA_Size, MatrixB_Size, stats);
     if (Status != XST_SUCCESS) {
         xil_printf("Failed to receive Matrix B\r\n");
         return XST_FAILURE;
     }
 
 	xil_printf("All data received successfully!\r\n");
-	xil_printf("Merging data into SourceBuffer...\r\n");
-	MergeArrays(SourceBuffer, MatrixA, MatrixA_Size, MatrixB, MatrixB_Size);
 
 	Status = TxSend(FifoInstancePtr, SourceBuffer, FIFO_TX_ELEMENTS, TmrCtrInstancePtr, TmrCtrNumber, stats);
 	if (Status != XST_SUCCESS){
@@ -96,7 +95,7 @@ int RunMatrixAssignment(XLlFifo *FifoInstancePtr, XTmrCtr *TmrCtrInstancePtr, u8
 }
 
 
-int TxSend(XLlFifo *FifoInstancePtr, u32  *SourceAddr, int Words, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
+OCM_TEXT int TxSend(XLlFifo *FifoInstancePtr, u32  *SourceAddr, int Words, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
 {
 	int i;
 	// Print before starting the timer to avoid affecting timing results, but still provide feedback to user
@@ -105,17 +104,23 @@ int TxSend(XLlFifo *FifoInstancePtr, u32  *SourceAddr, int Words, XTmrCtr *TmrCt
 	XTmrCtr_Reset(TmrCtrInstancePtr, TmrCtrNumber);
 	XTmrCtr_Start(TmrCtrInstancePtr, TmrCtrNumber);
 
+	FIFO_PROFILE_BEGIN(FIFO_PROFILE_TX);
 	for (i=0 ; i < Words ; i++){
-		if( XLlFifo_iTxVacancy(FifoInstancePtr) ){
+		u32 Vacancy = XLlFifo_iTxVacancy(FifoInstancePtr);
+		FIFO_PROFILE_SAMPLE(FIFO_PROFILE_TX, Vacancy);
+		if( Vacancy ){
 			XLlFifo_TxPutWord(FifoInstancePtr, SourceAddr[i]);
 		}
 	}
+	FIFO_PROFILE_END(FIFO_PROFILE_TX);
 
 	XLlFifo_iTxSetLen(FifoInstancePtr, (Words * WORD_SIZE));
 
+	FIFO_PROFILE_BEGIN(FIFO_PROFILE_TX_DONE);
 	while( !(XLlFifo_IsTxDone(FifoInstancePtr)) ){
-
+		FIFO_PROFILE_SAMPLE(FIFO_PROFILE_TX_DONE, 0);
 	}
+	FIFO_PROFILE_END(FIFO_PROFILE_TX_DONE);
 
 	u32 TxElapsed = XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
 	// Do not stop the timer, we want to measure how long the MM takes as well.
@@ -126,7 +131,7 @@ int TxSend(XLlFifo *FifoInstancePtr, u32  *SourceAddr, int Words, XTmrCtr *TmrCt
 }
 
 
-int RxReceive (XLlFifo *FifoInstancePtr, u32* DestinationAddr, int Words, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
+OCM_TEXT int RxReceive (XLlFifo *FifoInstancePtr, u32* DestinationAddr, int Words, XTmrCtr *TmrCtrInstancePtr, u8 TmrCtrNumber, Stats *stats)
 {
 	int Status;
 	u32 RxWord;
@@ -134,14 +139,22 @@ int RxReceive (XLlFifo *FifoInstancePtr, u32* DestinationAddr, int Words, XTmrCt
 
 	u32 MatMulElapsed = 0;
 
+	FIFO_PROFILE_BEGIN(FIFO_PROFILE_RX);
 	while (count < Words) {
-		if(XLlFifo_iRxOccupancy(FifoInstancePtr)) {
-			MatMulElapsed = XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
+		u32 Occupancy = XLlFifo_iRxOccupancy(FifoInstancePtr);
+		FIFO_PROFILE_SAMPLE(FIFO_PROFILE_RX, Occupancy);
+		if(Occupancy) {
+			// The IP streams each result as soon as it is computed, so MatMul is the time to the
+			// first result and Rx covers the rest of the compute overlapped with the transfer
+			if (count == 0) {
+				MatMulElapsed = XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
+			}
 			RxWord = XLlFifo_RxGetWord(FifoInstancePtr);
 			DestinationAddr[count] = RxWord;
 			count++;
 		}
 	}
+	FIFO_PROFILE_END(FIFO_PROFILE_RX);
 
 	u32 TotalElapsed = XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
 	XTmrCtr_Stop(TmrCtrInstancePtr, TmrCtrNumber);
@@ -167,7 +180,7 @@ int RxReceive (XLlFifo *FifoInstancePtr, u32* DestinationAddr, int Words, XTmrCt
 }
 
 
-int ReceiveCSVData(u32 *Buffer, int TotalElements, Stats *stats)
+OCM_TEXT int ReceiveCSVData(u32 *Buffer, int TotalElements, Stats *stats)
 {
     char msg[20];
     int msg_idx = 0;
@@ -190,6 +203,7 @@ int ReceiveCSVData(u32 *Buffer, int TotalElements, Stats *stats)
 				if (strcmp(msg, TERMINATE_TOKEN) == 0) {
 					xil_printf("Termination command received. Stopping reception.\r\n");
 					SendStats(stats);
+					FIFO_PROFILE_DUMP();
 					return XST_FAILURE;
 				}
                 Buffer[count] = atoi(msg);
@@ -222,17 +236,6 @@ int ReceiveCSVData(u32 *Buffer, int TotalElements, Stats *stats)
 }
 
 
-void MergeArrays(u32 *dest, u32 *A, int sizeA, u32 *B, int sizeB)
-{
-    for (int i = 0; i < sizeA; i++) {
-        dest[i] = A[i];
-    }
-    for (int i = 0; i < sizeB; i++) {
-        dest[sizeA + i] = B[i];
-    }
-}
-
-
 void SendStats(Stats *stats)
 {
 	char buf[12];
@@ -245,6 +248,16 @@ void SendStats(Stats *stats)
 		for (char *p = buf; *p != '\0'; p++)
 			XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
 	}
+#ifdef ENABLE_IP_COUNTERS
+	IP_COUNTERS_READ(1, stats->IpCounters);
+	for (int i = 0; i < IP_COUNTER_COUNT; i++) {
+		for (const char *p = IpCounterLabel((IpCounterId)i); *p != '\0'; p++)
+			XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
+		sprintf(buf, "%u", (unsigned int)stats->IpCounters[i]);
+		for (char *p = buf; *p != '\0'; p++)
+			XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, *p);
+	}
+#endif
 	XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, '\r');
 	XUartPs_SendByte(XPAR_XUARTPS_0_BASEADDR, '\n');
 }
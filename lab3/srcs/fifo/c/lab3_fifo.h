@@ -18,6 +18,8 @@
 #include "xuartps.h"
 #include "stdio.h"
 #include "stdbool.h"
+#include "fifoprof.h"
+#include "ipcounters.h"    // lab3/srcs/dma/c
 
 #ifdef XPAR_UARTNS550_0_BASEADDR
 #include "xuartns550_l.h"
@@ -42,23 +44,56 @@
 #define TIMER_COUNTER_0     0
 #define WORD_SIZE           4
 
-/* ----- Matrix dimensions ----- */
+/* ----- Matrix dimensions (must match m, n and p of the IP, overridable with -D) ----- */
+/* MATRIX_B_COLS > 1 needs myip_systolic_v1_0 with p = MATRIX_B_COLS. B is then
+   received row-major, n rows of p values, and the results are sent as m rows of p */
+#ifndef MATRIX_A_ROWS
 #define MATRIX_A_ROWS 64
+#endif
+#ifndef MATRIX_A_COLS
 #define MATRIX_A_COLS 8
-#define MATRIX_B_ROWS 8
+#endif
+#define MATRIX_B_ROWS MATRIX_A_COLS
+#ifndef MATRIX_B_COLS
 #define MATRIX_B_COLS 1
+#endif
 
 #define MatrixA_Size    (MATRIX_A_COLS * MATRIX_A_ROWS)
 #define MatrixB_Size    (MATRIX_B_COLS * MATRIX_B_ROWS)
 #define FIFO_TX_ELEMENTS    (MatrixA_Size + MatrixB_Size)
 #define FIFO_RX_ELEMENTS    (MATRIX_A_ROWS * MATRIX_B_COLS)
 
+/* ----- Accelerator counters (lab1/srcs/perf_counters.sv) ----- */
+/* Build with -DENABLE_IP_COUNTERS to clear them at start up and append them to the
+   STATS line, through the helper of the DMA firmware (lab3/srcs/dma/c/ipcounters.h,
+   add that folder to the include paths and ipcounters.c to the sources): JOBS,
+   READ_A, READ_B, COMPUTE, WRITE_OUTPUTS, IN_STALLS and OUT_STALLS, in PL cycles.
+   COMPUTE + WRITE_OUTPUTS is the time MATMUL only estimates from the first RX word */
+#if defined(ENABLE_IP_COUNTERS) && MATRIX_B_COLS > 1
+#error "ENABLE_IP_COUNTERS needs myip_v1_0, myip_systolic_v1_0 has no counter bank"
+#endif
+
+/* ----- Memory placement (opt-in with -DOCM_BUFFERS and -DOCM_CODE) ----- */
+/* As in the DMA firmware: OCM_DATA buffers go to .ocm_data and OCM_TEXT
+   functions to .ocm_text, placed in the OCM by lab3/srcs/lscript_ocm.ld */
+#ifdef OCM_BUFFERS
+#define OCM_DATA    __attribute__((section(".ocm_data")))
+#else
+#define OCM_DATA
+#endif
+#ifdef OCM_CODE
+#define OCM_TEXT    __attribute__((section(".ocm_text"), noinline))
+#else
+#define OCM_TEXT
+#endif
+
 /* ----- Timing stats struct ----- */
 typedef struct {
     u32 TxElapsed;
     u32 RxElapsed;
     u32 MatMulElapsed;
     u32 TotalElapsed;
+    u32 IpCounters[IP_COUNTER_COUNT];   // read at TERMINATE
 } Stats;
 
 /* ----- Function declarations ----- */
@@ -86,6 +121,4 @@ int ReceiveCSVData(u32 *Buffer, int TotalElements, Stats *stats);
 void SendCSVResults(u32 *data, int rows, int cols);
 void SendStats(Stats *stats);
 
-void MergeArrays(u32 *dest, u32 *A, int sizeA, u32 *B, int sizeB);
-
 #endif /* LAB3_FIFO_H */
@@ -0,0 +1,60 @@
+/******************************************************************************
+* Pin-level interface between the co-simulation shim and an accelerator
+* model with the myip_v1_0 AXI-Stream ports.
+******************************************************************************/
+
+#ifndef AXIS_MODEL_H
+#define AXIS_MODEL_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+/* TDATA of myip_v1_0 built with lanes = AXIS_LANES (lab3_dma.h), in 32-bit
+ * words, least significant first: 32 bits for 1 lane, 8 bits per lane else */
+#ifndef AXIS_LANES
+#define AXIS_LANES 1
+#endif
+#define AXIS_DATA_WORDS ((AXIS_LANES) == 1 ? 1 : (AXIS_LANES) / 4)
+
+typedef std::array<uint32_t, AXIS_DATA_WORDS> AxisData;
+
+/* Inputs are driven by the shim before Tick(), outputs are the registered
+ * values after the last rising edge of ACLK. */
+struct AxisPins {
+	// shim -> model
+	AxisData SAxisTdata;
+	bool     SAxisTvalid;
+	bool     SAxisTlast;
+	bool     MAxisTready;
+	// model -> shim
+	bool     SAxisTready;
+	AxisData MAxisTdata;
+	bool     MAxisTvalid;
+	bool     MAxisTlast;
+};
+
+class AxisModel {
+public:
+	virtual ~AxisModel() {}
+	virtual const char *Name() const = 0;
+	// Hold ARESETN low for a few cycles and release it
+	virtual void Reset(AxisPins &Pins) = 0;
+	// One rising edge of ACLK
+	virtual void Tick(AxisPins &Pins) = 0;
+	// S_AXI register bank (perf_counters.sv), accessed between two edges of
+	// ACLK. Models without one read 0 and ignore writes
+	virtual uint32_t ReadRegister(uint32_t Offset) { (void)Offset; return 0; }
+	virtual void WriteRegister(uint32_t Offset, uint32_t Value) { (void)Offset; (void)Value; }
+};
+
+/* Provided by the linked backend (myip_verilated.cpp or myip_emulated.cpp) */
+std::unique_ptr<AxisModel> CreateAxisModel();
+
+/* S_AXIS looped back to M_AXIS through a small FIFO, as in lab2 */
+std::unique_ptr<AxisModel> CreateLoopbackModel();
+
+/* axis_loopback.sv, the traffic source, sink and loopback of DMA_BENCH */
+std::unique_ptr<AxisModel> CreateTrafficModel();
+
+#endif /* AXIS_MODEL_H */
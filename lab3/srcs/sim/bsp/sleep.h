@@ -0,0 +1,25 @@
+/******************************************************************************
+* Host stand-in for the standalone BSP sleep.h. Sleeping advances simulated
+* time instead of wall-clock time.
+******************************************************************************/
+
+#ifndef SLEEP_H
+#define SLEEP_H
+
+#include "xil_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void SimSleepMicroseconds(u64 useconds);
+
+/* Mapped to a differently named symbol so that the C library's usleep() is left alone */
+#define usleep(us)  (SimSleepMicroseconds((u64)(us)), 0)
+#define sleep(s)    (SimSleepMicroseconds((u64)(s) * 1000000U), 0U)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLEEP_H */
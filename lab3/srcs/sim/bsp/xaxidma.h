@@ -0,0 +1,71 @@
+/******************************************************************************
+* Host stand-in for the AXI DMA driver (simple mode only), backed by the
+* simulated myip_v1_0. Transfers read and write host memory directly.
+******************************************************************************/
+
+#ifndef XAXIDMA_H
+#define XAXIDMA_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XAXIDMA_DMA_TO_DEVICE   0x00
+#define XAXIDMA_DEVICE_TO_DMA   0x01
+
+#define XAXIDMA_IRQ_IOC_MASK    0x00001000U
+#define XAXIDMA_IRQ_DELAY_MASK  0x00002000U
+#define XAXIDMA_IRQ_ERROR_MASK  0x00004000U
+#define XAXIDMA_IRQ_ALL_MASK    0x00007000U
+
+/* Channel register blocks and the status register (DMASR) */
+#define XAXIDMA_TX_OFFSET       0x00000000U
+#define XAXIDMA_RX_OFFSET       0x00000030U
+#define XAXIDMA_SR_OFFSET       0x00000004U
+
+#define XAXIDMA_HALTED_MASK     0x00000001U
+#define XAXIDMA_IDLE_MASK       0x00000002U
+#define XAXIDMA_ERR_INTERNAL_MASK   0x00000010U
+#define XAXIDMA_ERR_SLAVE_MASK  0x00000020U
+#define XAXIDMA_ERR_DECODE_MASK 0x00000040U
+#define XAXIDMA_ERR_ALL_MASK    0x00000770U
+
+typedef struct {
+	u32 DeviceId;
+	UINTPTR BaseAddr;
+	int HasStsCntrlStrm;
+	int HasMm2S;
+	int HasS2Mm;
+	int HasSg;
+	int Mm2SDataWidth;
+	int S2MmDataWidth;
+} XAxiDma_Config;
+
+typedef struct {
+	UINTPTR RegBase;
+	int HasMm2S;
+	int HasS2Mm;
+	int HasSg;
+	u32 IsReady;
+} XAxiDma;
+
+XAxiDma_Config *XAxiDma_LookupConfig(u32 DeviceId);
+int XAxiDma_CfgInitialize(XAxiDma *InstancePtr, XAxiDma_Config *Config);
+int XAxiDma_Selftest(XAxiDma *InstancePtr);
+void XAxiDma_IntrDisable(XAxiDma *InstancePtr, u32 Mask, int Direction);
+int XAxiDma_SimpleTransfer(XAxiDma *InstancePtr, UINTPTR BuffAddr, u32 Length, int Direction);
+int XAxiDma_Busy(XAxiDma *InstancePtr, int Direction);
+void XAxiDma_Reset(XAxiDma *InstancePtr);
+int XAxiDma_ResetIsDone(XAxiDma *InstancePtr);
+u32 XAxiDma_ReadReg(UINTPTR BaseAddress, u32 RegOffset);
+
+#define XAxiDma_HasSg(InstancePtr)  ((InstancePtr)->HasSg) ? TRUE : FALSE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XAXIDMA_H */
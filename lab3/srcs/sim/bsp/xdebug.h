@@ -0,0 +1,10 @@
+/******************************************************************************
+* Host stand-in for the standalone BSP xdebug.h.
+******************************************************************************/
+
+#ifndef XDEBUG_H
+#define XDEBUG_H
+
+#include "xil_types.h"
+
+#endif /* XDEBUG_H */
@@ -0,0 +1,16 @@
+/******************************************************************************
+* Host stand-in for the standalone BSP xil_cache.h. The simulated DMA reads
+* and writes host memory directly, so cache maintenance is a no-op.
+******************************************************************************/
+
+#ifndef XIL_CACHE_H
+#define XIL_CACHE_H
+
+#include "xil_types.h"
+
+static inline void Xil_DCacheFlushRange(UINTPTR adr, u32 len) { (void)adr; (void)len; }
+static inline void Xil_DCacheInvalidateRange(UINTPTR adr, u32 len) { (void)adr; (void)len; }
+static inline void Xil_DCacheFlush(void) {}
+static inline void Xil_DCacheInvalidate(void) {}
+
+#endif /* XIL_CACHE_H */
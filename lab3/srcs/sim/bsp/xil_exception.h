@@ -0,0 +1,11 @@
+/******************************************************************************
+* Host stand-in for the standalone BSP xil_exception.h. Interrupts are not
+* modelled, the firmware only uses polling.
+******************************************************************************/
+
+#ifndef XIL_EXCEPTION_H
+#define XIL_EXCEPTION_H
+
+#include "xil_types.h"
+
+#endif /* XIL_EXCEPTION_H */
@@ -0,0 +1,24 @@
+/******************************************************************************
+* Host stand-in for the standalone BSP xil_io.h. Only the S_AXI register
+* banks of the accelerators (XPAR_MYIP_<i>_S_AXI_BASEADDR) are mapped, any
+* other address reads 0 and ignores writes. Every access costs a PS register
+* access, see sim_platform.h.
+******************************************************************************/
+
+#ifndef XIL_IO_H
+#define XIL_IO_H
+
+#include "xil_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+u32 Xil_In32(UINTPTR Addr);
+void Xil_Out32(UINTPTR Addr, u32 Value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XIL_IO_H */
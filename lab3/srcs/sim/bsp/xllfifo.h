@@ -0,0 +1,55 @@
+/******************************************************************************
+* Host stand-in for the AXI-Stream FIFO driver, backed by the simulated
+* myip_v1_0. The TX side is store-and-forward like the real core: words are
+* only streamed out once the length register has been written.
+******************************************************************************/
+
+#ifndef XLLFIFO_H
+#define XLLFIFO_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XLLF_INT_RC_MASK    0x04000000U  /* Receive complete */
+#define XLLF_INT_TC_MASK    0x08000000U  /* Transmit complete */
+#define XLLF_INT_ERROR_MASK 0xF2000000U  /* Over/underruns and TX size error, never raised here */
+#define XLLF_INT_ALL_MASK   0xFFF80000U
+
+typedef struct {
+	u16 DeviceId;
+	UINTPTR BaseAddress;
+	u32 Datainterface;
+} XLlFifo_Config;
+
+typedef struct {
+	UINTPTR BaseAddress;
+	u32 IsReady;
+	u32 Datainterface;
+} XLlFifo;
+
+XLlFifo_Config *XLlFfio_LookupConfig(u32 DeviceId);
+int XLlFifo_CfgInitialize(XLlFifo *InstancePtr, XLlFifo_Config *Config, UINTPTR EffectiveAddress);
+
+u32 XLlFifo_Status(XLlFifo *InstancePtr);
+void XLlFifo_IntClear(XLlFifo *InstancePtr, u32 Mask);
+
+u32 XLlFifo_iTxVacancy(XLlFifo *InstancePtr);
+void XLlFifo_TxPutWord(XLlFifo *InstancePtr, u32 Word);
+void XLlFifo_iTxSetLen(XLlFifo *InstancePtr, u32 Bytes);
+u32 XLlFifo_iRxOccupancy(XLlFifo *InstancePtr);
+u32 XLlFifo_RxGetWord(XLlFifo *InstancePtr);
+
+#define XLlFifo_IsTxDone(InstancePtr) \
+	((XLlFifo_Status(InstancePtr) & XLLF_INT_TC_MASK) ? TRUE : FALSE)
+#define XLlFifo_IsRxDone(InstancePtr) \
+	((XLlFifo_Status(InstancePtr) & XLLF_INT_RC_MASK) ? TRUE : FALSE)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XLLFIFO_H */
@@ -0,0 +1,33 @@
+/******************************************************************************
+* Host stand-in for the generated xparameters.h of the lab3 KV260 designs.
+* Device IDs are kept so that the non-SDT code paths of the firmware build.
+******************************************************************************/
+
+#ifndef XPARAMETERS_H
+#define XPARAMETERS_H
+
+#define XPAR_PSU_DDR_0_S_AXI_BASEADDR   0x00000000U
+
+#define XPAR_AXI_FIFO_0_DEVICE_ID       0U
+#define XPAR_AXIDMA_0_DEVICE_ID         0U
+#define XPAR_TMRCTR_0_DEVICE_ID         0U
+
+/* DMA/IP pairs, device IDs 0 .. N-1 (overridable with -D to model more) */
+#ifndef XPAR_XAXIDMA_NUM_INSTANCES
+#define XPAR_XAXIDMA_NUM_INSTANCES      1
+#endif
+
+#define XPAR_XUARTPS_0_BASEADDR         0xFF000000U
+
+/* S_AXI (perf_counters) of myip_0 .. myip_3, 64 KB apart */
+#define XPAR_MYIP_0_S_AXI_BASEADDR      0x80100000U
+#define XPAR_MYIP_1_S_AXI_BASEADDR      0x80110000U
+#define XPAR_MYIP_2_S_AXI_BASEADDR      0x80120000U
+#define XPAR_MYIP_3_S_AXI_BASEADDR      0x80130000U
+#define SIM_MYIP_S_AXI_STRIDE           0x10000U
+#define SIM_MYIP_S_AXI_INSTANCES        4
+
+/* AXI timer and myip share the 100 MHz PL clock */
+#define XPAR_TMRCTR_0_CLOCK_FREQ_HZ     99999001U
+
+#endif /* XPARAMETERS_H */
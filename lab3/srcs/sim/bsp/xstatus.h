@@ -0,0 +1,17 @@
+/******************************************************************************
+* Host stand-in for the standalone BSP xstatus.h.
+******************************************************************************/
+
+#ifndef XSTATUS_H
+#define XSTATUS_H
+
+#include "xil_types.h"
+
+#define XST_SUCCESS     0L
+#define XST_FAILURE     1L
+#define XST_RESET_ERROR 8L
+#define XST_DMA_ERROR   9L
+#define XST_INVALID_PARAM   15L
+#define XST_DEVICE_BUSY 21L
+
+#endif /* XSTATUS_H */
@@ -0,0 +1,10 @@
+/******************************************************************************
+* Host stand-in for the standalone BSP xstreamer.h.
+******************************************************************************/
+
+#ifndef XSTREAMER_H
+#define XSTREAMER_H
+
+#include "xil_types.h"
+
+#endif /* XSTREAMER_H */
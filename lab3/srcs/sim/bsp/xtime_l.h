@@ -0,0 +1,25 @@
+/******************************************************************************
+* Host stand-in for the standalone BSP xtime_l.h. The global timer runs on
+* simulated PL cycles.
+******************************************************************************/
+
+#ifndef XTIME_L_H
+#define XTIME_L_H
+
+#include "xil_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef u64 XTime;
+
+#define COUNTS_PER_SECOND   100000000U
+
+void XTime_GetTime(XTime *Xtime_Global);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XTIME_L_H */
@@ -0,0 +1,39 @@
+/******************************************************************************
+* Host stand-in for the AXI timer driver. The counter runs on simulated PL
+* clock cycles, so elapsed values are directly comparable to the board.
+******************************************************************************/
+
+#ifndef XTMRCTR_H
+#define XTMRCTR_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XTC_DEVICE_TIMER_COUNT  2
+
+typedef struct {
+	u32 IsReady;
+	u32 IsRunning[XTC_DEVICE_TIMER_COUNT];
+	u64 StartCycle[XTC_DEVICE_TIMER_COUNT];
+	u32 Value[XTC_DEVICE_TIMER_COUNT];
+	u32 ResetValue[XTC_DEVICE_TIMER_COUNT];
+} XTmrCtr;
+
+int XTmrCtr_Initialize(XTmrCtr *InstancePtr, u16 DeviceId);
+int XTmrCtr_SelfTest(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+void XTmrCtr_SetOptions(XTmrCtr *InstancePtr, u8 TmrCtrNumber, u32 Options);
+void XTmrCtr_SetResetValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber, u32 ResetValue);
+void XTmrCtr_Reset(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+void XTmrCtr_Start(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+void XTmrCtr_Stop(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+u32 XTmrCtr_GetValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XTMRCTR_H */
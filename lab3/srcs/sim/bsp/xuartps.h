@@ -0,0 +1,23 @@
+/******************************************************************************
+* Host stand-in for the standalone BSP xuartps.h. The UART is mapped to
+* stdin/stdout, so a RealTerm session can be replayed with
+*   cat A.csv B.csv TERMINATE_TOKEN.txt | ./lab3_dma_sim
+******************************************************************************/
+
+#ifndef XUARTPS_H
+#define XUARTPS_H
+
+#include "xil_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+u8 XUartPs_RecvByte(UINTPTR BaseAddress);
+void XUartPs_SendByte(UINTPTR BaseAddress, u8 Data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XUARTPS_H */
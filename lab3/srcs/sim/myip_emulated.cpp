@@ -0,0 +1,508 @@
+/******************************************************************************
+* Host-emulated backend of the co-simulation shim, for hosts without
+* Verilator. A transaction-level model of myip_v1_0 with the handshake
+* timing read off the RTL. It has only been compared with the RTL on a
+* stand-in simulator (see myip_verilated.cpp), not on Verilator or the board,
+* so its cycle counts are those of the model, not of the IP:
+*   - S_AXIS_TREADY rises one cycle after S_AXIS_TVALID, then 1 beat/cycle
+*   - RES[i] can leave the IP (MATRIX_A_COLS + 10) + i * (MATRIX_A_COLS + 4)
+*     cycles after the last input beat, with M_AXIS_TREADY back-pressure
+*   - RES_RAM is read as in the RTL: a beat once its rows are written, not in
+*     a cycle a row is written, and only with room in TDATA or the skid register
+* m and n are taken from MATRIX_A_ROWS / MATRIX_A_COLS like the firmware,
+* with the rows split into NUM_SHARDS shards (default one per DMA/IP pair).
+* With -DSPARSE_A it models sparse = 1: B, then the packed non-zeros of A
+* until m rows have ended (sparse.h), and a row of e words takes e + 5 cycles.
+* With -DSTREAM_ROWS it models myip_stream_v1_0 instead (stream.h): B, then
+* rows through the MAC at one word per cycle and one idle cycle per row, each
+* result 4 cycles after the last word of its row, at most STREAM_RES_DEPTH
+* results held. With -DAXIS_LANES it models lanes = AXIS_LANES: every beat
+* carries that many elements and results, B is padded to whole beats and a
+* beat of results leaves once its last row is done. With MATRIX_B_COLS > 1
+* (or -DSYSTOLIC_ROWS) it models myip_systolic_v1_0 with p = MATRIX_B_COLS
+* and grid_rows = SYSTOLIC_ROWS (default 4), cycle by cycle: a tile of rows
+* takes n + grid_rows + p + 1 cycles and its results go out while the next
+* tile runs.
+* myip_v1_0 also has the counters of perf_counters.sv on ReadRegister,
+* counted from the modelled states (COMPUTE ends two cycles before the last
+* result can leave, when matrix_multiply raises Done).
+*
+* Build as in myip_verilated.cpp without Verilator, e.g.
+*   g++ -O2 -Ilab3/srcs/sim/bsp -Ilab3/srcs/sim -x c++ lab3/srcs/dma/c/lab3_dma.c lab3/srcs/dma/c/trace.c lab3/srcs/dma/c/hybrid.c -x none \
+*     lab3/srcs/sim/sim_platform.cpp lab3/srcs/sim/sim_fifo.cpp lab3/srcs/sim/sim_dma.cpp \
+*     lab3/srcs/sim/myip_emulated.cpp -o lab3_dma_sim
+******************************************************************************/
+
+#include "axis_model.h"
+
+#include <deque>
+#include <vector>
+
+#include "xparameters.h"
+
+#ifndef MATRIX_A_ROWS
+#define MATRIX_A_ROWS 64
+#endif
+#ifndef MATRIX_A_COLS
+#define MATRIX_A_COLS 8
+#endif
+
+#ifndef MATRIX_B_COLS
+#define MATRIX_B_COLS 1
+#endif
+
+#ifndef NUM_SHARDS
+#define NUM_SHARDS XPAR_XAXIDMA_NUM_INSTANCES
+#endif
+
+#ifdef SYSTOLIC_ROWS
+#define MYIP_SYSTOLIC       1
+#else
+#define SYSTOLIC_ROWS       4
+#define MYIP_SYSTOLIC       (MATRIX_B_COLS > 1)
+#endif
+
+#define MYIP_ROWS           (MATRIX_A_ROWS / NUM_SHARDS)
+#define MYIP_B_ELEMENTS     ((MATRIX_A_COLS + AXIS_LANES - 1) / AXIS_LANES * AXIS_LANES)
+#define MYIP_RES_BEATS      (MYIP_ROWS / AXIS_LANES)
+#define ROW_CYCLES          (MATRIX_A_COLS + 4)     // matrix_multiply: n reads, MAC pipeline, RES write
+#define FIRST_RES_CYCLES    (MATRIX_A_COLS + 10)    // + Start, RES_RAM read and output register
+#define SPARSE_EOR          (1U << 31)
+#define STREAM_LOAD_B       (1U << 31)
+#define STREAM_RES_DEPTH    16                      // 2^RES_depth_bits
+#define STREAM_RES_CYCLES   4
+#define SYSTOLIC_TILES      (MYIP_ROWS / SYSTOLIC_ROWS)
+#define SYSTOLIC_STEPS      (MATRIX_A_COLS + SYSTOLIC_ROWS + MATRIX_B_COLS + 1)
+#define SYSTOLIC_RESULTS    (SYSTOLIC_ROWS * MATRIX_B_COLS)
+#define DONE_TO_LAST_OUT    2                       // Done to the last result on M_AXIS_TDATA
+#define RES_TO_OUT_CYCLES   3                       // RES write to M_AXIS_TDATA: read, read data, output register
+#define MYIP_CAPS           (0x4D000100U | AXIS_LANES)  // LAYOUT_CAPS of myip_v1_0, one bank
+
+#if MYIP_SYSTOLIC && MYIP_ROWS % SYSTOLIC_ROWS != 0
+#error "myip_systolic_v1_0 needs grid_rows (SYSTOLIC_ROWS) to divide the rows of a shard"
+#endif
+
+class MyipEmulated : public AxisModel {
+public:
+	MyipEmulated() : Inputs(MYIP_ROWS * MATRIX_A_COLS + MYIP_B_ELEMENTS), Res(MYIP_ROWS), ResCycle(MYIP_ROWS) {}
+
+	const char *Name() const override { return "myip_v1_0 (emulated)"; }
+
+	void Reset(AxisPins &Pins) override
+	{
+		State = IDLE;
+		Now = 0;
+		InCount = 0;
+		RowsIn = 0;
+		OutIndex = 0;
+		RowsWritten = 0;
+		ReadBeat = 0;
+		ReadPending = false;
+		SkidFull = false;
+		LastIn = 0;
+		for (uint32_t &Value : Counter) {
+			Value = 0;
+		}
+		Pins.SAxisTready = false;
+		Pins.MAxisTvalid = false;
+		Pins.MAxisTdata = AxisData();
+		Pins.MAxisTlast = false;
+	}
+
+	void Tick(AxisPins &Pins) override
+	{
+		bool InFire = Pins.SAxisTvalid && Pins.SAxisTready;
+		bool OutFire = Pins.MAxisTvalid && Pins.MAxisTready;
+
+		Count(Pins);
+
+		switch (State) {
+		case IDLE:
+			if (Pins.SAxisTvalid) {
+				State = LOAD;
+				Pins.SAxisTready = true;
+			}
+			break;
+
+		case LOAD:
+			if (InFire) {
+#ifdef SPARSE_A
+				Inputs[InCount++] = Pins.SAxisTdata[0];
+				if (InCount > MATRIX_A_COLS && (Pins.SAxisTdata[0] & SPARSE_EOR)) {
+					RowsIn++;
+				}
+				if (RowsIn == MYIP_ROWS) {
+#else
+				for (int Lane = 0; Lane < AXIS_LANES; Lane++) {
+					Inputs[InCount++] = AXIS_LANES == 1 ? Pins.SAxisTdata[0]
+						: (Pins.SAxisTdata[Lane / 4] >> (8 * (Lane % 4))) & 0xFF;
+				}
+				if (InCount == Inputs.size()) {
+#endif
+					Compute();
+					State = BUSY;
+					Pins.SAxisTready = false;
+					InCount = 0;
+					RowsIn = 0;
+					OutIndex = 0;
+					RowsWritten = 0;
+					ReadBeat = 0;
+					LastIn = Now;
+				}
+			}
+			break;
+
+		case BUSY:
+			if (OutFire) {
+				if (Pins.MAxisTlast) {
+					State = IDLE;
+				}
+				OutIndex++;
+			}
+			break;
+		}
+
+		bool ReadEn = ReadRes(Pins.MAxisTvalid + SkidFull + ReadPending - OutFire <= 1);
+		if (!Pins.MAxisTvalid || OutFire) {
+			// the beat in the skid register goes first, the one read in its place
+			bool Next = SkidFull || ReadPending;
+			SkidFull = SkidFull && ReadPending;
+			Pins.MAxisTvalid = Next;
+			Pins.MAxisTdata = Next ? ResBeat(OutIndex) : AxisData();
+			Pins.MAxisTlast = Next && OutIndex == MYIP_RES_BEATS - 1;
+		}
+		else if (ReadPending) {
+			SkidFull = true;
+		}
+		ReadPending = ReadEn;
+		Now++;
+	}
+
+	uint32_t ReadRegister(uint32_t Offset) override
+	{
+		uint32_t Index = Offset / 4;
+		if (Index == CAPS) {
+#ifdef SPARSE_A
+			return MYIP_CAPS | (1U << 16);
+#else
+			return MYIP_CAPS;
+#endif
+		}
+		return (Index > CTRL && Index < COUNTERS) ? Counter[Index] : 0;
+	}
+
+	void WriteRegister(uint32_t Offset, uint32_t Value) override
+	{
+		if (Offset / 4 == CTRL && (Value & 1)) {
+			for (uint32_t &Counted : Counter) {
+				Counted = 0;
+			}
+		}
+	}
+
+private:
+	enum { IDLE, LOAD, BUSY } State;
+
+	/* Registers of perf_counters.sv, by byte offset / 4 */
+	enum { CTRL, JOBS, READ_A, READ_B, COMPUTE, WRITE_OUTPUTS, IN_STALLS, OUT_STALLS, COUNTERS, CAPS = COUNTERS };
+
+	/* Events of this cycle, from the state and the pins before the edge */
+	void Count(const AxisPins &Pins)
+	{
+		// the RTL's write address lags a beat: the first beat of the other
+		// matrix is still taken in the state of the one before
+		if (State == LOAD) {
+#ifdef SPARSE_A
+			bool ReadingA = InCount > MATRIX_A_COLS;
+#else
+			bool ReadingA = InCount <= MYIP_ROWS * MATRIX_A_COLS;
+#endif
+			Counter[ReadingA ? READ_A : READ_B]++;
+			Counter[IN_STALLS] += !Pins.SAxisTvalid;
+		}
+#ifndef SPARSE_A
+		// and dense B leaves READ_INPUTS_B one cycle after its last beat
+		else if (State == BUSY && Now == LastIn + 1) {
+			Counter[READ_B]++;
+			Counter[IN_STALLS] += !Pins.SAxisTvalid;
+		}
+#endif
+		else if (State == BUSY) {
+			Counter[Now + DONE_TO_LAST_OUT < LastIn + ResCycle[MYIP_ROWS - 1] ? COMPUTE : WRITE_OUTPUTS]++;
+		}
+		Counter[OUT_STALLS] += Pins.MAxisTvalid && !Pins.MAxisTready;
+		Counter[JOBS] += Pins.MAxisTvalid && Pins.MAxisTready && Pins.MAxisTlast;
+	}
+
+	/* Results of rows Beat * AXIS_LANES on, one byte each unless a single lane */
+	AxisData ResBeat(uint32_t Beat) const
+	{
+		AxisData Data = AxisData();
+		for (int Lane = 0; Lane < AXIS_LANES; Lane++) {
+			uint32_t Value = Res[Beat * AXIS_LANES + Lane];
+			Data[Lane / 4] |= AXIS_LANES == 1 ? Value : Value << (8 * (Lane % 4));
+		}
+		return Data;
+	}
+
+	/* RES_read_en of this cycle: the next beat is read once its last row is
+	 * written, but not while matrix_multiply writes a row (single port) */
+	bool ReadRes(bool Room)
+	{
+		if (State != BUSY) {
+			return false;
+		}
+		while (RowsWritten < MYIP_ROWS && LastIn + ResCycle[RowsWritten] - RES_TO_OUT_CYCLES < Now) {
+			RowsWritten++;
+		}
+		bool Writing = RowsWritten < MYIP_ROWS && LastIn + ResCycle[RowsWritten] - RES_TO_OUT_CYCLES == Now;
+		bool ReadEn = Room && !Writing && ReadBeat < MYIP_RES_BEATS && RowsWritten >= (ReadBeat + 1) * AXIS_LANES;
+		ReadBeat += ReadEn;
+		return ReadEn;
+	}
+
+	/* Results, and the cycle after the last input beat each can leave the IP */
+	void Compute()
+	{
+#ifdef SPARSE_A
+		const uint32_t *B = Inputs.data();
+		const uint32_t *Entry = B + MATRIX_A_COLS;
+		uint64_t Cycle = 5;
+		for (int i = 0; i < MYIP_ROWS; i++) {
+			uint32_t Acc = 0;
+			uint32_t Word;
+			do {
+				Word = *Entry++;
+				Acc += ((Word & 0xFF) * (B[(Word >> 8) & 0xFFFF] & 0xFF)) >> 8;
+				Cycle++;
+			} while (!(Word & SPARSE_EOR));
+			Res[i] = Acc & 0xFF;
+			Cycle += 5;
+			ResCycle[i] = Cycle;
+		}
+#else
+		const uint32_t *A = Inputs.data();
+		const uint32_t *B = A + MYIP_ROWS * MATRIX_A_COLS;
+		for (int i = 0; i < MYIP_ROWS; i++) {
+			uint32_t Acc = 0;
+			for (int k = 0; k < MATRIX_A_COLS; k++) {
+				Acc += ((A[i * MATRIX_A_COLS + k] & 0xFF) * (B[k] & 0xFF)) >> 8;
+			}
+			Res[i] = Acc & 0xFF;
+			ResCycle[i] = FIRST_RES_CYCLES + (uint64_t)i * ROW_CYCLES;
+		}
+#endif
+	}
+
+	uint64_t Now;
+	uint64_t LastIn;
+	uint32_t InCount;
+	uint32_t RowsIn;
+	uint32_t OutIndex;
+	uint32_t RowsWritten;   // RES_written_count
+	uint32_t ReadBeat;      // RES_read_address
+	bool ReadPending;       // RES_read_pending
+	bool SkidFull;          // skid_valid
+	std::vector<uint32_t> Inputs;
+	std::vector<uint32_t> Res;
+	std::vector<uint64_t> ResCycle;
+	uint32_t Counter[COUNTERS];
+};
+
+class MyipStreamEmulated : public AxisModel {
+public:
+	MyipStreamEmulated() : B(MATRIX_A_COLS) {}
+
+	const char *Name() const override { return "myip_stream_v1_0 (emulated)"; }
+
+	void Reset(AxisPins &Pins) override
+	{
+		Now = 0;
+		Index = 0;
+		LoadingB = false;
+		RowsOpen = 0;
+		Acc = 0;
+		Pending.clear();
+		Out.clear();
+		Pins.SAxisTready = false;
+		Pins.MAxisTvalid = false;
+		Pins.MAxisTdata = AxisData();
+		Pins.MAxisTlast = false;
+	}
+
+	void Tick(AxisPins &Pins) override
+	{
+		bool InFire = Pins.SAxisTvalid && Pins.SAxisTready;
+		bool OutFire = Pins.MAxisTvalid && Pins.MAxisTready;
+		bool RowEnd = false;
+
+		if (InFire) {
+			uint32_t Word = Pins.SAxisTdata[0];
+			bool BWord = (Word & STREAM_LOAD_B) || LoadingB;
+			uint32_t Position = (Word & STREAM_LOAD_B) ? 0 : Index;
+			if (BWord) {
+				B[Position] = Word & 0xFF;
+			}
+			else {
+				if (Position == 0) {
+					Acc = 0;
+					RowsOpen++;
+				}
+				Acc += ((Word & 0xFF) * B[Position]) >> 8;
+				if (Position == MATRIX_A_COLS - 1) {
+					Pending.push_back({Acc & 0xFF, Pins.SAxisTlast, Now + STREAM_RES_CYCLES});
+					RowEnd = true;
+				}
+			}
+			Index = Position == MATRIX_A_COLS - 1 ? 0 : Position + 1;
+			LoadingB = BWord && Position != MATRIX_A_COLS - 1;
+		}
+		if (OutFire) {
+			Out.pop_front();
+			RowsOpen--;
+		}
+		while (!Pending.empty() && Pending.front().Ready <= Now) {
+			Out.push_back(Pending.front());
+			Pending.pop_front();
+		}
+
+		Pins.SAxisTready = !RowEnd && (Index != 0 || LoadingB || RowsOpen != STREAM_RES_DEPTH);
+		Pins.MAxisTvalid = !Out.empty();
+		Pins.MAxisTdata = Out.empty() ? AxisData() : AxisData{{Out.front().Data}};
+		Pins.MAxisTlast = !Out.empty() && Out.front().Last;
+		Now++;
+	}
+
+private:
+	struct Result {
+		uint32_t Data;
+		bool Last;
+		uint64_t Ready;
+	};
+
+	uint64_t Now;
+	uint32_t Index;
+	bool LoadingB;
+	uint32_t RowsOpen;
+	uint32_t Acc;
+	std::vector<uint32_t> B;
+	std::deque<Result> Pending;
+	std::deque<Result> Out;
+};
+
+class MyipSystolicEmulated : public AxisModel {
+public:
+	MyipSystolicEmulated() : A(MYIP_ROWS * MATRIX_A_COLS), B(MATRIX_A_COLS * MATRIX_B_COLS), TileRes(SYSTOLIC_RESULTS) {}
+
+	const char *Name() const override { return "myip_systolic_v1_0 (emulated)"; }
+
+	void Reset(AxisPins &Pins) override
+	{
+		State = READ_INPUTS_A;
+		InCount = 0;
+		Tile = 0;
+		Step = 0;
+		TileResValid = false;
+		TileResLast = false;
+		OutIndex = 0;
+		Pins.SAxisTready = true;
+		Pins.MAxisTvalid = false;
+		Pins.MAxisTdata = AxisData();
+		Pins.MAxisTlast = false;
+	}
+
+	void Tick(AxisPins &Pins) override
+	{
+		bool InFire = Pins.SAxisTvalid && Pins.SAxisTready;
+		bool Capture = State == COMPUTE && Step == SYSTOLIC_STEPS - 1 && !TileResValid;
+
+		// M_AXIS from the result bank as it was before this edge
+		if (!Pins.MAxisTvalid || Pins.MAxisTready) {
+			Pins.MAxisTvalid = TileResValid;
+			Pins.MAxisTdata = TileResValid ? AxisData{{TileRes[OutIndex]}} : AxisData();
+			Pins.MAxisTlast = TileResValid && TileResLast && OutIndex == SYSTOLIC_RESULTS - 1;
+			if (TileResValid && ++OutIndex == SYSTOLIC_RESULTS) {
+				OutIndex = 0;
+				TileResValid = false;
+			}
+		}
+
+		switch (State) {
+		case READ_INPUTS_A:
+			if (InFire) {
+				A[InCount++] = Pins.SAxisTdata[0] & 0xFF;
+				if (InCount == A.size()) {
+					State = READ_INPUTS_B;
+					InCount = 0;
+				}
+			}
+			break;
+
+		case READ_INPUTS_B:
+			if (InFire) {
+				B[InCount++] = Pins.SAxisTdata[0] & 0xFF;
+				if (InCount == B.size()) {
+					State = COMPUTE;
+					InCount = 0;
+				}
+			}
+			break;
+
+		case COMPUTE:
+			if (Step != SYSTOLIC_STEPS - 1) {
+				Step++;
+			}
+			else if (Capture) {
+				ComputeTile();
+				TileResValid = true;
+				TileResLast = Tile == SYSTOLIC_TILES - 1;
+				Step = 0;
+				if (++Tile == SYSTOLIC_TILES) {
+					Tile = 0;
+					State = READ_INPUTS_A;
+				}
+			}
+			break;
+		}
+		Pins.SAxisTready = State != COMPUTE;
+	}
+
+private:
+	enum { READ_INPUTS_A, READ_INPUTS_B, COMPUTE } State;
+
+	/* The sums of the rows of the current tile, row-major */
+	void ComputeTile()
+	{
+		for (int i = 0; i < SYSTOLIC_ROWS; i++) {
+			const uint32_t *Row = &A[(Tile * SYSTOLIC_ROWS + i) * MATRIX_A_COLS];
+			for (int j = 0; j < MATRIX_B_COLS; j++) {
+				uint32_t Acc = 0;
+				for (int k = 0; k < MATRIX_A_COLS; k++) {
+					Acc += (Row[k] * B[k * MATRIX_B_COLS + j]) >> 8;
+				}
+				TileRes[i * MATRIX_B_COLS + j] = Acc & 0xFF;
+			}
+		}
+	}
+
+	uint32_t InCount;
+	uint32_t Tile;
+	uint32_t Step;
+	bool TileResValid;
+	bool TileResLast;
+	uint32_t OutIndex;
+	std::vector<uint32_t> A;
+	std::vector<uint32_t> B;
+	std::vector<uint32_t> TileRes;
+};
+
+std::unique_ptr<AxisModel> CreateAxisModel()
+{
+#ifdef STREAM_ROWS
+	return std::unique_ptr<AxisModel>(new MyipStreamEmulated());
+#elif MYIP_SYSTOLIC
+	return std::unique_ptr<AxisModel>(new MyipSystolicEmulated());
+#else
+	return std::unique_ptr<AxisModel>(new MyipEmulated());
+#endif
+}
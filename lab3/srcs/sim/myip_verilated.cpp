@@ -0,0 +1,181 @@
+/******************************************************************************
+* Verilator backend of the co-simulation shim: the actual lab1 RTL
+* (myip_v1_0, matrix_multiply, mac, memory_RAM) clocked one ACLK at a time.
+*
+* Build the DMA firmware against it from the repository root with
+*   verilator --cc --exe --build -O3 --top-module myip_v1_0 -Gm=64 -Gn=8 \
+*     lab1/srcs/myip_v1_0.sv lab1/srcs/matrix_multiply.sv lab1/srcs/mac.sv lab1/srcs/memory_RAM.sv lab1/srcs/perf_counters.sv \
+*     lab3/srcs/sim/sim_platform.cpp lab3/srcs/sim/sim_fifo.cpp lab3/srcs/sim/sim_dma.cpp \
+*     lab3/srcs/sim/myip_verilated.cpp lab3/srcs/dma/c/lab3_dma.c lab3/srcs/dma/c/trace.c lab3/srcs/dma/c/hybrid.c \
+*     -CFLAGS "-I$PWD/lab3/srcs/sim/bsp -I$PWD/lab3/srcs/sim" -o lab3_dma_sim
+* (lab3/srcs/fifo/c/lab3_fifo.c for the FIFO firmware). m must be
+* MATRIX_A_ROWS / NUM_SHARDS and n MATRIX_A_COLS of the firmware. Add
+* -Gsparse=1 for firmware built with -DSPARSE_A. Firmware built with
+* -DSTREAM_ROWS takes --top-module myip_stream_v1_0 --prefix Vmyip_v1_0 with
+* lab1/srcs/myip_stream_v1_0.sv in place of myip_v1_0.sv and
+* matrix_multiply.sv, and no -Gm. Firmware built with -DAXIS_LANES=8 or 16
+* takes -Glanes=8 or 16, and -DAXIS_LANES the same in -CFLAGS.
+* Firmware built with -DMATRIX_B_COLS=p takes --top-module myip_systolic_v1_0
+* --prefix Vmyip_v1_0 -Gp=p with lab1/srcs/myip_systolic_v1_0.sv and
+* systolic_array.sv in place of myip_v1_0.sv, matrix_multiply.sv and mac.sv.
+* Those two tops have no S_AXI, build them with -DMYIP_NO_S_AXI in -CFLAGS.
+*
+* Unverified: this file has not been built with Verilator itself yet. It has
+* only been compiled against stand-in verilated.h / Vmyip_v1_0.h headers
+* (the port fields Verilator emits, IData / QData / VlWide by width) and run
+* against the RTL in a stand-in event simulator through every bench.py
+* backend, with right results and the cycles of myip_emulated.cpp. The
+* generated header and the scheduling of a real Verilator model may still
+* differ.
+******************************************************************************/
+
+#include "axis_model.h"
+
+#include "Vmyip_v1_0.h"
+#include "verilated.h"
+
+class MyipVerilated : public AxisModel {
+public:
+	MyipVerilated() : Context(new VerilatedContext), Top(new Vmyip_v1_0(Context.get())) {}
+	~MyipVerilated() override { Top->final(); }
+
+	const char *Name() const override { return "myip_v1_0 (verilated)"; }
+
+	void Reset(AxisPins &Pins) override
+	{
+		Top->ARESETN = 0;
+		Top->S_AXIS_TVALID = 0;
+		Top->S_AXIS_TLAST = 0;
+		SetTdata(AxisData());
+		Top->M_AXIS_TREADY = 0;
+		IdleRegisterPins();
+		for (int i = 0; i < 4; i++) {
+			Clock();
+		}
+		Top->ARESETN = 1;
+		Sample(Pins);
+	}
+
+	void Tick(AxisPins &Pins) override
+	{
+		SetTdata(Pins.SAxisTdata);
+		Top->S_AXIS_TVALID = Pins.SAxisTvalid;
+		Top->S_AXIS_TLAST = Pins.SAxisTlast;
+		Top->M_AXIS_TREADY = Pins.MAxisTready;
+		Clock();
+		Sample(Pins);
+	}
+
+#ifndef MYIP_NO_S_AXI
+	/* One AXI4-Lite transaction, clocked on its own with S_AXIS_TVALID and
+	 * M_AXIS_TREADY low so no beat moves behind the shim's back. The extra
+	 * cycles show up in IN_STALLS / OUT_STALLS while a job is in flight */
+	uint32_t ReadRegister(uint32_t Offset) override
+	{
+		StreamsIdle Idle(*this);
+		Top->S_AXI_ARADDR = Offset;
+		Top->S_AXI_ARVALID = 1;
+		Top->S_AXI_RREADY = 1;
+		do {
+			Clock();
+		} while (!Top->S_AXI_RVALID);
+		uint32_t Value = Top->S_AXI_RDATA;
+		IdleRegisterPins();
+		Clock();
+		return Value;
+	}
+
+	void WriteRegister(uint32_t Offset, uint32_t Value) override
+	{
+		StreamsIdle Idle(*this);
+		Top->S_AXI_AWADDR = Offset;
+		Top->S_AXI_AWVALID = 1;
+		Top->S_AXI_WDATA = Value;
+		Top->S_AXI_WSTRB = 0xF;
+		Top->S_AXI_WVALID = 1;
+		Top->S_AXI_BREADY = 1;
+		do {
+			Clock();
+		} while (!Top->S_AXI_BVALID);
+		IdleRegisterPins();
+		Clock();
+	}
+#endif
+
+private:
+	/* Holds the stream handshakes low for the lifetime of the object */
+	struct StreamsIdle {
+		explicit StreamsIdle(MyipVerilated &Owner) : Top(*Owner.Top), Tvalid(Top.S_AXIS_TVALID), Tready(Top.M_AXIS_TREADY)
+		{
+			Top.S_AXIS_TVALID = 0;
+			Top.M_AXIS_TREADY = 0;
+		}
+		~StreamsIdle()
+		{
+			Top.S_AXIS_TVALID = Tvalid;
+			Top.M_AXIS_TREADY = Tready;
+		}
+		Vmyip_v1_0 &Top;
+		uint8_t Tvalid;
+		uint8_t Tready;
+	};
+
+	void IdleRegisterPins()
+	{
+#ifndef MYIP_NO_S_AXI
+		Top->S_AXI_AWVALID = 0;
+		Top->S_AXI_WVALID = 0;
+		Top->S_AXI_ARVALID = 0;
+		Top->S_AXI_BREADY = 1;
+		Top->S_AXI_RREADY = 1;
+#endif
+	}
+
+	void Clock()
+	{
+		Top->ACLK = 0;
+		Top->eval();
+		Top->ACLK = 1;
+		Top->eval();
+		Context->timeInc(1);
+	}
+
+	/* TDATA is a uint32_t, a QData or a VlWide by its width */
+	void SetTdata(const AxisData &Data)
+	{
+#if AXIS_DATA_WORDS == 1
+		Top->S_AXIS_TDATA = Data[0];
+#elif AXIS_DATA_WORDS == 2
+		Top->S_AXIS_TDATA = (QData)Data[1] << 32 | Data[0];
+#else
+		for (int w = 0; w < AXIS_DATA_WORDS; w++) {
+			Top->S_AXIS_TDATA[w] = Data[w];
+		}
+#endif
+	}
+
+	void Sample(AxisPins &Pins)
+	{
+		Pins.SAxisTready = Top->S_AXIS_TREADY;
+#if AXIS_DATA_WORDS == 1
+		Pins.MAxisTdata[0] = Top->M_AXIS_TDATA;
+#elif AXIS_DATA_WORDS == 2
+		Pins.MAxisTdata[0] = (uint32_t)Top->M_AXIS_TDATA;
+		Pins.MAxisTdata[1] = (uint32_t)(Top->M_AXIS_TDATA >> 32);
+#else
+		for (int w = 0; w < AXIS_DATA_WORDS; w++) {
+			Pins.MAxisTdata[w] = Top->M_AXIS_TDATA[w];
+		}
+#endif
+		Pins.MAxisTvalid = Top->M_AXIS_TVALID;
+		Pins.MAxisTlast = Top->M_AXIS_TLAST;
+	}
+
+	std::unique_ptr<VerilatedContext> Context;
+	std::unique_ptr<Vmyip_v1_0> Top;
+};
+
+std::unique_ptr<AxisModel> CreateAxisModel()
+{
+	return std::unique_ptr<AxisModel>(new MyipVerilated());
+}
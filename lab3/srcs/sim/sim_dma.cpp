@@ -0,0 +1,176 @@
+/******************************************************************************
+* AXI DMA driver (simple mode) of the co-simulation build (lab3_dma.c).
+******************************************************************************/
+
+#include "sim_platform.h"
+
+#include <cstdlib>
+
+#include "xparameters.h"
+
+#include "xaxidma.h"
+
+/* C_SG_LENGTH_WIDTH = 14 in lab3_dma.xsa */
+#define SIM_DMA_MAX_TRANSFER_LEN    ((1U << 14) - 1U)
+
+/* Instance i sits at DMA_BASE + i * DMA_STRIDE and drives stream i */
+#define SIM_DMA_BASE                0x80010000U
+#define SIM_DMA_STRIDE              0x00010000U
+
+/* Injected faults of a channel (MYIP_SIM_DMA_*_EVERY), cleared by a reset */
+struct DmaChannel {
+	bool Stalled;
+	u32 Errors;     // DMASR error bits, the channel is halted while set
+};
+
+static XAxiDma_Config DmaConfig[XPAR_XAXIDMA_NUM_INSTANCES];
+static DmaChannel Channels[XPAR_XAXIDMA_NUM_INSTANCES][2];
+static u32 Transfers;
+
+static u32 InstanceOf(UINTPTR BaseAddress)
+{
+	return (u32)((BaseAddress - SIM_DMA_BASE) / SIM_DMA_STRIDE);
+}
+
+static SimStream &StreamOf(XAxiDma *InstancePtr)
+{
+	return SimPlatform::Get().Stream(InstanceOf(InstancePtr->RegBase));
+}
+
+static bool FaultDue(const char *Name)
+{
+	const char *Every = getenv(Name);
+	u32 Period = Every ? (u32)strtoul(Every, NULL, 0) : 0;
+	return Period != 0 && Transfers % Period == 0;
+}
+
+XAxiDma_Config *XAxiDma_LookupConfig(u32 DeviceId)
+{
+	if (DeviceId >= XPAR_XAXIDMA_NUM_INSTANCES) {
+		return NULL;
+	}
+	DmaConfig[DeviceId] = {DeviceId, SIM_DMA_BASE + DeviceId * SIM_DMA_STRIDE, 0, 1, 1, 0,
+		AXIS_DATA_WORDS * 32, AXIS_DATA_WORDS * 32};
+	return &DmaConfig[DeviceId];
+}
+
+int XAxiDma_CfgInitialize(XAxiDma *InstancePtr, XAxiDma_Config *Config)
+{
+	InstancePtr->RegBase = Config->BaseAddr;
+	InstancePtr->HasMm2S = Config->HasMm2S;
+	InstancePtr->HasS2Mm = Config->HasS2Mm;
+	InstancePtr->HasSg = Config->HasSg;
+	InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+
+	StreamOf(InstancePtr).RxToMemory(NULL, 0);
+	return XST_SUCCESS;
+}
+
+int XAxiDma_Selftest(XAxiDma *InstancePtr)
+{
+	SimPlatform::Get().RegisterAccess();
+	return InstancePtr->IsReady == XIL_COMPONENT_IS_READY ? XST_SUCCESS : XST_FAILURE;
+}
+
+void XAxiDma_IntrDisable(XAxiDma *InstancePtr, u32 Mask, int Direction)
+{
+	(void)InstancePtr;
+	(void)Mask;
+	(void)Direction;
+	SimPlatform::Get().RegisterAccess();
+}
+
+int XAxiDma_SimpleTransfer(XAxiDma *InstancePtr, UINTPTR BuffAddr, u32 Length, int Direction)
+{
+	SimPlatform &Platform = SimPlatform::Get();
+	SimStream &Stream = StreamOf(InstancePtr);
+
+	if (Length == 0 || Length > SIM_DMA_MAX_TRANSFER_LEN) {
+		return XST_INVALID_PARAM;
+	}
+
+	// Busy check, then DMACR, address and length writes
+	if (XAxiDma_Busy(InstancePtr, Direction)) {
+		return XST_FAILURE;
+	}
+	for (int i = 0; i < 3; i++) {
+		Platform.RegisterAccess();
+	}
+
+	DmaChannel &Channel = Channels[InstanceOf(InstancePtr->RegBase)][Direction];
+	Transfers++;
+	if (FaultDue("MYIP_SIM_DMA_ERROR_EVERY")) {
+		Channel.Errors = XAXIDMA_ERR_SLAVE_MASK;
+		return XST_SUCCESS;
+	}
+	if (FaultDue("MYIP_SIM_DMA_STALL_EVERY")) {
+		Channel.Stalled = true;
+		return XST_SUCCESS;
+	}
+
+	// Whole beats of the stream width, the firmware pads its buffers to them
+	u32 *Buffer = (u32 *)BuffAddr;
+	u32 Beats = Length / (AXIS_DATA_WORDS * WORD_BYTES);
+	if (Direction == XAXIDMA_DMA_TO_DEVICE) {
+		for (u32 i = 0; i < Beats; i++) {
+			AxisData Data;
+			for (u32 w = 0; w < AXIS_DATA_WORDS; w++) {
+				Data[w] = Buffer[i * AXIS_DATA_WORDS + w];
+			}
+			Stream.TxPush(Data);
+		}
+		Stream.TxRelease(Beats, Platform.Cycle() + Platform.DmaLatency());
+	}
+	else {
+		Stream.RxToMemory(Buffer, Beats);
+	}
+	return XST_SUCCESS;
+}
+
+int XAxiDma_Busy(XAxiDma *InstancePtr, int Direction)
+{
+	u32 Offset = Direction == XAXIDMA_DMA_TO_DEVICE ? XAXIDMA_TX_OFFSET : XAXIDMA_RX_OFFSET;
+	return !(XAxiDma_ReadReg(InstancePtr->RegBase + Offset, XAXIDMA_SR_OFFSET) & XAXIDMA_IDLE_MASK);
+}
+
+
+/* DMASR of either channel, the other registers read as 0 */
+u32 XAxiDma_ReadReg(UINTPTR BaseAddress, u32 RegOffset)
+{
+	SimPlatform::Get().RegisterAccess();
+	int Direction = (BaseAddress - SIM_DMA_BASE) % SIM_DMA_STRIDE >= XAXIDMA_RX_OFFSET
+		? XAXIDMA_DEVICE_TO_DMA : XAXIDMA_DMA_TO_DEVICE;
+	u32 Instance = InstanceOf(BaseAddress);
+	DmaChannel &Channel = Channels[Instance][Direction];
+	SimStream &Stream = SimPlatform::Get().Stream(Instance);
+
+	if (RegOffset != XAXIDMA_SR_OFFSET) {
+		return 0;
+	}
+	if (Channel.Errors) {
+		return Channel.Errors | XAXIDMA_HALTED_MASK | XAXIDMA_IRQ_ERROR_MASK;
+	}
+	bool Busy = Channel.Stalled
+		|| (Direction == XAXIDMA_DMA_TO_DEVICE ? !Stream.TxIdle() : Stream.RxMemoryBusy());
+	return Busy ? 0 : XAXIDMA_IDLE_MASK;
+}
+
+
+/* Soft reset of both channels. In the block design mm2s_prmry_reset_out_n
+   drives the ARESETN of myip, so the IP is reset with the engine */
+void XAxiDma_Reset(XAxiDma *InstancePtr)
+{
+	u32 Instance = InstanceOf(InstancePtr->RegBase);
+
+	SimPlatform::Get().RegisterAccess();
+	Channels[Instance][XAXIDMA_DMA_TO_DEVICE] = DmaChannel();
+	Channels[Instance][XAXIDMA_DEVICE_TO_DMA] = DmaChannel();
+	StreamOf(InstancePtr).Reset();
+}
+
+int XAxiDma_ResetIsDone(XAxiDma *InstancePtr)
+{
+	(void)InstancePtr;
+	SimPlatform::Get().RegisterAccess();
+	return TRUE;
+}
@@ -0,0 +1,553 @@
+/******************************************************************************
+* Co-simulation platform: PL clock, AXI-Stream data movers, timer, UART and
+* sleep for the host build of the lab3 firmware.
+******************************************************************************/
+
+#include "sim_platform.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+#include "sleep.h"
+#include "xil_io.h"
+#include "xparameters.h"
+#include "xtime_l.h"
+#include "xtmrctr.h"
+#include "xuartps.h"
+
+static uint32_t EnvOrDefault(const char *Name, uint32_t Default)
+{
+	const char *Value = getenv(Name);
+	return Value ? (uint32_t)strtoul(Value, NULL, 0) : Default;
+}
+
+
+class AxisLoopback : public AxisModel {
+public:
+	const char *Name() const override { return "AXI-Stream loopback"; }
+
+	void Reset(AxisPins &Pins) override
+	{
+		Queue.clear();
+		Sample(Pins);
+	}
+
+	void Tick(AxisPins &Pins) override
+	{
+		if (Pins.MAxisTvalid && Pins.MAxisTready) {
+			Queue.pop_front();
+		}
+		if (Pins.SAxisTvalid && Pins.SAxisTready) {
+			Queue.push_back({Pins.SAxisTdata, Pins.SAxisTlast});
+		}
+		Sample(Pins);
+	}
+
+private:
+	static const size_t DEPTH = 16;
+
+	void Sample(AxisPins &Pins)
+	{
+		Pins.SAxisTready = Queue.size() < DEPTH;
+		Pins.MAxisTvalid = !Queue.empty();
+		Pins.MAxisTdata = Queue.empty() ? AxisData() : Queue.front().first;
+		Pins.MAxisTlast = !Queue.empty() && Queue.front().second;
+	}
+
+	std::deque<std::pair<AxisData, bool>> Queue;
+};
+
+std::unique_ptr<AxisModel> CreateLoopbackModel()
+{
+	return std::unique_ptr<AxisModel>(new AxisLoopback());
+}
+
+
+/* axis_loopback.sv: the first 32 bits of a packet pick LOOP, SINK or SOURCE,
+   results go out of a two-entry buffer, as in the RTL */
+class AxisTraffic : public AxisModel {
+public:
+	const char *Name() const override { return "axis_loopback"; }
+
+	void Reset(AxisPins &Pins) override
+	{
+		Queue.clear();
+		State = IDLE;
+		Beat = 0;
+		Packet = 0;
+		Count = 0;
+		Sample(Pins);
+	}
+
+	void Tick(AxisPins &Pins) override
+	{
+		bool InFire = Pins.SAxisTvalid && Pins.SAxisTready;
+		if (Pins.MAxisTvalid && Pins.MAxisTready) {
+			Queue.pop_front();
+		}
+
+		if (InFire) {
+			uint32_t Mode = State == IDLE ? Pins.SAxisTdata[0] >> 30 : State;
+			Mode = Mode == 3 && State == IDLE ? (uint32_t)SINK : Mode;     // the spare command drops the packet
+			if (State == IDLE && Mode == SOURCE) {
+				PacketBeats = (Pins.SAxisTdata[0] >> 16) & 0x3FFF;
+				Packets = Pins.SAxisTdata[0] & 0xFFFF;
+			}
+			if (Mode == LOOP) {
+				Queue.push_back({Pins.SAxisTdata, Pins.SAxisTlast});
+			}
+			if (!Pins.SAxisTlast) {
+				State = Mode == SOURCE ? (uint32_t)SOURCE_COMMAND : Mode;
+			}
+			else {
+				State = (Mode == SOURCE || Mode == SOURCE_COMMAND) && PacketBeats && Packets ? SOURCE_DATA : IDLE;
+			}
+		}
+		else if (State == SOURCE_DATA && Queue.size() < DEPTH) {
+			AxisData Data;
+			Data.fill(Count++);
+			bool Last = Beat == PacketBeats - 1;
+			Queue.push_back({Data, Last});
+			Beat = Last ? 0 : Beat + 1;
+			if (Last && ++Packet == Packets) {
+				Packet = 0;
+				State = IDLE;
+			}
+		}
+		Sample(Pins);
+	}
+
+private:
+	static const size_t DEPTH = 2;
+	enum { LOOP = 0, SINK = 1, SOURCE = 2, SOURCE_COMMAND = 3, SOURCE_DATA = 4, IDLE = 5 };
+
+	void Sample(AxisPins &Pins)
+	{
+		Pins.SAxisTready = State != SOURCE_DATA && Queue.size() < DEPTH;
+		Pins.MAxisTvalid = !Queue.empty();
+		Pins.MAxisTdata = Queue.empty() ? AxisData() : Queue.front().first;
+		Pins.MAxisTlast = !Queue.empty() && Queue.front().second;
+	}
+
+	std::deque<std::pair<AxisData, bool>> Queue;
+	uint32_t State = IDLE;
+	uint32_t PacketBeats = 0, Packets = 0;
+	uint32_t Beat = 0, Packet = 0, Count = 0;
+};
+
+std::unique_ptr<AxisModel> CreateTrafficModel()
+{
+	return std::unique_ptr<AxisModel>(new AxisTraffic());
+}
+
+
+SimStream::SimStream(std::unique_ptr<AxisModel> Model)
+	: TxComplete(false), RxComplete(false), Model(std::move(Model)), Pins(), TxReleased(0), TxNotBefore(0),
+	  RxIsFifo(true), RxFifoDepth(SIM_FIFO_DEPTH_WORDS), RxDestination(NULL), RxBeatsLeft(0), JobOpen(false), Current()
+{
+	this->Model->Reset(Pins);
+}
+
+
+void SimStream::TxPush(const AxisData &Data)
+{
+	Tx.push_back({Data, false});
+}
+
+
+void SimStream::TxRelease(uint32_t Beats, uint64_t NotBefore)
+{
+	if (Beats == 0 || TxReleased + Beats > Tx.size()) {
+		return;
+	}
+	TxReleased += Beats;
+	Tx[TxReleased - 1].Last = true;
+	if (NotBefore > TxNotBefore) {
+		TxNotBefore = NotBefore;
+	}
+}
+
+
+void SimStream::Reset()
+{
+	Tx.clear();
+	TxReleased = 0;
+	RxFifo.clear();
+	RxDestination = NULL;
+	RxBeatsLeft = 0;
+	JobOpen = false;
+	Model->Reset(Pins);
+}
+
+
+void SimStream::RxToFifo(uint32_t Depth)
+{
+	RxIsFifo = true;
+	RxFifoDepth = Depth;
+}
+
+
+void SimStream::RxToMemory(uint32_t *Destination, uint32_t Beats)
+{
+	RxIsFifo = false;
+	RxDestination = Destination;
+	RxBeatsLeft = Beats;
+}
+
+
+uint32_t SimStream::RxPop()
+{
+	if (RxFifo.empty()) {
+		return 0;
+	}
+	uint32_t Word = RxFifo.front();
+	RxFifo.pop_front();
+	return Word;
+}
+
+
+void SimStream::Tick(uint64_t Cycle)
+{
+	Pins.SAxisTvalid = TxReleased != 0 && Cycle >= TxNotBefore;
+	Pins.SAxisTdata = Pins.SAxisTvalid ? Tx.front().Data : AxisData();
+	Pins.SAxisTlast = Pins.SAxisTvalid && Tx.front().Last;
+	Pins.MAxisTready = RxIsFifo ? RxFifo.size() < RxFifoDepth : RxBeatsLeft != 0;
+
+	// Handshakes complete on this edge with the values currently on the pins
+	bool InFire = Pins.SAxisTvalid && Pins.SAxisTready;
+	bool InLast = Pins.SAxisTlast;
+	bool OutFire = Pins.MAxisTvalid && Pins.MAxisTready;
+	AxisData OutData = Pins.MAxisTdata;
+	bool OutLast = Pins.MAxisTlast;
+
+	Model->Tick(Pins);
+
+	if (InFire) {
+		if (!JobOpen) {
+			JobOpen = true;
+			Current = SimJob();
+			Current.FirstIn = Cycle;
+		}
+		Current.InBeats++;
+		Tx.pop_front();
+		TxReleased--;
+		if (InLast) {
+			Current.LastIn = Cycle;
+			TxComplete = true;
+		}
+	}
+
+	if (OutFire) {
+		if (JobOpen && Current.OutBeats++ == 0) {
+			Current.FirstOut = Cycle;
+		}
+		if (RxIsFifo) {
+			RxFifo.push_back(OutData[0]);
+		}
+		else {
+			for (uint32_t Word : OutData) {
+				*RxDestination++ = Word;
+			}
+			RxBeatsLeft--;
+		}
+		if (OutLast) {
+			RxComplete = true;
+			if (!RxIsFifo) {
+				RxBeatsLeft = 0;
+			}
+			if (JobOpen) {
+				Current.LastOut = Cycle;
+				Completed.push_back(Current);
+				JobOpen = false;
+			}
+		}
+	}
+}
+
+
+SimPlatform &SimPlatform::Get()
+{
+	static SimPlatform Platform;
+	return Platform;
+}
+
+
+SimPlatform::SimPlatform()
+	: Now(0),
+	  RegCycles(EnvOrDefault("MYIP_SIM_REG_CYCLES", 45)),
+	  DmaLatencyCycles(EnvOrDefault("MYIP_SIM_DMA_LATENCY", 32)),
+	  CpuScale(0.0),
+	  LastHost(std::chrono::steady_clock::now())
+{
+	const char *Csv = getenv("MYIP_SIM_JOBS_CSV");
+	if (Csv) {
+		JobsCsv = Csv;
+	}
+	const char *Scale = getenv("MYIP_SIM_CPU_SCALE");
+	if (Scale) {
+		CpuScale = strtod(Scale, NULL);
+	}
+	Loopback = EnvOrDefault("MYIP_SIM_LOOPBACK", 0);
+	Stream(0);
+}
+
+
+SimStream &SimPlatform::Stream(uint32_t Index)
+{
+	while (Streams.size() <= Index) {
+		Streams.emplace_back(new SimStream(Loopback == 2 ? CreateTrafficModel()
+			: Loopback ? CreateLoopbackModel() : CreateAxisModel()));
+	}
+	return *Streams[Index];
+}
+
+
+SimPlatform::~SimPlatform()
+{
+	Report();
+}
+
+
+void SimPlatform::Advance(uint64_t Cycles)
+{
+	for (uint64_t i = 0; i < Cycles; i++) {
+		for (auto &Stream : Streams) {
+			Stream->Tick(Now);
+		}
+		Now++;
+	}
+	// Time spent simulating is not CPU time of the firmware
+	if (CpuScale > 0.0) {
+		SkipCpuTime();
+	}
+}
+
+
+void SimPlatform::SyncCpuTime()
+{
+	if (CpuScale <= 0.0) {
+		return;
+	}
+	std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now() - LastHost;
+	Advance((uint64_t)(Elapsed.count() * CpuScale * SIM_PL_CLOCK_HZ));
+}
+
+
+/* Cycle-accurate per-job latency and throughput on the accelerator pins, to stderr */
+void SimPlatform::Report() const
+{
+	std::vector<SimJob> Jobs;
+	std::vector<size_t> Instance;
+	for (size_t s = 0; s < Streams.size(); s++) {
+		Jobs.insert(Jobs.end(), Streams[s]->Jobs().begin(), Streams[s]->Jobs().end());
+		Instance.resize(Jobs.size(), s);
+	}
+
+	fprintf(stderr, "SIM: %s x%zu, %llu PL cycles, %u cycles/register access, %zu jobs\n",
+		Streams[0]->ModelName(), Streams.size(), (unsigned long long)Now, RegCycles, Jobs.size());
+	if (Jobs.empty()) {
+		return;
+	}
+
+	uint64_t Min = UINT64_MAX, Max = 0, Sum = 0, SumFirstOut = 0, SumIn = 0, Beats = 0;
+	for (const SimJob &Job : Jobs) {
+		uint64_t Latency = Job.LastOut - Job.FirstIn + 1;
+		Min = Latency < Min ? Latency : Min;
+		Max = Latency > Max ? Latency : Max;
+		Sum += Latency;
+		SumFirstOut += Job.FirstOut - Job.FirstIn + 1;
+		SumIn += Job.LastIn - Job.FirstIn + 1;
+		Beats += Job.InBeats + Job.OutBeats;
+	}
+	uint64_t First = UINT64_MAX, Last = 0;
+	for (const SimJob &Job : Jobs) {
+		First = Job.FirstIn < First ? Job.FirstIn : First;
+		Last = Job.LastOut > Last ? Job.LastOut : Last;
+	}
+	uint64_t Span = Last - First + 1;
+	double Count = (double)Jobs.size();
+
+	fprintf(stderr, "SIM: job latency min=%llu avg=%.1f max=%llu cycles, input %.1f cycles, first result after %.1f cycles\n",
+		(unsigned long long)Min, Sum / Count, (unsigned long long)Max, SumIn / Count, SumFirstOut / Count);
+	fprintf(stderr, "SIM: throughput %.1f jobs/s back-to-back, %.1f jobs/s end-to-end, %.3f beats/cycle\n",
+		SIM_PL_CLOCK_HZ * Count / Sum, SIM_PL_CLOCK_HZ * Count / Span, (double)Beats / Sum);
+
+	if (!JobsCsv.empty()) {
+		FILE *File = fopen(JobsCsv.c_str(), "w");
+		if (!File) {
+			fprintf(stderr, "SIM: cannot write %s\n", JobsCsv.c_str());
+			return;
+		}
+		fprintf(File, "job,first_in,last_in,first_out,last_out,in_beats,out_beats,latency,instance\n");
+		for (size_t i = 0, Base = 0; i < Jobs.size(); i++) {
+			const SimJob &Job = Jobs[i];
+			Base = (i > 0 && Instance[i] != Instance[i - 1]) ? i : Base;
+			fprintf(File, "%zu,%llu,%llu,%llu,%llu,%u,%u,%llu,%zu\n", i - Base,
+				(unsigned long long)Job.FirstIn, (unsigned long long)Job.LastIn,
+				(unsigned long long)Job.FirstOut, (unsigned long long)Job.LastOut,
+				Job.InBeats, Job.OutBeats, (unsigned long long)(Job.LastOut - Job.FirstIn + 1), Instance[i]);
+		}
+		fclose(File);
+	}
+}
+
+
+/* ----- AXI timer ----- */
+
+/* About the register accesses of the real driver calls, so that a bring-up
+   costs on the host what it does on the board */
+static const int TMRCTR_INIT_ACCESSES = 5 * XTC_DEVICE_TIMER_COUNT;    // TCSR and TLR of every counter
+static const int TMRCTR_SELFTEST_ACCESSES = 8;     // TLR written and read back, load, run, read, stop
+
+int XTmrCtr_Initialize(XTmrCtr *InstancePtr, u16 DeviceId)
+{
+	(void)DeviceId;
+	*InstancePtr = XTmrCtr();
+	InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+	for (int i = 0; i < TMRCTR_INIT_ACCESSES; i++) {
+		SimPlatform::Get().RegisterAccess();
+	}
+	return XST_SUCCESS;
+}
+
+int XTmrCtr_SelfTest(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	for (int i = 0; i < TMRCTR_SELFTEST_ACCESSES; i++) {
+		SimPlatform::Get().RegisterAccess();
+	}
+	return (InstancePtr->IsReady == XIL_COMPONENT_IS_READY && TmrCtrNumber < XTC_DEVICE_TIMER_COUNT)
+		? XST_SUCCESS : XST_FAILURE;
+}
+
+void XTmrCtr_SetOptions(XTmrCtr *InstancePtr, u8 TmrCtrNumber, u32 Options)
+{
+	(void)InstancePtr;
+	(void)TmrCtrNumber;
+	(void)Options;
+	SimPlatform::Get().RegisterAccess();
+}
+
+void XTmrCtr_SetResetValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber, u32 ResetValue)
+{
+	SimPlatform::Get().RegisterAccess();
+	InstancePtr->ResetValue[TmrCtrNumber] = ResetValue;
+}
+
+void XTmrCtr_Reset(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	SimPlatform &Platform = SimPlatform::Get();
+	Platform.RegisterAccess();
+	InstancePtr->Value[TmrCtrNumber] = InstancePtr->ResetValue[TmrCtrNumber];
+	InstancePtr->StartCycle[TmrCtrNumber] = Platform.Cycle();
+}
+
+void XTmrCtr_Start(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	SimPlatform &Platform = SimPlatform::Get();
+	Platform.RegisterAccess();
+	if (!InstancePtr->IsRunning[TmrCtrNumber]) {
+		InstancePtr->IsRunning[TmrCtrNumber] = TRUE;
+		InstancePtr->StartCycle[TmrCtrNumber] = Platform.Cycle();
+	}
+}
+
+void XTmrCtr_Stop(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	SimPlatform &Platform = SimPlatform::Get();
+	Platform.RegisterAccess();
+	if (InstancePtr->IsRunning[TmrCtrNumber]) {
+		InstancePtr->Value[TmrCtrNumber] += (u32)(Platform.Cycle() - InstancePtr->StartCycle[TmrCtrNumber]);
+		InstancePtr->IsRunning[TmrCtrNumber] = FALSE;
+	}
+}
+
+u32 XTmrCtr_GetValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	SimPlatform &Platform = SimPlatform::Get();
+	Platform.RegisterAccess();
+	u32 Value = InstancePtr->Value[TmrCtrNumber];
+	if (InstancePtr->IsRunning[TmrCtrNumber]) {
+		Value += (u32)(Platform.Cycle() - InstancePtr->StartCycle[TmrCtrNumber]);
+	}
+	return Value;
+}
+
+
+/* ----- S_AXI register banks of the accelerators ----- */
+
+/* Stream of the myip_<i> whose S_AXI range holds Addr, or NULL */
+static SimStream *RegisterStream(UINTPTR Addr, uint32_t *Offset)
+{
+	if (Addr < XPAR_MYIP_0_S_AXI_BASEADDR) {
+		return NULL;
+	}
+	UINTPTR Index = (Addr - XPAR_MYIP_0_S_AXI_BASEADDR) / SIM_MYIP_S_AXI_STRIDE;
+	if (Index >= SIM_MYIP_S_AXI_INSTANCES) {
+		return NULL;
+	}
+	*Offset = (uint32_t)((Addr - XPAR_MYIP_0_S_AXI_BASEADDR) % SIM_MYIP_S_AXI_STRIDE);
+	return &SimPlatform::Get().Stream((uint32_t)Index);
+}
+
+u32 Xil_In32(UINTPTR Addr)
+{
+	uint32_t Offset;
+	SimPlatform::Get().RegisterAccess();
+	SimStream *Stream = RegisterStream(Addr, &Offset);
+	return Stream ? Stream->ReadRegister(Offset) : 0;
+}
+
+void Xil_Out32(UINTPTR Addr, u32 Value)
+{
+	uint32_t Offset;
+	SimPlatform::Get().RegisterAccess();
+	SimStream *Stream = RegisterStream(Addr, &Offset);
+	if (Stream) {
+		Stream->WriteRegister(Offset, Value);
+	}
+}
+
+
+/* ----- UART on stdin/stdout, sleep, printf ----- */
+
+u8 XUartPs_RecvByte(UINTPTR BaseAddress)
+{
+	(void)BaseAddress;
+	int Char = getchar();
+	SimPlatform::Get().SkipCpuTime();
+	if (Char == EOF) {
+		// Nothing more to replay, the board would wait here forever
+		fflush(stdout);
+		exit(0);
+	}
+	return (u8)Char;
+}
+
+void XUartPs_SendByte(UINTPTR BaseAddress, u8 Data)
+{
+	(void)BaseAddress;
+	putchar(Data);
+}
+
+void SimSleepMicroseconds(u64 useconds)
+{
+	SimPlatform::Get().SyncCpuTime();
+	SimPlatform::Get().Advance(useconds * (SIM_PL_CLOCK_HZ / 1000000U));
+}
+
+void XTime_GetTime(XTime *Xtime_Global)
+{
+	// A system register read on the A53, no bus access
+	SimPlatform::Get().SyncCpuTime();
+	*Xtime_Global = SimPlatform::Get().Cycle();
+}
+
+int xil_printf(const char *fmt, ...)
+{
+	va_list Args;
+	va_start(Args, fmt);
+	int Written = vfprintf(stderr, fmt, Args);
+	va_end(Args);
+	return Written;
+}
@@ -0,0 +1,143 @@
+/******************************************************************************
+* Co-simulation platform for the host build of the lab3 firmware.
+*
+* The PL clock only advances when the firmware touches the hardware: every
+* driver register access costs MYIP_SIM_REG_CYCLES PL cycles and usleep()
+* runs the clock for the requested time. CPU-only work is free, so the
+* timer values measure bus and accelerator time, which is what the Stats
+* of the DMA/FIFO firmware are meant to capture.
+*
+* Environment variables
+*   MYIP_SIM_REG_CYCLES   PL cycles per PS register access (default 45,
+*                         matches TX=46930 in STATS_fifo.txt: 2 accesses/word)
+*   MYIP_SIM_DMA_LATENCY  PL cycles from MM2S start to the first beat (default 32)
+*   MYIP_SIM_JOBS_CSV     write one line per job and instance to this file
+*   MYIP_SIM_LOOPBACK     1 = loop S_AXIS back to M_AXIS instead of the IP (lab2),
+*                         2 = axis_loopback.sv instead of the IP (DMA_BENCH)
+*   MYIP_SIM_DMA_STALL_EVERY  every Nth AXI DMA transfer is accepted but never
+*                         moves a beat, until the engine is reset (default off)
+*   MYIP_SIM_DMA_ERROR_EVERY  every Nth AXI DMA transfer halts its channel
+*                         with DMASlvErr set in DMASR (default off)
+*   MYIP_SIM_CPU_SCALE    also charge host CPU time between hardware accesses,
+*                         scaled by this factor (board CPU time / host CPU time).
+*                         Not deterministic, off by default
+******************************************************************************/
+
+#ifndef SIM_PLATFORM_H
+#define SIM_PLATFORM_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "axis_model.h"
+
+#define SIM_PL_CLOCK_HZ         100000000U
+#define SIM_FIFO_DEPTH_WORDS    1024U	// C_TX_FIFO_DEPTH, C_RX_FIFO_DEPTH in lab3_fifo.xsa
+#define WORD_BYTES              4U
+
+/* Per-job timing seen on the AXI-Stream pins of the accelerator */
+struct SimJob {
+	uint64_t FirstIn;       // first S_AXIS beat accepted
+	uint64_t LastIn;        // S_AXIS beat with TLAST accepted
+	uint64_t FirstOut;      // first M_AXIS beat accepted
+	uint64_t LastOut;       // M_AXIS beat with TLAST accepted
+	uint32_t InBeats;
+	uint32_t OutBeats;
+};
+
+/* One accelerator with the data movers in front of it */
+class SimStream {
+public:
+	explicit SimStream(std::unique_ptr<AxisModel> Model);
+
+	// TX (towards S_AXIS). Queued beats are held back until released, the
+	// last released beat carries TLAST.
+	void TxPush(const AxisData &Data);
+	void TxRelease(uint32_t Beats, uint64_t NotBefore);
+	uint32_t TxQueued() const { return (uint32_t)Tx.size(); }
+	bool TxIdle() const { return Tx.empty(); }
+
+	// RX into a FIFO (AXI-Stream FIFO) or straight into memory (S2MM)
+	void RxToFifo(uint32_t Depth);
+	void RxToMemory(uint32_t *Destination, uint32_t Beats);
+	bool RxMemoryBusy() const { return RxBeatsLeft != 0; }
+	uint32_t RxOccupancy() const { return (uint32_t)RxFifo.size(); }
+	uint32_t RxPop();
+
+	// Drop everything in flight and reset the accelerator (ARESETN)
+	void Reset();
+
+	// Sticky completion flags, like the ISR bits of the AXI-Stream FIFO
+	bool TxComplete;
+	bool RxComplete;
+
+	void Tick(uint64_t Cycle);
+	const char *ModelName() const { return Model->Name(); }
+	uint32_t ReadRegister(uint32_t Offset) { return Model->ReadRegister(Offset); }
+	void WriteRegister(uint32_t Offset, uint32_t Value) { Model->WriteRegister(Offset, Value); }
+	const std::vector<SimJob> &Jobs() const { return Completed; }
+
+private:
+	struct Beat {
+		AxisData Data;
+		bool Last;
+	};
+
+	std::unique_ptr<AxisModel> Model;
+	AxisPins Pins;
+
+	std::deque<Beat> Tx;
+	uint32_t TxReleased;
+	uint64_t TxNotBefore;
+
+	bool RxIsFifo;
+	uint32_t RxFifoDepth;
+	std::deque<uint32_t> RxFifo;
+	uint32_t *RxDestination;
+	uint32_t RxBeatsLeft;
+
+	bool JobOpen;
+	SimJob Current;
+	std::vector<SimJob> Completed;
+};
+
+class SimPlatform {
+public:
+	static SimPlatform &Get();
+	~SimPlatform();
+
+	uint64_t Cycle() const { return Now; }
+	void Advance(uint64_t Cycles);
+	void RegisterAccess()
+	{
+		SyncCpuTime();
+		Advance(RegCycles);
+	}
+	// Charge the host CPU time since the last hardware access (MYIP_SIM_CPU_SCALE)
+	void SyncCpuTime();
+	// Forget the host time spent waiting for external input
+	void SkipCpuTime() { LastHost = std::chrono::steady_clock::now(); }
+	uint32_t DmaLatency() const { return DmaLatencyCycles; }
+
+	// One stream per AXI DMA instance (or the AXI-Stream FIFO), created on first use
+	SimStream &Stream(uint32_t Index = 0);
+
+private:
+	SimPlatform();
+	void Report() const;
+
+	uint64_t Now;
+	uint32_t RegCycles;
+	uint32_t DmaLatencyCycles;
+	double CpuScale;
+	std::chrono::steady_clock::time_point LastHost;
+	std::string JobsCsv;
+	uint32_t Loopback;
+	std::vector<std::unique_ptr<SimStream>> Streams;
+};
+
+#endif /* SIM_PLATFORM_H */
@@ -0,0 +1,108 @@
+/******************************************************************************
+* Host test of the SPSC ring used between the two cores of the AMP build
+* (lab3/srcs/dma/c/spsc_ring.h), with one pthread per side.
+*
+* Like the firmware, the producer fills a payload slot before pushing its
+* index and the consumer reads it before popping returns the slot, so a
+* missing acquire/release shows up as a corrupted payload. Build with
+*   g++ -O2 -pthread -Ilab3/srcs/sim/bsp -Ilab3/srcs/dma/c \
+*     lab3/srcs/sim/spsc_ring_test.cpp -o spsc_ring_test
+* and run with an optional message count (default 10000000).
+******************************************************************************/
+
+#include "spsc_ring.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <pthread.h>
+#include <sched.h>
+
+struct Payload {
+	u64 Sequence;
+	u64 Check;
+};
+
+static SpscRing Requests;
+static SpscRing Completions;
+static Payload Slots[SPSC_RING_ENTRIES];
+static u64 MessageCount = 10000000;
+static u64 Errors;
+
+/* Unlike the cores of the board, the threads may share a CPU */
+static void Wait()
+{
+	sched_yield();
+}
+
+static u64 CheckOf(u64 Sequence)
+{
+	return Sequence * 0x9E3779B97F4A7C15ULL;
+}
+
+/* The accelerator core: takes a slot, checks it, hands it back */
+static void *Consumer(void *)
+{
+	u32 Slot;
+
+	for (u64 i = 0; i < MessageCount; i++) {
+		while (!SpscRingPop(&Requests, &Slot)) {
+			Wait();
+		}
+		const Payload &P = Slots[Slot];
+		if (P.Sequence != i || P.Check != CheckOf(i)) {
+			Errors++;
+		}
+		while (!SpscRingPush(&Completions, Slot)) {
+			Wait();
+		}
+	}
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1) {
+		MessageCount = strtoull(argv[1], NULL, 0);
+	}
+	SpscRingInit(&Requests);
+	SpscRingInit(&Completions);
+
+	pthread_t Thread;
+	auto Start = std::chrono::steady_clock::now();
+	pthread_create(&Thread, NULL, Consumer, NULL);
+
+	// The UART core: fills slots round robin, reuses them as they come back
+	u64 Returned = 0;
+	u32 Slot;
+	for (u64 i = 0; i < MessageCount; i++) {
+		if (i - Returned == SPSC_RING_ENTRIES) {
+			while (!SpscRingPop(&Completions, &Slot)) {
+				Wait();
+			}
+			if (Slot != Returned % SPSC_RING_ENTRIES) {
+				Errors++;
+			}
+			Returned++;
+		}
+		Payload &P = Slots[i % SPSC_RING_ENTRIES];
+		P.Sequence = i;
+		P.Check = CheckOf(i);
+		if (!SpscRingPush(&Requests, (u32)(i % SPSC_RING_ENTRIES))) {
+			Errors++;
+		}
+	}
+	while (Returned < MessageCount) {
+		while (!SpscRingPop(&Completions, &Slot)) {
+			Wait();
+		}
+		Returned++;
+	}
+
+	pthread_join(Thread, NULL);
+	std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now() - Start;
+	printf("SPSC: %llu messages, %u entries, %.1f ns/round trip, %llu errors\n",
+		(unsigned long long)MessageCount, SPSC_RING_ENTRIES, Elapsed.count() * 1e9 / MessageCount,
+		(unsigned long long)Errors);
+	return Errors == 0 ? 0 : 1;
+}
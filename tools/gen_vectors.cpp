@@ -0,0 +1,344 @@
+/******************************************************************************
+* Seeded, deterministic generator of A/B/RES test records.
+*
+* Record k only depends on (seed, k), so any slice of a large run can be
+* regenerated with --first. Output formats:
+*   mem   test_input.mem / test_result_expected.mem for tb_myip_v1_0.sv,
+*         and with --p for tb_myip_systolic.sv
+*   csv   INPUT.csv (A rows then B, per job, as sent over the UART to
+*         ReceiveCSVData) and LABELS.csv (one result per line)
+*   csr   as csv, with every row of A as "k,c1,v1,...,ck,vk", its k
+*         non-zeros as (column, value) pairs, for the SPARSE_A firmware
+*   stream as csv, with B in front of the rows of A, for the STREAM_ROWS
+*         firmware
+*   bin   vectors.bin, see matbin.h ("-" writes it to stdout)
+*
+* --in reads the records from a matbin container instead of generating them,
+* with --first and --count selecting a slice (all of it by default) and the
+* dimensions taken from its header. The file is mapped, so slicing a large
+* corpus only touches the records written out.
+*
+* Build: g++ -O3 -std=c++17 -o gen_vectors tools/gen_vectors.cpp
+* --density keeps that percentage of the elements of A, the others are 0.
+* --p gives B that many columns (mem, csv, stream and bin formats): B is
+* written as n lines of p values and the results as m lines of p values, in
+* the mem format one value per line, row-major.
+*
+* Usage: gen_vectors [--m 64] [--n 8] [--p 1] [--count 1] [--first 0] [--seed 1]
+*                    [--max 255] [--density 100] [--format mem|csv|csr|stream|bin] [--out DIR|-]
+*                    [--in FILE.bin]
+******************************************************************************/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "matbin.h"
+
+struct Options {
+	uint32_t Rows = 64;
+	uint32_t Cols = 8;
+	uint32_t BCols = 1;
+	uint64_t Count = 1;
+	uint64_t First = 0;
+	uint64_t Seed = 1;
+	uint32_t MaxVal = 0xFF;
+	uint32_t Density = 100;
+	std::string Format = "csv";
+	std::string Out = ".";
+	std::string In;
+	bool CountSet = false;
+};
+
+/* Buffered writer, fwrite per 1 MB */
+class Writer {
+public:
+	explicit Writer(const std::string &Path) : Buffer(new char[BUFFER_BYTES]), Used(0)
+	{
+		File = Path == "-" ? stdout : fopen(Path.c_str(), "wb");
+		if (!File) {
+			fprintf(stderr, "Cannot open %s\n", Path.c_str());
+			exit(1);
+		}
+	}
+	~Writer()
+	{
+		Flush();
+		if (File != stdout) {
+			fclose(File);
+		}
+	}
+	void Put(const char *Data, size_t Length)
+	{
+		if (Used + Length > BUFFER_BYTES) {
+			Flush();
+		}
+		if (Length > BUFFER_BYTES) {
+			Write(Data, Length);
+			return;
+		}
+		memcpy(Buffer.get() + Used, Data, Length);
+		Used += Length;
+	}
+	void Put(const std::string &Text) { Put(Text.data(), Text.size()); }
+	void Put(char Char)
+	{
+		if (Used == BUFFER_BYTES) {
+			Flush();
+		}
+		Buffer[Used++] = Char;
+	}
+
+private:
+	static const size_t BUFFER_BYTES = 1 << 20;
+
+	void Write(const char *Data, size_t Length)
+	{
+		if (fwrite(Data, 1, Length, File) != Length) {
+			fprintf(stderr, "Write failed\n");
+			exit(1);
+		}
+	}
+	void Flush()
+	{
+		Write(Buffer.get(), Used);
+		Used = 0;
+	}
+
+	FILE *File;
+	std::unique_ptr<char[]> Buffer;
+	size_t Used;
+};
+
+/* "XX\n" and "ddd" lookup tables for all byte values */
+static char HexText[256][3];
+static char DecText[256][4];
+static uint8_t DecLength[256];
+
+static void InitTables()
+{
+	const char *Digits = "0123456789ABCDEF";
+	for (int v = 0; v < 256; v++) {
+		HexText[v][0] = Digits[v >> 4];
+		HexText[v][1] = Digits[v & 0xF];
+		HexText[v][2] = '\n';
+		DecLength[v] = (uint8_t)snprintf(DecText[v], sizeof(DecText[v]), "%d", v);
+	}
+}
+
+static uint64_t SplitMix64(uint64_t &State)
+{
+	uint64_t z = (State += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/* Fill A and B of record Index, then compute RES */
+static void GenerateRecord(const Options &Opt, uint64_t Index, uint8_t *Record)
+{
+	uint64_t State = Opt.Seed * 0xD1B54A32D192ED03ULL + Index;
+	uint32_t Inputs = Opt.Rows * Opt.Cols + Opt.Cols * Opt.BCols;
+	uint64_t Bits = 0;
+	for (uint32_t i = 0; i < Inputs; i++) {
+		if ((i & 7) == 0) {
+			Bits = SplitMix64(State);
+		}
+		uint32_t Byte = (uint32_t)(Bits & 0xFF);
+		Bits >>= 8;
+		Record[i] = (uint8_t)(Opt.MaxVal == 0xFF ? Byte : (Byte * (Opt.MaxVal + 1)) >> 8);
+	}
+	uint8_t *A = Record;
+	uint8_t *B = A + Opt.Rows * Opt.Cols;
+	if (Opt.Density < 100) {
+		// A separate stream, the values kept are the same as at full density
+		State = ~Opt.Seed * 0xD1B54A32D192ED03ULL + Index;
+		for (uint32_t i = 0; i < Opt.Rows * Opt.Cols; i++) {
+			if ((i & 7) == 0) {
+				Bits = SplitMix64(State);
+			}
+			if (((Bits & 0xFF) * 100) >> 8 >= Opt.Density) {
+				A[i] = 0;
+			}
+			Bits >>= 8;
+		}
+	}
+	MatBinGolden(A, B, B + Opt.Cols * Opt.BCols, Opt.Rows, Opt.Cols, Opt.BCols);
+}
+
+static void WriteMem(Writer &Input, Writer &Expected, const Options &Opt, uint64_t Index, const uint8_t *Record)
+{
+	std::string Label = std::to_string(Index + 1) + ")\n";
+	const uint8_t *B = Record + Opt.Rows * Opt.Cols;
+	const uint8_t *Res = B + Opt.Cols * Opt.BCols;
+
+	Input.Put("// first input vector (" + Label);
+	for (uint32_t i = 0; i < Opt.Rows * Opt.Cols; i++) {
+		Input.Put(HexText[Record[i]], 3);
+	}
+	Input.Put("// second input vector (" + Label);
+	for (uint32_t i = 0; i < Opt.Cols * Opt.BCols; i++) {
+		Input.Put(HexText[B[i]], 3);
+	}
+	Expected.Put("// output vector (" + Label);
+	for (uint32_t i = 0; i < Opt.Rows * Opt.BCols; i++) {
+		Expected.Put(HexText[Res[i]], 3);
+	}
+}
+
+/* Rows of Cols values, comma separated */
+static void WriteValues(Writer &Output, const uint8_t *Values, uint32_t Rows, uint32_t Cols)
+{
+	for (uint32_t i = 0; i < Rows * Cols; i++) {
+		Output.Put(DecText[Values[i]], DecLength[Values[i]]);
+		Output.Put((i + 1) % Cols != 0 ? ',' : '\n');
+	}
+}
+
+static void WriteCsv(Writer &Input, Writer &Labels, const Options &Opt, const uint8_t *Record)
+{
+	const uint8_t *B = Record + Opt.Rows * Opt.Cols;
+	const uint8_t *Res = B + Opt.Cols * Opt.BCols;
+
+	if (Opt.Format == "stream") {
+		WriteValues(Input, B, Opt.Cols, Opt.BCols);
+	}
+	for (uint32_t i = 0; i < Opt.Rows; i++) {
+		const uint8_t *Row = Record + i * Opt.Cols;
+		if (Opt.Format == "csr") {
+			uint32_t Count = 0;
+			for (uint32_t j = 0; j < Opt.Cols; j++) {
+				Count += Row[j] != 0;
+			}
+			Input.Put(std::to_string(Count));
+			for (uint32_t j = 0; j < Opt.Cols; j++) {
+				if (Row[j] != 0) {
+					Input.Put("," + std::to_string(j) + ",");
+					Input.Put(DecText[Row[j]], DecLength[Row[j]]);
+				}
+			}
+			Input.Put('\n');
+			continue;
+		}
+		WriteValues(Input, Row, 1, Opt.Cols);
+	}
+	if (Opt.Format != "stream") {
+		WriteValues(Input, B, Opt.Cols, Opt.BCols);
+	}
+	WriteValues(Labels, Res, Opt.Rows, Opt.BCols);
+}
+
+static void Usage()
+{
+	fprintf(stderr, "Usage: gen_vectors [--m 64] [--n 8] [--p 1] [--count 1] [--first 0] [--seed 1] [--max 255]\n"
+		"                   [--density 100] [--format mem|csv|csr|stream|bin] [--out DIR|-] [--in FILE.bin]\n");
+	exit(1);
+}
+
+static Options ParseOptions(int argc, char **argv)
+{
+	Options Opt;
+	for (int i = 1; i < argc; i++) {
+		if (i + 1 >= argc) {
+			Usage();
+		}
+		std::string Key = argv[i];
+		const char *Value = argv[++i];
+		if (Key == "--m") Opt.Rows = (uint32_t)strtoul(Value, NULL, 0);
+		else if (Key == "--n") Opt.Cols = (uint32_t)strtoul(Value, NULL, 0);
+		else if (Key == "--p") Opt.BCols = (uint32_t)strtoul(Value, NULL, 0);
+		else if (Key == "--count") {
+			Opt.Count = strtoull(Value, NULL, 0);
+			Opt.CountSet = true;
+		}
+		else if (Key == "--first") Opt.First = strtoull(Value, NULL, 0);
+		else if (Key == "--seed") Opt.Seed = strtoull(Value, NULL, 0);
+		else if (Key == "--max") Opt.MaxVal = (uint32_t)strtoul(Value, NULL, 0);
+		else if (Key == "--density") Opt.Density = (uint32_t)strtoul(Value, NULL, 0);
+		else if (Key == "--format") Opt.Format = Value;
+		else if (Key == "--out") Opt.Out = Value;
+		else if (Key == "--in") Opt.In = Value;
+		else Usage();
+	}
+	return Opt;
+}
+
+static void CheckOptions(const Options &Opt)
+{
+	if (Opt.Rows == 0 || Opt.Cols == 0 || Opt.BCols == 0 || MatBinRecordBytes(Opt.Rows, Opt.Cols, Opt.BCols) == 0
+		|| Opt.MaxVal > 0xFF || Opt.Density > 100
+		|| (Opt.BCols != 1 && Opt.Format == "csr")
+		|| (Opt.Format != "mem" && Opt.Format != "csv" && Opt.Format != "csr" && Opt.Format != "stream"
+			&& Opt.Format != "bin")
+		|| (Opt.Out == "-" && Opt.Format != "bin")) {
+		Usage();
+	}
+}
+
+int main(int argc, char **argv)
+{
+	Options Opt = ParseOptions(argc, argv);
+	MatBinFile Source;
+	if (!Opt.In.empty()) {
+		std::string Error;
+		if (!Source.Open(Opt.In, Error)) {
+			fprintf(stderr, "%s\n", Error.c_str());
+			return 1;
+		}
+		Opt.Rows = Source.Rows();
+		Opt.Cols = Source.Cols();
+		Opt.BCols = Source.BCols();
+		if (Opt.First > Source.Count() || (Opt.CountSet && Opt.Count > Source.Count() - Opt.First)) {
+			fprintf(stderr, "%s holds %llu records\n", Opt.In.c_str(), (unsigned long long)Source.Count());
+			return 1;
+		}
+		if (!Opt.CountSet) {
+			Opt.Count = Source.Count() - Opt.First;
+		}
+	}
+	CheckOptions(Opt);
+	InitTables();
+
+	MatBinHeader Header = MatBinMakeHeader(Opt.Rows, Opt.Cols, Opt.Count, Opt.BCols);
+	std::vector<uint8_t> Record(MatBinRecordBytes(Opt.Rows, Opt.Cols, Opt.BCols));
+	// Record Index, in place in the container or generated into Record
+	auto Next = [&](uint64_t Index) -> const uint8_t * {
+		if (!Opt.In.empty()) {
+			return Source.Record(Index);
+		}
+		GenerateRecord(Opt, Index, Record.data());
+		return Record.data();
+	};
+	std::string Dir = Opt.Out + "/";
+	auto Start = std::chrono::steady_clock::now();
+
+	if (Opt.Format == "mem") {
+		Writer Input(Dir + "test_input.mem"), Expected(Dir + "test_result_expected.mem");
+		for (uint64_t k = 0; k < Opt.Count; k++) {
+			WriteMem(Input, Expected, Opt, Opt.First + k, Next(Opt.First + k));
+		}
+	}
+	else if (Opt.Format == "csv" || Opt.Format == "csr" || Opt.Format == "stream") {
+		Writer Input(Dir + "INPUT.csv"), Labels(Dir + "LABELS.csv");
+		for (uint64_t k = 0; k < Opt.Count; k++) {
+			WriteCsv(Input, Labels, Opt, Next(Opt.First + k));
+		}
+	}
+	else {
+		Writer Bin(Opt.Out == "-" ? std::string("-") : Dir + "vectors.bin");
+		Bin.Put((const char *)&Header, sizeof(Header));
+		for (uint64_t k = 0; k < Opt.Count; k++) {
+			Bin.Put((const char *)Next(Opt.First + k), Record.size());
+		}
+	}
+
+	double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	fprintf(stderr, "%s %llu %ux%u records in %.2f s (%.0f records/s)\n", Opt.In.empty() ? "Generated" : "Converted",
+		(unsigned long long)Opt.Count, Opt.Rows, Opt.Cols, Seconds, Opt.Count / (Seconds > 0 ? Seconds : 1e-9));
+	return 0;
+}
@@ -0,0 +1,288 @@
+/******************************************************************************
+* Converter and checker for matbin containers (see matbin.h).
+*
+*   info FILE.bin
+*         header fields and the size of the corpus
+*   import-csv --m M --n N [--p P] INPUT.csv LABELS.csv OUT.bin
+*         the UART files of a run (gen_vectors --format csv or hand written)
+*   import-mem --m M --n N [--p P] test_input.mem test_result_expected.mem OUT.bin
+*         the files of tb_myip_v1_0.sv (tb_myip_systolic.sv with --p), hex bytes
+*         with // comment lines
+*   check [--first 0] [--count all] [--allow-dropped] FILE.bin [OUTPUT|-]
+*         compares the result lines of a firmware run (the UART output, STATS:
+*         and other lines not starting with a digit are skipped) with the
+*         golden results of the records, exits with 1 on a difference. An
+*         ERROR line stands for a row of a dropped job (lab3_dma.h, ERROR_ROW),
+*         its record is counted as dropped, and only fails the check without
+*         --allow-dropped
+*
+* The imports recompute every result with MatBinGolden and report the records
+* whose labels disagree, the labels are stored as given.
+* To slice a container back into csv/mem/csr/stream files use gen_vectors --in.
+*
+* Build: g++ -O3 -std=c++17 -o matbin tools/matbin.cpp
+******************************************************************************/
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "matbin.h"
+
+static void Usage()
+{
+	fprintf(stderr, "Usage: matbin info FILE.bin\n"
+		"       matbin import-csv --m M --n N [--p 1] INPUT.csv LABELS.csv OUT.bin\n"
+		"       matbin import-mem --m M --n N [--p 1] test_input.mem test_result_expected.mem OUT.bin\n"
+		"       matbin check [--first 0] [--count all] [--allow-dropped] FILE.bin [OUTPUT|-]\n");
+	exit(1);
+}
+
+static bool ReadText(const std::string &Path, std::string &Text)
+{
+	std::ifstream File(Path, std::ios::binary);
+	if (!File) {
+		fprintf(stderr, "Cannot open %s\n", Path.c_str());
+		return false;
+	}
+	std::stringstream Buffer;
+	Buffer << File.rdbuf();
+	Text = Buffer.str();
+	return true;
+}
+
+/* Decimal values separated by anything else, up to the first word (TERMINATE) */
+static std::vector<uint8_t> ParseDecimal(const std::string &Text)
+{
+	std::vector<uint8_t> Values;
+	size_t i = 0;
+	while (i < Text.size()) {
+		if (isalpha((unsigned char)Text[i])) {
+			break;
+		}
+		if (!isdigit((unsigned char)Text[i])) {
+			i++;
+			continue;
+		}
+		uint32_t Value = 0;
+		while (i < Text.size() && isdigit((unsigned char)Text[i])) {
+			Value = Value * 10 + (Text[i++] - '0');
+		}
+		Values.push_back((uint8_t)Value);
+	}
+	return Values;
+}
+
+/* One hex value per line, // comments and blank lines skipped, as $readmemh takes them */
+static std::vector<uint8_t> ParseHex(const std::string &Text)
+{
+	std::vector<uint8_t> Values;
+	std::istringstream Lines(Text);
+	std::string Line;
+	while (std::getline(Lines, Line)) {
+		Line = Line.substr(0, Line.find("//"));
+		const char *Start = Line.c_str();
+		while (isspace((unsigned char)*Start)) {
+			Start++;
+		}
+		if (*Start) {
+			Values.push_back((uint8_t)strtoul(Start, NULL, 16));
+		}
+	}
+	return Values;
+}
+
+/* Records from the inputs and labels of Count jobs, and the write of OUT.bin */
+static int WriteContainer(const std::string &Path, uint32_t Rows, uint32_t Cols, uint32_t BCols,
+	const std::vector<uint8_t> &Inputs, const std::vector<uint8_t> &Labels)
+{
+	if (MatBinRecordBytes(Rows, Cols, BCols) == 0) {
+		fprintf(stderr, "%ux%u (p %u) records do not fit a container\n", Rows, Cols, BCols);
+		return 1;
+	}
+	uint64_t InputBytes = (uint64_t)Rows * Cols + (uint64_t)Cols * BCols;
+	uint64_t LabelBytes = (uint64_t)Rows * BCols;
+	uint64_t Count = Inputs.size() / InputBytes;
+	if (Inputs.size() % InputBytes != 0 || Labels.size() != Count * LabelBytes) {
+		fprintf(stderr, "%zu input and %zu label values do not make whole %ux%u (p %u) jobs\n",
+			Inputs.size(), Labels.size(), Rows, Cols, BCols);
+		return 1;
+	}
+
+	FILE *File = fopen(Path.c_str(), "wb");
+	if (!File) {
+		fprintf(stderr, "Cannot open %s\n", Path.c_str());
+		return 1;
+	}
+	MatBinHeader Header = MatBinMakeHeader(Rows, Cols, Count, BCols);
+	std::vector<uint8_t> Golden(LabelBytes);
+	uint64_t Wrong = 0;
+	bool Ok = fwrite(&Header, sizeof(Header), 1, File) == 1;
+	for (uint64_t k = 0; k < Count && Ok; k++) {
+		const uint8_t *Input = Inputs.data() + k * InputBytes;
+		const uint8_t *Label = Labels.data() + k * LabelBytes;
+		MatBinGolden(Input, Input + Rows * Cols, Golden.data(), Rows, Cols, BCols);
+		if (memcmp(Golden.data(), Label, LabelBytes) != 0) {
+			if (Wrong++ < 10) {
+				fprintf(stderr, "Record %llu: the labels are not the golden results\n", (unsigned long long)k);
+			}
+		}
+		Ok = fwrite(Input, 1, InputBytes, File) == InputBytes && fwrite(Label, 1, LabelBytes, File) == LabelBytes;
+	}
+	if (fclose(File) != 0 || !Ok) {
+		fprintf(stderr, "Write of %s failed\n", Path.c_str());
+		return 1;
+	}
+	fprintf(stderr, "Wrote %llu %ux%u records to %s, %llu with labels other than the golden results\n",
+		(unsigned long long)Count, Rows, Cols, Path.c_str(), (unsigned long long)Wrong);
+	return 0;
+}
+
+static int Info(const std::string &Path)
+{
+	MatBinFile File;
+	std::string Error;
+	if (!File.Open(Path, Error)) {
+		fprintf(stderr, "%s\n", Error.c_str());
+		return 1;
+	}
+	printf("%s: %llu records of A %ux%u, B %ux%u, RES %ux%u, %u bytes each, %llu bytes of records\n",
+		Path.c_str(), (unsigned long long)File.Count(), File.Rows(), File.Cols(), File.Cols(), File.BCols(),
+		File.Rows(), File.BCols(), File.RecordBytes(), (unsigned long long)(File.Count() * (uint64_t)File.RecordBytes()));
+	return 0;
+}
+
+static int Check(const std::string &Path, const std::string &OutputPath, uint64_t First, uint64_t Count, bool CountSet,
+	bool AllowDropped)
+{
+	MatBinFile File;
+	std::string Error;
+	if (!File.Open(Path, Error)) {
+		fprintf(stderr, "%s\n", Error.c_str());
+		return 1;
+	}
+	if (First > File.Count() || (CountSet && Count > File.Count() - First)) {
+		fprintf(stderr, "%s holds %llu records\n", Path.c_str(), (unsigned long long)File.Count());
+		return 1;
+	}
+	if (!CountSet) {
+		Count = File.Count() - First;
+	}
+
+	std::string Text;
+	if (OutputPath == "-") {
+		std::stringstream Buffer;
+		Buffer << std::cin.rdbuf();
+		Text = Buffer.str();
+	}
+	else if (!ReadText(OutputPath, Text)) {
+		return 1;
+	}
+
+	// Result lines only, m of them per job, each p values, or an ERROR line for a row of p
+	std::istringstream Lines(Text);
+	std::string Line;
+	std::vector<uint8_t> Results;
+	std::vector<bool> Missing;
+	while (std::getline(Lines, Line)) {
+		if (!Line.empty() && isdigit((unsigned char)Line[0])) {
+			std::vector<uint8_t> Values = ParseDecimal(Line);
+			Results.insert(Results.end(), Values.begin(), Values.end());
+			Missing.insert(Missing.end(), Values.size(), false);
+		}
+		else if (Line.compare(0, 5, "ERROR") == 0) {
+			Results.insert(Results.end(), File.BCols(), 0);
+			Missing.insert(Missing.end(), File.BCols(), true);
+		}
+	}
+
+	uint64_t LabelBytes = (uint64_t)File.Rows() * File.BCols();
+	uint64_t Wrong = 0, Dropped = 0;
+	for (uint64_t k = 0; k < Count; k++) {
+		const uint8_t *Res = File.Res(First + k);
+		size_t Offset = k * LabelBytes;
+		if (Offset + LabelBytes <= Results.size()
+				&& std::find(Missing.begin() + Offset, Missing.begin() + Offset + LabelBytes, true)
+					!= Missing.begin() + Offset + LabelBytes) {
+			if (Dropped++ < 10) {
+				fprintf(stderr, "Record %llu: DROPPED\n", (unsigned long long)(First + k));
+			}
+		}
+		else if (Offset + LabelBytes > Results.size() || memcmp(Results.data() + Offset, Res, LabelBytes) != 0) {
+			if (Wrong++ < 10) {
+				fprintf(stderr, "Record %llu: DIFF\n", (unsigned long long)(First + k));
+			}
+		}
+	}
+	if (Results.size() != Count * LabelBytes) {
+		fprintf(stderr, "%zu result values for %llu records of %llu\n", Results.size(), (unsigned long long)Count,
+			(unsigned long long)LabelBytes);
+	}
+	bool Match = Wrong == 0 && (Dropped == 0 || AllowDropped) && Results.size() == Count * LabelBytes;
+	printf("%s: %llu of %llu records, %llu dropped\n", Match ? "MATCH" : "DIFF",
+		(unsigned long long)(Count - Wrong - Dropped), (unsigned long long)Count, (unsigned long long)Dropped);
+	return Match ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) {
+		Usage();
+	}
+	std::string Command = argv[1];
+	uint32_t Rows = 0, Cols = 0, BCols = 1;
+	uint64_t First = 0, Count = 0;
+	bool CountSet = false, AllowDropped = false;
+	std::vector<std::string> Paths;
+	for (int i = 2; i < argc; i++) {
+		std::string Key = argv[i];
+		if (Key == "--allow-dropped") {
+			AllowDropped = true;
+		}
+		else if (Key.size() > 2 && Key.compare(0, 2, "--") == 0) {
+			if (i + 1 >= argc) {
+				Usage();
+			}
+			const char *Value = argv[++i];
+			if (Key == "--m") Rows = (uint32_t)strtoul(Value, NULL, 0);
+			else if (Key == "--n") Cols = (uint32_t)strtoul(Value, NULL, 0);
+			else if (Key == "--p") BCols = (uint32_t)strtoul(Value, NULL, 0);
+			else if (Key == "--first") First = strtoull(Value, NULL, 0);
+			else if (Key == "--count") {
+				Count = strtoull(Value, NULL, 0);
+				CountSet = true;
+			}
+			else Usage();
+		}
+		else {
+			Paths.push_back(Key);
+		}
+	}
+
+	if (Command == "info" && Paths.size() == 1) {
+		return Info(Paths[0]);
+	}
+	if (Command == "check" && (Paths.size() == 1 || Paths.size() == 2)) {
+		return Check(Paths[0], Paths.size() == 2 ? Paths[1] : "-", First, Count, CountSet, AllowDropped);
+	}
+	if ((Command == "import-csv" || Command == "import-mem") && Paths.size() == 3 && Rows && Cols && BCols) {
+		std::string InputText, LabelText;
+		if (!ReadText(Paths[0], InputText) || !ReadText(Paths[1], LabelText)) {
+			return 1;
+		}
+		if (Command == "import-csv") {
+			return WriteContainer(Paths[2], Rows, Cols, BCols, ParseDecimal(InputText), ParseDecimal(LabelText));
+		}
+		return WriteContainer(Paths[2], Rows, Cols, BCols, ParseHex(InputText), ParseHex(LabelText));
+	}
+	Usage();
+	return 1;
+}
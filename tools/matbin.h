@@ -0,0 +1,173 @@
+/******************************************************************************
+* Compact binary format for matrix test records.
+*
+* A 32-byte header followed by Count records of RecordBytes bytes each:
+*   A   Rows*Cols u8, row-major
+*   B   Cols*BCols u8, row-major
+*   RES Rows*BCols u8, the golden result ((sum of (A*B) >> 8) & 0xFF)
+* All header fields are little-endian. Version 1 had no BCols (the field was
+* reserved and 0), it is read as BCols = 1.
+*
+* MatBinFile maps a file read-only and hands out pointers straight into the
+* mapping, so opening a corpus of any size costs one mmap and the pages are
+* only read when a record is touched. Written by gen_vectors --format bin and
+* matbin import-csv / import-mem, read by gen_vectors --in and matbin check.
+******************************************************************************/
+
+#ifndef MATBIN_H
+#define MATBIN_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MATBIN_MAGIC        "MBIN"
+#define MATBIN_VERSION      2
+#define MATBIN_DTYPE_U8     1
+
+struct MatBinHeader {
+	char     Magic[4];
+	uint16_t Version;
+	uint16_t Dtype;
+	uint32_t Rows;
+	uint32_t Cols;
+	uint64_t Count;
+	uint32_t RecordBytes;
+	uint32_t BCols;         // 0 in version 1, read as 1
+};
+static_assert(sizeof(MatBinHeader) == 32, "MatBinHeader must stay 32 bytes");
+
+/* Bytes of one record, worked out in 64 bits. 0 when the record does not fit the
+ * 32-bit RecordBytes field, so every product of two dimensions fits a uint32_t */
+inline uint64_t MatBinRecordBytes(uint32_t Rows, uint32_t Cols, uint32_t BCols)
+{
+	uint64_t ABytes = (uint64_t)Rows * Cols;
+	uint64_t BBytes = (uint64_t)Cols * BCols;
+	uint64_t ResBytes = (uint64_t)Rows * BCols;
+	if (ABytes > UINT32_MAX || BBytes > UINT32_MAX || ResBytes > UINT32_MAX
+		|| ABytes + BBytes + ResBytes > UINT32_MAX) {
+		return 0;
+	}
+	return ABytes + BBytes + ResBytes;
+}
+
+inline MatBinHeader MatBinMakeHeader(uint32_t Rows, uint32_t Cols, uint64_t Count, uint32_t BCols = 1)
+{
+	MatBinHeader Header;
+	memcpy(Header.Magic, MATBIN_MAGIC, 4);
+	Header.Version = MATBIN_VERSION;
+	Header.Dtype = MATBIN_DTYPE_U8;
+	Header.Rows = Rows;
+	Header.Cols = Cols;
+	Header.Count = Count;
+	Header.RecordBytes = (uint32_t)MatBinRecordBytes(Rows, Cols, BCols);   // 0 flags dimensions too large
+	Header.BCols = BCols;
+	return Header;
+}
+
+/* The arithmetic contract of performMatrixMultiplication and matrix_multiply.sv.
+ * B has BCols columns, row-major, and so has Res (myip_systolic_v1_0) */
+inline void MatBinGolden(const uint8_t *A, const uint8_t *B, uint8_t *Res, uint32_t Rows, uint32_t Cols,
+	uint32_t BCols = 1)
+{
+	for (uint32_t i = 0; i < Rows; i++) {
+		for (uint32_t j = 0; j < BCols; j++) {
+			uint32_t Acc = 0;
+			for (uint32_t k = 0; k < Cols; k++) {
+				Acc += ((uint32_t)A[i * Cols + k] * B[k * BCols + j]) >> 8;
+			}
+			Res[i * BCols + j] = (uint8_t)(Acc & 0xFF);
+		}
+	}
+}
+
+/* Read-only mapping of a container, records addressed in place */
+class MatBinFile {
+public:
+	MatBinFile() : Map(NULL), MapBytes(0), Header() {}
+	~MatBinFile() { Close(); }
+	MatBinFile(const MatBinFile &) = delete;
+	MatBinFile &operator=(const MatBinFile &) = delete;
+
+	/* false with the reason in Error when the file is missing, truncated or not a container */
+	bool Open(const std::string &Path, std::string &Error)
+	{
+		Close();
+		int Fd = open(Path.c_str(), O_RDONLY);
+		if (Fd < 0) {
+			Error = "cannot open " + Path;
+			return false;
+		}
+		struct stat Info;
+		if (fstat(Fd, &Info) != 0 || (uint64_t)Info.st_size < sizeof(MatBinHeader)) {
+			close(Fd);
+			Error = Path + " is shorter than a header";
+			return false;
+		}
+		MapBytes = (uint64_t)Info.st_size;
+		void *Mapping = mmap(NULL, MapBytes, PROT_READ, MAP_PRIVATE, Fd, 0);
+		close(Fd);
+		if (Mapping == MAP_FAILED) {
+			MapBytes = 0;
+			Error = "cannot map " + Path;
+			return false;
+		}
+		Map = (const uint8_t *)Mapping;
+		memcpy(&Header, Map, sizeof(Header));
+
+		if (memcmp(Header.Magic, MATBIN_MAGIC, 4) != 0) {
+			Error = Path + " is not a matbin file";
+		}
+		else if (Header.Version < 1 || Header.Version > MATBIN_VERSION) {
+			Error = Path + " has version " + std::to_string(Header.Version);
+		}
+		else if (Header.Dtype != MATBIN_DTYPE_U8) {
+			Error = Path + " has dtype " + std::to_string(Header.Dtype);
+		}
+		else if (Header.RecordBytes == 0 || Header.RecordBytes != MatBinRecordBytes(Header.Rows, Header.Cols, BCols())) {
+			Error = Path + " has records of " + std::to_string(Header.RecordBytes) + " bytes for its dimensions";
+		}
+		// Divided rather than Count * RecordBytes, which a forged Count can wrap
+		else if ((MapBytes - sizeof(MatBinHeader)) / Header.RecordBytes < Header.Count) {
+			Error = Path + " is truncated";
+		}
+		else {
+			madvise(Mapping, MapBytes, MADV_SEQUENTIAL);
+			return true;
+		}
+		Close();
+		return false;
+	}
+
+	void Close()
+	{
+		if (Map) {
+			munmap((void *)Map, MapBytes);
+		}
+		Map = NULL;
+		MapBytes = 0;
+	}
+
+	uint32_t Rows() const { return Header.Rows; }
+	uint32_t Cols() const { return Header.Cols; }
+	uint32_t BCols() const { return Header.Version < 2 || Header.BCols == 0 ? 1 : Header.BCols; }
+	uint64_t Count() const { return Header.Count; }
+	uint32_t RecordBytes() const { return Header.RecordBytes; }
+
+	const uint8_t *Record(uint64_t Index) const { return Map + sizeof(MatBinHeader) + Index * Header.RecordBytes; }
+	const uint8_t *A(uint64_t Index) const { return Record(Index); }
+	const uint8_t *B(uint64_t Index) const { return Record(Index) + (uint64_t)Header.Rows * Header.Cols; }
+	const uint8_t *Res(uint64_t Index) const { return B(Index) + (uint64_t)Header.Cols * BCols(); }
+
+private:
+	const uint8_t *Map;
+	uint64_t MapBytes;
+	MatBinHeader Header;
+};
+
+#endif /* MATBIN_H */